@@ -16,16 +16,15 @@
 #include <string>
 #include <vector>
 #include <algorithm>
-#include <fstream>
+#include <memory>
 #include <mutex>
 #include <sstream>      // For wstringstream
-#include <iomanip>      // For std::setw
-#include <regex>        // For std::wregex
-#include "nlohmann/json.hpp"     // For nlohmann/json library via submodule
 #include "resource.h"
-#include <queue>
-#include <stack>
-#include <memory>
+#include "engine/ClipboardEngine.h"  // Platform-neutral classification & materialization
+#include "engine/CoalescingQueue.h"
+#include "engine/PayloadCache.h"
+#include "engine/Platform.h"
+#include "engine/SettingsFile.h"     // config.json, through nlohmann/json from libs/
 
 
 //------------------------------------------------------------------------------------------------//
@@ -47,6 +46,7 @@
 #define WM_TRAY_ICON_MSG            (WM_USER + 1)   // Message for tray icon events
 #define WM_APP_RELOAD_CONFIG        (WM_USER + 2)   // Message from watcher thread to trigger reload
 #define WM_APP_UPDATE_FOUND         (WM_USER + 3)   // Message for application updates
+#define WM_APP_SHOW_TOAST           (WM_USER + 4)   // Toast from the clipboard worker (lParam: ToastMessage*)
 #define ID_TRAY_ICON                1
 #define ID_MENU_TOGGLE_EMPTY        1001
 #define ID_MENU_TOGGLE_CONTENT      1002
@@ -62,64 +62,38 @@ HWND  g_hMainWnd = NULL;
 HWND  g_hNextClipboardViewer = NULL;
 HANDLE g_hWatcherThread = NULL;
 HANDLE g_hShutdownEvent = NULL;
-std::vector<std::wregex> g_compiledRegexes;
-std::mutex g_extensionsMutex;
-
-bool g_bComInitialized = false;  // Track COM initialization state
+HANDLE g_hClipboardWorker = NULL;
+DWORD g_clipboardWorkerId = 0;
+HANDLE g_hClipboardEvent = NULL;    // Auto-reset; set when g_clipboardQueue has a new item
 
-// Struct to hold both pattern and compiled regex for efficient reuse
-struct CompiledRegex {
-    std::wstring pattern;
-    std::wregex compiled;
-    bool isValid;
+bool g_bComInitialized = false;             // COM on the UI thread (WM_CREATE / WM_DESTROY only)
+thread_local bool t_comInitialized = false; // COM on the calling thread, for GetSingleExplorerPath
 
-    CompiledRegex() : isValid(false) {}
-    CompiledRegex(const std::wstring& pat) : pattern(pat), isValid(false) {
-        try {
-            compiled = std::wregex(pattern, std::regex::ECMAScript | std::regex::icase);
-            isValid = true;
-        }
-        catch (const std::regex_error&) {
-            isValid = false;
-        }
-    }
-};
-
-struct AppSettings {
-    bool isCreateEmptyFileEnabled = true;
-    bool isCreateWithContentEnabled = true;
-    bool isCreateDirectoryStructureEnabled = true;
-    std::vector<std::wstring> allowedExtensions;
-    std::vector<std::wstring> contentCreationRegexes;
-    int heuristicWordCountLimit = 5;
-    bool createEmptyDirectories = true;
-    bool skipExistingDirectories = true;
-};
+// Settings writers (menu toggles, LoadSettings) serialize on g_extensionsMutex, edit g_settings and
+// publish a new immutable snapshot. Readers only load g_engineSettings (std::atomic_load) and keep
+// their snapshot alive for as long as they use it, so clipboard events never take the mutex.
+std::mutex g_extensionsMutex;
 AppSettings g_settings;
+std::shared_ptr<const EngineSettings> g_engineSettings;
 
-// Enum for file conflict resolution actions
-enum class FileConflictAction {
-    Replace,
-    Skip,
-    Rename
+// One clipboard update, snapshotted on the UI thread and handled by ClipboardWorkerThread.
+struct ClipboardEvent {
+    std::wstring text;
+    std::shared_ptr<const EngineSettings> settings;
 };
 
-struct TreeNode {
-    std::wstring name;
-    bool isDirectory;
-    std::wstring content;  // For enhanced format with file contents
-    std::vector<std::unique_ptr<TreeNode>> children;
-
-    TreeNode(const std::wstring& n, bool isDir = false) : name(n), isDirectory(isDir) {}
+// A toast the worker asks the UI thread to show.
+struct ToastMessage {
+    std::wstring title;
+    std::wstring message;
+    DWORD iconType;
 };
 
-enum class TreeFormat {
-    Unknown,
-    TreeCommand,      // Uses ├── └── characters
-    Indentation,      // Uses spaces/tabs
-    PathList,         // Full paths like path/to/file.txt
-    Enhanced          // With file content markers
-};
+const DWORD kBurstSettleMs = 30;     // Worker waits this long after a wake-up so a burst collapses
+
+DWORD g_lastClipboardSequence = 0;   // GetClipboardSequenceNumber of the last update (UI thread)
+CoalescingQueue<ClipboardEvent> g_clipboardQueue;
+PayloadCache g_payloadCache;         // Worker thread only
 
 
 //------------------------------------------------------------------------------------------------//
@@ -130,36 +104,30 @@ void CreateTrayIcon(HWND);
 void RemoveTrayIcon(HWND);
 void ShowContextMenu(HWND);
 void ShowToastNotification(HWND, const std::wstring&, const std::wstring&, DWORD);
+void PostToastNotification(const std::wstring&, const std::wstring&, DWORD);
 std::wstring GetConfigFilePath();
 std::wstring GetSingleExplorerPath();
 void ProcessClipboardChange();
+void HandleClipboardEvent(const ClipboardEvent& event);
 DWORD WINAPI FileWatcherThread(LPVOID);
+DWORD WINAPI ClipboardWorkerThread(LPVOID);
+bool IsShuttingDown();
+int ShowWorkerMessageBox(const std::wstring&, const wchar_t*, UINT);
+void DismissWorkerDialogs();
 void LoadSettings();
 void SaveSettings();
 bool IsStartupEnabled();
 void SetStartup(bool);
 void CheckForUpdatesIfNeeded();
-bool TryFileGeneration(const std::wstring&);
-int CountWords(const std::wstring&);
 struct AppVersion { int major = 0, minor = 0, patch = 0, build = 0; };
 AppVersion GetCurrentAppVersion();
 AppVersion ParseVersionString(const std::wstring&);
 FileConflictAction ShowFileConflictDialog(const std::wstring&);
-std::wstring GenerateUniqueFilename(const std::wstring&);
-bool CreateFileWithContentAtomic(const std::wstring&, const std::wstring&);
-bool CreateEmptyFileAtomic(const std::wstring&);
-bool IsValidFilename(const std::wstring&);
-std::vector<std::wstring> FindAdditionalFilenames(const std::wstring&, size_t);
-bool TryDirectoryStructureCreation(const std::wstring& clipboardText);
-TreeFormat DetectTreeFormat(const std::wstring& text);
-std::unique_ptr<TreeNode> ParseTreeStructure(const std::wstring& text, TreeFormat format);
-std::unique_ptr<TreeNode> ParseTreeCommandFormat(const std::vector<std::wstring>& lines);
-std::unique_ptr<TreeNode> ParseIndentationFormat(const std::vector<std::wstring>& lines);
-std::unique_ptr<TreeNode> ParsePathListFormat(const std::vector<std::wstring>& lines);
-std::unique_ptr<TreeNode> ParseEnhancedFormat(const std::vector<std::wstring>& lines);
-bool CreateDirectoryStructure(const TreeNode* root, const std::wstring& basePath);
-bool IsPathSafe(const std::wstring& path);
-void GetTreeSummary(const TreeNode* node, int& dirCount, int& fileCount);
+FileConflictAction ShowBatchConflictDialog(const std::vector<std::wstring>&);
+std::shared_ptr<const EngineSettings> CaptureEngineSettings();
+void PublishEngineSettings();
+bool TryFileGeneration(const FileGenerationPlan& plan, const EngineSettings& settings, bool& created);
+bool TryDirectoryStructureCreation(const DirectoryStructurePlan& plan, const EngineSettings& settings, bool& created);
 
 
 //------------------------------------------------------------------------------------------------//
@@ -209,6 +177,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         CreateTrayIcon(hwnd);
         g_hShutdownEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
         g_hWatcherThread = CreateThread(NULL, 0, FileWatcherThread, NULL, 0, NULL);
+        g_hClipboardEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+        g_hClipboardWorker = CreateThread(NULL, 0, ClipboardWorkerThread, NULL, 0, &g_clipboardWorkerId);
         CheckForUpdatesIfNeeded();
         break;
     case WM_DESTROY:
@@ -218,7 +188,19 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             WaitForSingleObject(g_hWatcherThread, 2000);
             CloseHandle(g_hWatcherThread);
         }
+        if (g_hClipboardWorker) {
+            // The worker may be waiting on a confirmation or creating files. Answer its dialogs
+            // (again and again, in case it opens one after a pass); a structure being created
+            // sees the shutdown event before its next entry and stops there, so the worker is
+            // never killed halfway through a file or a stage directory.
+            while (WaitForSingleObject(g_hClipboardWorker, 100) == WAIT_TIMEOUT) {
+                DismissWorkerDialogs();
+            }
+            CloseHandle(g_hClipboardWorker);
+        }
+        // Both threads have exited; nothing waits on these any more
         if (g_hShutdownEvent) CloseHandle(g_hShutdownEvent);
+        if (g_hClipboardEvent) CloseHandle(g_hClipboardEvent);
 
         // Clean up any pending WM_APP_UPDATE_FOUND messages to prevent memory leaks
         MSG pendingMsg;
@@ -228,6 +210,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                 delete[] releaseUrl; // Free the memory allocated by PerformUpdateCheck
             }
         }
+        while (PeekMessageW(&pendingMsg, hwnd, WM_APP_SHOW_TOAST, WM_APP_SHOW_TOAST, PM_REMOVE)) {
+            delete reinterpret_cast<ToastMessage*>(pendingMsg.lParam);
+        }
 
         // Remove modern clipboard listener (no chain management needed)
         RemoveClipboardFormatListener(hwnd);
@@ -245,6 +230,14 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
         // No message forwarding needed with modern API - each listener gets direct notification
         break;
+    case WM_APP_SHOW_TOAST: {
+        ToastMessage* toast = reinterpret_cast<ToastMessage*>(lParam);
+        if (toast) {
+            ShowToastNotification(hwnd, toast->title, toast->message, toast->iconType);
+            delete toast; // Allocated by PostToastNotification on the worker thread.
+        }
+        break;
+    }
     case WM_APP_RELOAD_CONFIG:
         // Handles the reload request from our file watcher thread.
         Sleep(100); // Small delay to prevent race conditions with text editors.
@@ -268,20 +261,29 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     case WM_COMMAND:
         switch (LOWORD(wParam)) {
         case ID_MENU_TOGGLE_EMPTY: {
-            std::lock_guard<std::mutex> lock(g_extensionsMutex);
-            g_settings.isCreateEmptyFileEnabled = !g_settings.isCreateEmptyFileEnabled;
+            {
+                std::lock_guard<std::mutex> lock(g_extensionsMutex);
+                g_settings.isCreateEmptyFileEnabled = !g_settings.isCreateEmptyFileEnabled;
+                PublishEngineSettings();
+            }
             SaveSettings();
             break;
         }
         case ID_MENU_TOGGLE_CONTENT: {
-            std::lock_guard<std::mutex> lock(g_extensionsMutex);
-            g_settings.isCreateWithContentEnabled = !g_settings.isCreateWithContentEnabled;
+            {
+                std::lock_guard<std::mutex> lock(g_extensionsMutex);
+                g_settings.isCreateWithContentEnabled = !g_settings.isCreateWithContentEnabled;
+                PublishEngineSettings();
+            }
             SaveSettings();
             break;
         }
         case ID_MENU_TOGGLE_DIRECTORY: {
-            std::lock_guard<std::mutex> lock(g_extensionsMutex);
-            g_settings.isCreateDirectoryStructureEnabled = !g_settings.isCreateDirectoryStructureEnabled;
+            {
+                std::lock_guard<std::mutex> lock(g_extensionsMutex);
+                g_settings.isCreateDirectoryStructureEnabled = !g_settings.isCreateDirectoryStructureEnabled;
+                PublishEngineSettings();
+            }
             SaveSettings();
             break;
         }
@@ -309,24 +311,6 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 //------------------------------------------------------------------------------------------------//
 //                            CONFIGURATION & SETTINGS MANAGEMENT                                 //
 //------------------------------------------------------------------------------------------------//
-// Helper function to convert a UTF-8 std::string (from JSON library) to a std::wstring (for Win32 API).
-std::wstring Utf8ToWstring(const std::string& str) {
-    if (str.empty()) return std::wstring();
-    int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-    std::wstring wstrTo(size_needed, 0);
-    MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
-    return wstrTo;
-}
-
-// Helper function to convert a std::wstring to a UTF-8 std::string for saving to JSON.
-std::string WstringToUtf8(const std::wstring& wstr) {
-    if (wstr.empty()) return std::string();
-    int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
-    std::string strTo(size_needed, 0);
-    WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
-    return strTo;
-}
-
 // Gets the full path to config.json in %APPDATA%\ClipboardToFile.
 std::wstring GetConfigFilePath() {
     wchar_t appDataPath[MAX_PATH];
@@ -338,98 +322,39 @@ std::wstring GetConfigFilePath() {
     return L"config.json"; // Fallback to local directory.
 }
 
-// Helper function to precompile regex patterns (call with mutex already held)
-void CompileRegexPatterns() {
-    g_compiledRegexes.clear();
-    for (const auto& pattern : g_settings.contentCreationRegexes) {
-        try {
-            g_compiledRegexes.emplace_back(pattern, std::regex::ECMAScript | std::regex::icase);
-        }
-        catch (const std::regex_error&) {
-            // Skip invalid regex patterns - don't add to compiled list
-            continue;
-        }
-    }
+// Compiles g_settings into a new snapshot and swaps it in (call with mutex already held).
+// Events still running keep the snapshot they started with.
+void PublishEngineSettings() {
+    std::shared_ptr<const EngineSettings> snapshot = std::make_shared<const EngineSettings>(CompileEngineSettings(g_settings));
+    std::atomic_store(&g_engineSettings, snapshot);
 }
 
-// Writes the current state of the g_settings struct to config.json, persisting user choices.
+// Returns the current settings snapshot for one clipboard event or menu; never blocks.
+std::shared_ptr<const EngineSettings> CaptureEngineSettings() {
+    return std::atomic_load(&g_engineSettings);
+}
+
+// Writes the published settings snapshot to config.json, persisting user choices.
 void SaveSettings() {
-    std::wstring settingsPath = GetConfigFilePath();
-    nlohmann::json j;
-    {
-        std::lock_guard<std::mutex> lock(g_extensionsMutex);
-        j["createEmptyFileEnabled"] = g_settings.isCreateEmptyFileEnabled;
-        j["createWithContentEnabled"] = g_settings.isCreateWithContentEnabled;
-        j["createDirectoryStructureEnabled"] = g_settings.isCreateDirectoryStructureEnabled;
-        j["createEmptyDirectories"] = g_settings.createEmptyDirectories;
-        j["skipExistingDirectories"] = g_settings.skipExistingDirectories;
-
-        std::vector<std::string> utf8_allowedExtensions;
-        for (const auto& wstr : g_settings.allowedExtensions) utf8_allowedExtensions.push_back(WstringToUtf8(wstr));
-        j["allowedExtensions"] = utf8_allowedExtensions;
-
-        std::vector<std::string> utf8_regexes;
-        for (const auto& wstr : g_settings.contentCreationRegexes) utf8_regexes.push_back(WstringToUtf8(wstr));
-        j["contentCreationRegexes"] = utf8_regexes;
-        j["heuristicWordCountLimit"] = g_settings.heuristicWordCountLimit;
-    }
-    std::ofstream o(settingsPath);
-    o << std::setw(2) << j << std::endl;
+    std::shared_ptr<const EngineSettings> snapshot = CaptureEngineSettings();
+    if (!snapshot) return;
+    SaveSettingsFile(GetConfigFilePath(), snapshot->app);
 }
 
 // Reads config.json, creates a default if missing, and populates the global g_settings struct.
 void LoadSettings() {
-    std::wstring settingsPath = GetConfigFilePath();
-    AppSettings defaults;
-    defaults.allowedExtensions = { L".txt", L".md", L".log", L".sql", L".cpp", L".h", L".js", L".json", L".xml", L".cs", L".c" };
-    defaults.contentCreationRegexes = {
-        L"^// --- START OF FILE: (.*) ---$",
-        L"^file: (.*)$",
-        L"^(.*\\.[a-zA-Z0-9]+)$"
-    };
-    defaults.isCreateDirectoryStructureEnabled = true;
-    defaults.createEmptyDirectories = true;
-    defaults.skipExistingDirectories = true;
-
-    std::ifstream f(settingsPath);
-    if (!f.is_open()) {
-        {
-            std::lock_guard<std::mutex> lock(g_extensionsMutex);
-            g_settings = defaults;
-            CompileRegexPatterns();
-        }
-        
-        SaveSettings(); // Save the new default file.
-        return;
-    }
-
-    try {
-        nlohmann::json j = nlohmann::json::parse(f);
+    AppSettings loaded = GetDefaultSettings();
+    SettingsFileStatus status = LoadSettingsFile(GetConfigFilePath(), loaded);
+    {
         std::lock_guard<std::mutex> lock(g_extensionsMutex);
-        g_settings.isCreateEmptyFileEnabled = j.value("createEmptyFileEnabled", defaults.isCreateEmptyFileEnabled);
-        g_settings.isCreateWithContentEnabled = j.value("createWithContentEnabled", defaults.isCreateWithContentEnabled);
-        g_settings.isCreateDirectoryStructureEnabled = j.value("createDirectoryStructureEnabled", defaults.isCreateDirectoryStructureEnabled);
-        g_settings.createEmptyDirectories = j.value("createEmptyDirectories", defaults.createEmptyDirectories);
-        g_settings.skipExistingDirectories = j.value("skipExistingDirectories", defaults.skipExistingDirectories);
-
-        if (j.contains("allowedExtensions")) {
-            g_settings.allowedExtensions.clear();
-            for (const auto& str : j["allowedExtensions"]) g_settings.allowedExtensions.push_back(Utf8ToWstring(str.get<std::string>()));
-        }
-        else { g_settings.allowedExtensions = defaults.allowedExtensions; }
-
-        if (j.contains("contentCreationRegexes")) {
-            g_settings.contentCreationRegexes.clear();
-            for (const auto& str : j["contentCreationRegexes"]) g_settings.contentCreationRegexes.push_back(Utf8ToWstring(str.get<std::string>()));
-        }
-        else { g_settings.contentCreationRegexes = defaults.contentCreationRegexes; }
+        g_settings = loaded;    // The defaults unless the file was read
+        PublishEngineSettings();
+    }
 
-        g_settings.heuristicWordCountLimit = j.value("heuristicWordCountLimit", defaults.heuristicWordCountLimit);
-        CompileRegexPatterns();
+    if (status == SettingsFileStatus::Missing) {
+        SaveSettings(); // Save the new default file.
     }
-    catch (const nlohmann::json::parse_error&) {
-        std::lock_guard<std::mutex> lock(g_extensionsMutex);
-        g_settings = defaults;
+    else if (status == SettingsFileStatus::Invalid) {
         ShowToastNotification(g_hMainWnd, L"Config Error", L"Could not parse config.json. Loading defaults.", NIIF_ERROR);
     }
 }
@@ -609,6 +534,67 @@ DWORD WINAPI FileWatcherThread(LPVOID)
 }
 
 
+//------------------------------------------------------------------------------------------------//
+//                                CLIPBOARD WORKER THREAD                                         //
+//------------------------------------------------------------------------------------------------//
+// Takes snapshotted clipboard updates off g_clipboardQueue and handles them one at a time. While
+// it is busy (or waiting on a dialog), newer updates replace each other in the queue, so only the
+// latest of a burst is processed.
+DWORD WINAPI ClipboardWorkerThread(LPVOID)
+{
+    // COM is per thread; GetSingleExplorerPath runs here.
+    t_comInitialized = SUCCEEDED(CoInitialize(NULL));
+
+    HANDLE waitHandles[2] = { g_hShutdownEvent, g_hClipboardEvent };
+    while (true) {
+        DWORD waitStatus = WaitForMultipleObjects(2, waitHandles, FALSE, INFINITE);
+        if (waitStatus != WAIT_OBJECT_0 + 1) break; // Shutdown event or an error.
+
+        // Let the rest of a burst arrive (apps writing several formats, clipboard managers).
+        if (WaitForSingleObject(g_hShutdownEvent, kBurstSettleMs) == WAIT_OBJECT_0) break;
+
+        std::unique_ptr<ClipboardEvent> event = g_clipboardQueue.Take();
+        if (event) HandleClipboardEvent(*event);
+    }
+
+    if (t_comInitialized) CoUninitialize();
+    t_comInitialized = false;
+    return 0;
+}
+
+// True once WM_DESTROY has asked the worker threads to stop.
+bool IsShuttingDown()
+{
+    return WaitForSingleObject(g_hShutdownEvent, 0) == WAIT_OBJECT_0;
+}
+
+// MessageBoxW for the clipboard worker. During shutdown no dialog is opened and IDNO is returned;
+// IDNO is the cancel or skip answer of every dialog the worker shows, and DismissWorkerDialogs
+// answers an open one with it too.
+int ShowWorkerMessageBox(const std::wstring& text, const wchar_t* caption, UINT type)
+{
+    if (IsShuttingDown()) return IDNO;
+    int result = MessageBoxW(NULL, text.c_str(), caption, type);
+    return IsShuttingDown() ? IDNO : result;
+}
+
+// EnumThreadWindows callback: presses No on a message box.
+BOOL CALLBACK DismissWorkerDialog(HWND hwnd, LPARAM)
+{
+    wchar_t className[16];
+    if (GetClassNameW(hwnd, className, 16) && wcscmp(className, L"#32770") == 0) {
+        PostMessageW(hwnd, WM_COMMAND, MAKEWPARAM(IDNO, BN_CLICKED), (LPARAM)GetDlgItem(hwnd, IDNO));
+    }
+    return TRUE;
+}
+
+// Answers every dialog the clipboard worker has open with IDNO (UI thread, during shutdown).
+void DismissWorkerDialogs()
+{
+    EnumThreadWindows(g_clipboardWorkerId, DismissWorkerDialog, 0);
+}
+
+
 //------------------------------------------------------------------------------------------------//
 //                          FILE CONFLICT RESOLUTION                                              //
 //------------------------------------------------------------------------------------------------//
@@ -621,8 +607,7 @@ FileConflictAction ShowFileConflictDialog(const std::wstring& filename)
         L"No = Skip (do not create the file)\n"
         L"Cancel = Rename (create with a different name)";
 
-    int result = MessageBoxW(NULL,
-        message.c_str(),
+    int result = ShowWorkerMessageBox(message,
         L"File Already Exists",
         MB_YESNOCANCEL | MB_ICONWARNING | MB_DEFBUTTON2);
 
@@ -634,962 +619,233 @@ FileConflictAction ShowFileConflictDialog(const std::wstring& filename)
     }
 }
 
-// Generates a unique filename by appending a number to the base name
-std::wstring GenerateUniqueFilename(const std::wstring& originalPath)
-{
-    if (GetFileAttributesW(originalPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
-        return originalPath; // Original doesn't exist, use it
-    }
-
-    wchar_t drive[_MAX_DRIVE];
-    wchar_t dir[_MAX_DIR];
-    wchar_t fname[_MAX_FNAME];
-    wchar_t ext[_MAX_EXT];
-
-    _wsplitpath_s(originalPath.c_str(), drive, _MAX_DRIVE, dir, _MAX_DIR, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-    int counter = 1;
-    std::wstring newPath;
-
-    do {
-        std::wstringstream ss;
-        ss << drive << dir << fname << L" (" << counter << L")" << ext;
-        newPath = ss.str();
-        counter++;
-    } while (GetFileAttributesW(newPath.c_str()) != INVALID_FILE_ATTRIBUTES && counter < 1000);
-
-    return newPath;
-}
-
 
 //------------------------------------------------------------------------------------------------//
 //                          CORE LOGIC & FILE MANAGEMENT                                          //
 //------------------------------------------------------------------------------------------------//
-// A simple helper to count words in a string, used by the content-creation heuristic.
-int CountWords(const std::wstring& str) {
-    std::wstringstream ss(str);
-    std::wstring word;
-    int count = 0;
-    while (ss >> word) count++;
-    return count;
-}
-
-bool TryDirectoryStructureCreation(const std::wstring& clipboardText) {
-    bool enabled;
-    {
-        std::lock_guard<std::mutex> lock(g_extensionsMutex);
-        enabled = g_settings.isCreateDirectoryStructureEnabled;
-    }
-
-    if (!enabled) return false;
-
-    // Detect format
-    TreeFormat format = DetectTreeFormat(clipboardText);
-    if (format == TreeFormat::Unknown) return false;
-
-    // Parse the structure
-    auto root = ParseTreeStructure(clipboardText, format);
-    if (!root) return false;
-
+// Sets created when anything was written to disk.
+bool TryDirectoryStructureCreation(const DirectoryStructurePlan& plan, const EngineSettings& settings, bool& created) {
     // Get Explorer path
     std::wstring explorerPath = GetSingleExplorerPath();
     if (explorerPath.empty()) {
-        ShowToastNotification(g_hMainWnd, L"Error", L"No File Explorer window found.", NIIF_ERROR);
+        PostToastNotification(L"Error", L"No File Explorer window found.", NIIF_ERROR);
         return false;
     }
 
-    // Count items for user confirmation
-    int dirCount = 0, fileCount = 0;
-    GetTreeSummary(root.get(), dirCount, fileCount);
-
     // Show confirmation dialog for large structures
-    if (dirCount + fileCount > 10) {
+    if (plan.dirCount + plan.fileCount > 10) {
         std::wstring message = L"Create directory structure with:\n\n";
-        message += L"• " + std::to_wstring(dirCount) + L" directories\n";
-        message += L"• " + std::to_wstring(fileCount) + L" files\n\n";
+        message += L"• " + std::to_wstring(plan.dirCount) + L" directories\n";
+        message += L"• " + std::to_wstring(plan.fileCount) + L" files\n\n";
         message += L"Continue?";
 
-        if (MessageBoxW(NULL, message.c_str(), L"Confirm Directory Structure",
+        if (ShowWorkerMessageBox(message, L"Confirm Directory Structure",
             MB_YESNO | MB_ICONQUESTION) != IDYES) {
             return true; // User cancelled, but we handled the clipboard
         }
     }
 
     // Create the structure
-    if (CreateDirectoryStructure(root.get(), explorerPath)) {
-        std::wstring msg = L"Created " + std::to_wstring(dirCount) + L" directories and " +
-            std::to_wstring(fileCount) + L" files";
-        ShowToastNotification(g_hMainWnd, L"Structure Created", msg, NIIF_INFO);
+    MaterializeReport report;
+    if (CreateDirectoryStructure(plan.tree, explorerPath, settings.app, report, IsShuttingDown)) {
+        created = true;
+        std::wstring msg = L"Created " + std::to_wstring(plan.dirCount) + L" directories and " +
+            std::to_wstring(plan.fileCount) + L" files";
+        PostToastNotification(L"Structure Created", msg, NIIF_INFO);
         return true;
     }
     else {
-        ShowToastNotification(g_hMainWnd, L"Error", L"Failed to create directory structure", NIIF_ERROR);
-        return false;
-    }
-}
-
-TreeFormat DetectTreeFormat(const std::wstring& text) {
-    // Check for tree command characters (using Unicode code points)
-    // 0x251C = '├', 0x2514 = '└', 0x2502 = '│'
-    if (text.find(0x251C) != std::wstring::npos || text.find(0x2514) != std::wstring::npos ||
-        text.find(0x2502) != std::wstring::npos) {
-        return TreeFormat::TreeCommand;
-    }
-
-    // Check for enhanced format markers
-    if (text.find(L"---START:") != std::wstring::npos || text.find(L"---END:") != std::wstring::npos) {
-        return TreeFormat::Enhanced;
-    }
-
-    // Split into lines for further analysis
-    std::vector<std::wstring> lines;
-    std::wstringstream ss(text);
-    std::wstring line;
-    while (std::getline(ss, line)) {
-        if (!line.empty()) lines.push_back(line);
-    }
-
-    if (lines.empty()) return TreeFormat::Unknown;
-
-    // Check for path list format (contains forward or back slashes)
-    bool hasSlashes = false;
-    for (const auto& l : lines) {
-        if (l.find(L'/') != std::wstring::npos || l.find(L'\\') != std::wstring::npos) {
-            hasSlashes = true;
-            break;
-        }
-    }
-
-    // Check for consistent indentation
-    bool hasIndentation = false;
-    for (const auto& l : lines) {
-        if (l[0] == L' ' || l[0] == L'\t') {
-            hasIndentation = true;
-            break;
+        if (!report.errorMessage.empty()) {
+            PostToastNotification(report.errorTitle, report.errorMessage, NIIF_ERROR);
         }
+        PostToastNotification(L"Error", L"Failed to create directory structure", NIIF_ERROR);
+        return false;
     }
-
-    if (hasSlashes && !hasIndentation) return TreeFormat::PathList;
-    if (hasIndentation) return TreeFormat::Indentation;
-
-    return TreeFormat::Unknown;
 }
 
-std::unique_ptr<TreeNode> ParseTreeStructure(const std::wstring& text, TreeFormat format) {
-    // Split into lines
-    std::vector<std::wstring> lines;
-    std::wstringstream ss(text);
-    std::wstring line;
-    while (std::getline(ss, line)) {
-        lines.push_back(line);
+// Asks once how to treat every file of a batch that already exists.
+FileConflictAction ShowBatchConflictDialog(const std::vector<std::wstring>& existingFiles)
+{
+    std::wstring conflictMessage = L"The following files already exist:\n\n";
+    for (size_t i = 0; i < existingFiles.size() && i < 10; ++i) {
+        conflictMessage += existingFiles[i] + L"\n";
     }
-
-    switch (format) {
-    case TreeFormat::TreeCommand:
-        return ParseTreeCommandFormat(lines);
-    case TreeFormat::Indentation:
-        return ParseIndentationFormat(lines);
-    case TreeFormat::PathList:
-        return ParsePathListFormat(lines);
-    case TreeFormat::Enhanced:
-        return ParseEnhancedFormat(lines);
-    default:
-        return nullptr;
+    if (existingFiles.size() > 10) {
+        conflictMessage += L"... and " + std::to_wstring(existingFiles.size() - 10) + L" more\n";
     }
-}
-
-std::unique_ptr<TreeNode> ParseTreeCommandFormat(const std::vector<std::wstring>& lines) {
-    auto root = std::make_unique<TreeNode>(L"root", true);
-    std::vector<TreeNode*> stack;
-    stack.push_back(root.get());
-
-    for (const auto& line : lines) {
-        if (line.empty()) continue;
-
-        // Count depth by tree characters
-        int depth = 0;
-        size_t pos = 0;
-        while (pos < line.length()) {
-            if (line[pos] == 0x2502 || line[pos] == L' ') {  // 0x2502 is '│'
-                depth++;
-                pos += 4; // Tree characters are usually followed by 3 spaces
-            }
-            else {
-                break;
-            }
-        }
-
-        // Find the actual content after tree characters
-        // 0x2502 = '│', 0x251C = '├', 0x2514 = '└', 0x2500 = '─'
-        std::wstring treeChars = L" \t";
-        treeChars += static_cast<wchar_t>(0x2502);  // │
-        treeChars += static_cast<wchar_t>(0x251C);  // ├
-        treeChars += static_cast<wchar_t>(0x2514);  // └
-        treeChars += static_cast<wchar_t>(0x2500);  // ─
-        size_t contentStart = line.find_first_not_of(treeChars, pos);
-        if (contentStart == std::wstring::npos) continue;
-
-        std::wstring name = line.substr(contentStart);
-        name.erase(0, name.find_first_not_of(L" \t"));
-        name.erase(name.find_last_not_of(L" \t\r") + 1);
-
-        if (name.empty()) continue;
-
-        // Check if it's a directory (ends with /)
-        bool isDir = name.back() == L'/';
-        if (isDir) name.pop_back();
+    conflictMessage += L"\nChoose action for ALL existing files:\n\n";
+    conflictMessage += L"Yes = Replace all existing files\n";
+    conflictMessage += L"No = Skip all existing files\n";
+    conflictMessage += L"Cancel = Rename all existing files";
 
-        // Adjust stack to current depth
-        while (stack.size() > depth + 1) stack.pop_back();
-
-        // Create node and add to parent
-        auto node = std::make_unique<TreeNode>(name, isDir);
-        TreeNode* nodePtr = node.get();
-        stack.back()->children.push_back(std::move(node));
+    int result = ShowWorkerMessageBox(conflictMessage, L"Multiple File Conflicts",
+        MB_YESNOCANCEL | MB_ICONWARNING | MB_DEFBUTTON2);
 
-        if (isDir) stack.push_back(nodePtr);
+    switch (result) {
+    case IDYES: return FileConflictAction::Replace;
+    case IDNO: return FileConflictAction::Skip;
+    case IDCANCEL: return FileConflictAction::Rename;
+    default: return FileConflictAction::Skip;
     }
-
-    return root;
 }
 
-std::unique_ptr<TreeNode> ParseIndentationFormat(const std::vector<std::wstring>& lines) {
-    auto root = std::make_unique<TreeNode>(L"root", true);
-    std::vector<std::pair<TreeNode*, int>> stack; // node, indent level
-    stack.push_back({ root.get(), -1 });
-
-    for (const auto& line : lines) {
-        if (line.empty()) continue;
-
-        // Count leading spaces/tabs
-        int indent = 0;
-        for (wchar_t c : line) {
-            if (c == L' ') indent++;
-            else if (c == L'\t') indent += 4; // treat tab as 4 spaces
-            else break;
-        }
-
-        // Extract name
-        std::wstring name = line.substr(indent);
-        name.erase(0, name.find_first_not_of(L" \t"));
-        name.erase(name.find_last_not_of(L" \t\r") + 1);
-
-        if (name.empty()) continue;
-
-        // Check if directory
-        bool isDir = name.back() == L'/';
-        if (isDir) name.pop_back();
-
-        // Find parent based on indentation
-        while (!stack.empty() && stack.back().second >= indent) {
-            stack.pop_back();
-        }
-
-        // Create node
-        auto node = std::make_unique<TreeNode>(name, isDir);
-        TreeNode* nodePtr = node.get();
-        stack.back().first->children.push_back(std::move(node));
-
-        if (isDir) stack.push_back({ nodePtr, indent });
+// Unified function that handles both empty file generation and file generation with content.
+// Sets created when anything was written to disk.
+bool TryFileGeneration(const FileGenerationPlan& plan, const EngineSettings& settings, bool& created) {
+    switch (plan.kind) {
+    case FileGenerationKind::None:
+        return false;
+    case FileGenerationKind::InvalidFilename:
+        return true; // Detected a pattern but filename is invalid. Stop all further processing.
+    case FileGenerationKind::MultipleFiles:
+        break;
+    case FileGenerationKind::SingleFile:
+        break;
     }
 
-    return root;
-}
-
-std::unique_ptr<TreeNode> ParsePathListFormat(const std::vector<std::wstring>& lines) {
-    auto root = std::make_unique<TreeNode>(L"root", true);
-
-    for (const auto& line : lines) {
-        std::wstring path = line;
-        path.erase(0, path.find_first_not_of(L" \t"));
-        path.erase(path.find_last_not_of(L" \t\r") + 1);
-
-        if (path.empty()) continue;
-
-        // Normalize path separators
-        std::replace(path.begin(), path.end(), L'\\', L'/');
-
-        // Split path into components
-        std::vector<std::wstring> components;
-        std::wstringstream ss(path);
-        std::wstring component;
-        while (std::getline(ss, component, L'/')) {
-            if (!component.empty()) components.push_back(component);
-        }
-
-        if (components.empty()) continue;
-
-        // Navigate/create path in tree
-        TreeNode* current = root.get();
-        for (size_t i = 0; i < components.size(); ++i) {
-            const auto& comp = components[i];
-            bool isLastComponent = (i == components.size() - 1);
-            bool isDir = isLastComponent ? (path.back() == L'/') : true;
-
-            // Check for file extension in last component
-            if (isLastComponent && !isDir) {
-                size_t dotPos = comp.find_last_of(L'.');
-                if (dotPos != std::wstring::npos && dotPos > 0) {
-                    isDir = false;
-                }
-                else {
-                    isDir = true; // No extension, assume directory
-                }
-            }
-
-            // Find or create child
-            TreeNode* child = nullptr;
-            for (auto& c : current->children) {
-                if (c->name == comp) {
-                    child = c.get();
-                    break;
-                }
-            }
-
-            if (!child) {
-                auto newChild = std::make_unique<TreeNode>(comp, isDir);
-                child = newChild.get();
-                current->children.push_back(std::move(newChild));
-            }
+    std::wstring explorerPath = GetSingleExplorerPath();
 
-            if (isDir) current = child;
+    if (plan.kind == FileGenerationKind::MultipleFiles) {
+        if (explorerPath.empty()) {
+            PostToastNotification(L"Error", L"No File Explorer window found.", NIIF_ERROR);
+            return false;
         }
-    }
 
-    return root;
-}
+        // Separate files into existing and new
+        std::vector<std::wstring> newFiles;
+        std::vector<std::wstring> existingFiles;
+        SplitExistingFiles(explorerPath, plan.filenames, newFiles, existingFiles);
 
-std::unique_ptr<TreeNode> ParseEnhancedFormat(const std::vector<std::wstring>& lines) {
-    auto root = ParseIndentationFormat(lines); // Start with basic indentation parsing
-
-    // Now look for content markers
-    std::wstring currentFile;
-    std::wstring currentContent;
-    bool inContent = false;
-
-    for (size_t i = 0; i < lines.size(); ++i) {
-        const auto& line = lines[i];
-
-        // Check for content start marker
-        if (line.find(L"---START:") != std::wstring::npos) {
-            size_t start = line.find(L"---START:") + 9;
-            size_t end = line.find(L"---", start);
-            if (end != std::wstring::npos) {
-                currentFile = line.substr(start, end - start);
-                currentFile.erase(0, currentFile.find_first_not_of(L" \t"));
-                currentFile.erase(currentFile.find_last_not_of(L" \t") + 1);
-                inContent = true;
-                currentContent.clear();
-            }
-        }
-        // Check for content end marker
-        else if (line.find(L"---END:") != std::wstring::npos && inContent) {
-            inContent = false;
-            // Find the file node and set its content
-            std::function<void(TreeNode*)> setContent = [&](TreeNode* node) {
-                if (!node->isDirectory && node->name == currentFile) {
-                    node->content = currentContent;
-                    return;
-                }
-                for (auto& child : node->children) {
-                    setContent(child.get());
-                }
-                };
-            setContent(root.get());
-        }
-        // Collect content
-        else if (inContent) {
-            if (!currentContent.empty()) currentContent += L"\n";
-            currentContent += line;
+        // Handle existing files if any
+        FileConflictAction conflictAction = FileConflictAction::Skip;
+        if (!existingFiles.empty()) {
+            conflictAction = ShowBatchConflictDialog(existingFiles);
+            if (IsShuttingDown()) return false; // Dismissed by WM_DESTROY; create nothing
         }
-    }
-
-    return root;
-}
-
-bool CreateDirectoryStructure(const TreeNode* root, const std::wstring& basePath) {
-    if (!root || root->children.empty()) return false;
-
-    bool skipExisting;
-    {
-        std::lock_guard<std::mutex> lock(g_extensionsMutex);
-        skipExisting = g_settings.skipExistingDirectories;
-    }
-
-    std::function<bool(const TreeNode*, const std::wstring&)> createNode =
-        [&](const TreeNode* node, const std::wstring& parentPath) -> bool {
 
-        std::wstring fullPath = parentPath + L"\\" + node->name;
+        BatchResult result = CreateFileBatch(explorerPath, newFiles, existingFiles, conflictAction, settings.app.durability);
+        created = result.successCount > 0;
 
-        // Security check
-        if (!IsPathSafe(fullPath)) {
-            ShowToastNotification(g_hMainWnd, L"Security Error",
-                L"Invalid path detected: " + node->name, NIIF_ERROR);
-            return false;
-        }
-
-        if (node->isDirectory) {
-            // Create directory
-            DWORD attrs = GetFileAttributesW(fullPath.c_str());
-            if (attrs == INVALID_FILE_ATTRIBUTES) {
-                if (!CreateDirectoryW(fullPath.c_str(), NULL)) {
-                    DWORD error = GetLastError();
-                    if (error != ERROR_ALREADY_EXISTS) {
-                        return false;
-                    }
-                }
+        // Show results to user
+        std::wstring resultMessage;
+        if (result.successCount > 0) {
+            resultMessage = L"Successfully created " + std::to_wstring(result.successCount) + L" files";
+            if (result.skipCount > 0) {
+                resultMessage += L", skipped " + std::to_wstring(result.skipCount) + L" existing files";
             }
-            else if (!(attrs & FILE_ATTRIBUTE_DIRECTORY)) {
-                // File exists with same name
-                if (!skipExisting) {
-                    ShowToastNotification(g_hMainWnd, L"Error",
-                        L"File exists with directory name: " + node->name, NIIF_ERROR);
-                    return false;
-                }
+            if (!result.failedFiles.empty()) {
+                resultMessage += L", failed to create " + std::to_wstring(result.failedFiles.size()) + L" files";
             }
-
-            // Create children
-            for (const auto& child : node->children) {
-                if (!createNode(child.get(), fullPath)) {
-                    return false;
-                }
+            if (result.syncFailed) {
+                resultMessage += L" (could not flush them to disk)";
             }
+            PostToastNotification(L"Multiple Files Created", resultMessage, NIIF_INFO);
         }
         else {
-            // Create file
-            bool createEmptyDirs;
-            {
-                std::lock_guard<std::mutex> lock(g_extensionsMutex);
-                createEmptyDirs = g_settings.createEmptyDirectories;
-            }
-
-            // Ensure parent directory exists
-            std::wstring parentDir = fullPath.substr(0, fullPath.find_last_of(L"\\"));
-            DWORD attrs = GetFileAttributesW(parentDir.c_str());
-            if (attrs == INVALID_FILE_ATTRIBUTES && createEmptyDirs) {
-                // Create parent directories if needed
-                std::wstring currentPath;
-                std::wstringstream ss(parentDir);
-                std::wstring segment;
-                while (std::getline(ss, segment, L'\\')) {
-                    if (!currentPath.empty()) currentPath += L"\\";
-                    currentPath += segment;
-                    CreateDirectoryW(currentPath.c_str(), NULL);
-                }
-            }
-
-            // Create the file
-            if (GetFileAttributesW(fullPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
-                if (!node->content.empty()) {
-                    // Create with content
-                    std::wofstream file(fullPath);
-                    if (file.is_open()) {
-                        file << node->content;
-                        file.close();
-                    }
-                    else {
-                        return false;
-                    }
-                }
-                else {
-                    // Create empty file
-                    HANDLE hFile = CreateFileW(fullPath.c_str(), GENERIC_WRITE, 0, NULL,
-                        CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
-                    if (hFile != INVALID_HANDLE_VALUE) {
-                        CloseHandle(hFile);
-                    }
-                    else {
-                        return false;
-                    }
-                }
-            }
-        }
-
-        return true;
-        };
-
-    // Create all children of root (skip the root node itself)
-    for (const auto& child : root->children) {
-        if (!createNode(child.get(), basePath)) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-// Unified function that handles both empty file generation and file generation with content
-bool TryFileGeneration(const std::wstring& clipboardText) {
-    bool emptyEnabled, contentEnabled;
-    {
-        std::lock_guard<std::mutex> lock(g_extensionsMutex);
-        emptyEnabled = g_settings.isCreateEmptyFileEnabled;
-        contentEnabled = g_settings.isCreateWithContentEnabled;
-    }
-
-    if (!emptyEnabled && !contentEnabled) return false;
-
-    size_t first_line_end = clipboardText.find(L'\n');
-
-    std::wstring firstLine;
-    std::wstring content;
-    bool isMultiLine = (first_line_end != std::wstring::npos);
-
-    if (isMultiLine) {
-        // Multi-line content: split at newline
-        firstLine = clipboardText.substr(0, first_line_end);
-        content = clipboardText.substr(first_line_end + 1);
-
-        // If content creation is disabled, don't process multi-line content
-        if (!contentEnabled) return false;
-    }
-    else {
-        // Single-line content: treat entire clipboard as "first line" initially
-        firstLine = clipboardText;
-        content = L"";
-    }
-
-    // Trim the first line
-    firstLine.erase(0, firstLine.find_first_not_of(L" \t\r\n"));
-    firstLine.erase(firstLine.find_last_not_of(L" \t\r\n") + 1);
-
-    std::wstring filename;
-    bool format_detected = false;
-    size_t filename_end_pos = 0;
-
-    // Priority 1: Use pre-compiled regex patterns from config (if content creation is enabled)
-    if (contentEnabled) {
-        std::lock_guard<std::mutex> lock(g_extensionsMutex);
-        for (const auto& compiledRegex : g_compiledRegexes) {
-            try {
-                std::wsmatch match;
-                if (std::regex_match(firstLine, match, compiledRegex) && match.size() > 1) {
-                    filename = match[1].str();
-                    format_detected = true;
-                    filename_end_pos = first_line_end != std::wstring::npos ? first_line_end + 1 : clipboardText.length();
-                    break;
-                }
+            resultMessage = L"No files were created";
+            if (result.skipCount > 0) {
+                resultMessage += L" (" + std::to_wstring(result.skipCount) + L" files were skipped)";
             }
-            catch (const std::regex_error&) {
-                continue; // Silently ignore runtime regex errors.
+            if (!result.failedFiles.empty()) {
+                resultMessage += L" (" + std::to_wstring(result.failedFiles.size()) + L" files failed)";
             }
+            PostToastNotification(L"File Creation", resultMessage, NIIF_WARNING);
         }
-    }
 
-    // Priority 2: Check if first word is a filename with content following (single-line only)
-    if (!format_detected && !isMultiLine) {
-        std::wstringstream ss(firstLine);
-        std::wstring firstWord;
-        if (ss >> firstWord) {
-            // Check if first word looks like a filename
-            wchar_t ext[_MAX_EXT];
-            _wsplitpath_s(firstWord.c_str(), NULL, 0, NULL, 0, NULL, 0, ext, _MAX_EXT);
-            std::wstring extension(ext);
-            std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
-
-            bool isAllowedExtension = false;
-            {
-                std::lock_guard<std::mutex> lock(g_extensionsMutex);
-                for (const auto& allowedExt : g_settings.allowedExtensions) {
-                    if (extension == allowedExt) {
-                        isAllowedExtension = true;
-                        break;
-                    }
-                }
-            }
-
-            if (isAllowedExtension) {
-                // Extract content after the filename
-                size_t firstWordEnd = firstLine.find(firstWord) + firstWord.length();
-                if (firstWordEnd < firstLine.length()) {
-                    // There's content after the filename
-                    content = firstLine.substr(firstWordEnd);
-                    content.erase(0, content.find_first_not_of(L" \t")); // Trim leading whitespace
-                    filename = firstWord;
-                    format_detected = true;
-                    filename_end_pos = firstWordEnd;
-
-                    // For this case, we need content creation enabled since we found content
-                    if (!contentEnabled) {
-                        return false;
-                    }
-                }
-                else {
-                    // Just the filename, no content - treat as empty file case
-                    filename = firstWord;
-                    content = L"";
-                    format_detected = true;
-                    filename_end_pos = firstWordEnd;
-
-                    // For empty file, we need empty file creation enabled
-                    if (!emptyEnabled) {
-                        return false;
-                    }
-                }
-            }
-        }
+        return result.successCount > 0;
     }
 
-    // Priority 3: Fallback to the simpler word-count heuristic (for both modes)
-    if (!format_detected) {
-        wchar_t ext[_MAX_EXT];
-        _wsplitpath_s(firstLine.c_str(), NULL, 0, NULL, 0, NULL, 0, ext, _MAX_EXT);
-        std::wstring extension(ext);
-        std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
-
-        bool isAllowedExtension = false;
-        int wordCountLimit;
-
-        {
-            std::lock_guard<std::mutex> lock(g_extensionsMutex);
-            wordCountLimit = g_settings.heuristicWordCountLimit;
-            for (const auto& allowedExt : g_settings.allowedExtensions) {
-                if (extension == allowedExt) {
-                    isAllowedExtension = true;
-                    break;
-                }
-            }
-        }
-
-        if (isAllowedExtension && CountWords(firstLine) <= wordCountLimit) {
-            filename = firstLine;
-            format_detected = true;
-            filename_end_pos = first_line_end != std::wstring::npos ? first_line_end + 1 : clipboardText.length();
+    if (explorerPath.empty()) return false;
 
-            // Priority 3 creates empty files, so check if empty file creation is enabled
-            if (!emptyEnabled) {
-                return false;
-            }
-        }
+    // Check if file exists and handle conflict
+    FileConflictAction action = FileConflictAction::Replace;
+    if (FsPathExists(JoinPath(explorerPath, plan.filename))) {
+        action = ShowFileConflictDialog(plan.filename);
     }
 
-    // If we found a filename, check if there are more filenames following it
-    if (format_detected && emptyEnabled) {
-        std::vector<std::wstring> allFilenames;
-        allFilenames.push_back(filename);
-
-        // Look for additional filenames using smart line-based logic
-        std::vector<std::wstring> additionalFilenames = FindAdditionalFilenames(clipboardText, filename_end_pos);
-        allFilenames.insert(allFilenames.end(), additionalFilenames.begin(), additionalFilenames.end());
-
-        // If we found multiple filenames, handle as batch creation
-        if (allFilenames.size() >= 2) {
-            std::wstring explorerPath = GetSingleExplorerPath();
-            if (explorerPath.empty()) {
-                ShowToastNotification(g_hMainWnd, L"Error", L"No File Explorer window found.", NIIF_ERROR);
-                return false;
-            }
-
-            // Separate files into existing and new
-            std::vector<std::wstring> newFiles;
-            std::vector<std::wstring> existingFiles;
-
-            for (const auto& fname : allFilenames) {
-                std::wstring fullPath = explorerPath + L"\\" + fname;
-                if (GetFileAttributesW(fullPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-                    existingFiles.push_back(fname);
-                }
-                else {
-                    newFiles.push_back(fname);
-                }
-            }
-
-            // Handle existing files if any
-            FileConflictAction conflictAction = FileConflictAction::Skip;
-            if (!existingFiles.empty()) {
-                std::wstring conflictMessage = L"The following files already exist:\n\n";
-                for (size_t i = 0; i < existingFiles.size() && i < 10; ++i) {
-                    conflictMessage += existingFiles[i] + L"\n";
-                }
-                if (existingFiles.size() > 10) {
-                    conflictMessage += L"... and " + std::to_wstring(existingFiles.size() - 10) + L" more\n";
-                }
-                conflictMessage += L"\nChoose action for ALL existing files:\n\n";
-                conflictMessage += L"Yes = Replace all existing files\n";
-                conflictMessage += L"No = Skip all existing files\n";
-                conflictMessage += L"Cancel = Rename all existing files";
-
-                int result = MessageBoxW(NULL, conflictMessage.c_str(), L"Multiple File Conflicts",
-                    MB_YESNOCANCEL | MB_ICONWARNING | MB_DEFBUTTON2);
-
-                switch (result) {
-                case IDYES: conflictAction = FileConflictAction::Replace; break;
-                case IDNO: conflictAction = FileConflictAction::Skip; break;
-                case IDCANCEL: conflictAction = FileConflictAction::Rename; break;
-                default: conflictAction = FileConflictAction::Skip; break;
-                }
-            }
-
-            // Create all files
-            int successCount = 0;
-            int skipCount = 0;
-            std::vector<std::wstring> failedFiles;
-
-            // Create new files first
-            for (const auto& fname : newFiles) {
-                std::wstring fullPath = explorerPath + L"\\" + fname;
-                HANDLE hFile = CreateFileW(fullPath.c_str(), GENERIC_WRITE, 0, NULL,
-                    CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
-                if (hFile != INVALID_HANDLE_VALUE) {
-                    CloseHandle(hFile);
-                    successCount++;
-                }
-                else {
-                    failedFiles.push_back(fname);
-                }
-            }
-
-            // Handle existing files based on user choice
-            for (const auto& fname : existingFiles) {
-                if (conflictAction == FileConflictAction::Skip) {
-                    skipCount++;
-                    continue;
-                }
-
-                std::wstring fullPath = explorerPath + L"\\" + fname;
-                std::wstring finalPath = fullPath;
+    SingleFileResult result = CreateSingleFile(explorerPath, plan.filename, plan.content, action, settings.app.writeOptions, settings.app.durability);
+    if (result.skipped) return true; // User chose to skip, don't create file
 
-                if (conflictAction == FileConflictAction::Rename) {
-                    finalPath = GenerateUniqueFilename(fullPath);
-                    HANDLE hFile = CreateFileW(finalPath.c_str(), GENERIC_WRITE, 0, NULL,
-                        CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
-                    if (hFile != INVALID_HANDLE_VALUE) {
-                        CloseHandle(hFile);
-                        successCount++;
-                    }
-                    else {
-                        failedFiles.push_back(fname);
-                    }
-                }
-                else if (conflictAction == FileConflictAction::Replace) {
-                    if (CreateEmptyFileAtomic(finalPath)) {
-                        successCount++;
-                    }
-                    else {
-                        failedFiles.push_back(fname);
-                    }
-                }
-            }
-
-            // Show results to user
-            std::wstring resultMessage;
-            if (successCount > 0) {
-                resultMessage = L"Successfully created " + std::to_wstring(successCount) + L" files";
-                if (skipCount > 0) {
-                    resultMessage += L", skipped " + std::to_wstring(skipCount) + L" existing files";
-                }
-                if (!failedFiles.empty()) {
-                    resultMessage += L", failed to create " + std::to_wstring(failedFiles.size()) + L" files";
-                }
-                ShowToastNotification(g_hMainWnd, L"Multiple Files Created", resultMessage, NIIF_INFO);
-            }
-            else {
-                resultMessage = L"No files were created";
-                if (skipCount > 0) {
-                    resultMessage += L" (" + std::to_wstring(skipCount) + L" files were skipped)";
-                }
-                if (!failedFiles.empty()) {
-                    resultMessage += L" (" + std::to_wstring(failedFiles.size()) + L" files failed)";
-                }
-                ShowToastNotification(g_hMainWnd, L"File Creation", resultMessage, NIIF_WARNING);
-            }
-
-            return successCount > 0;
-        }
-    }
-
-    // If not multiple files or only found one filename, proceed with original single file logic
-    if (format_detected) {
-        filename.erase(0, filename.find_first_not_of(L" \t\n\r"));
-        filename.erase(filename.find_last_not_of(L" \t\n\r") + 1);
-        if (!IsValidFilename(filename)) {
-            return true; // Detected a pattern but filename is invalid. Stop all further processing.
+    if (result.success) {
+        created = true;
+        const std::wstring flushNote = result.syncFailed ? L" (could not flush it to disk)" : L"";
+        if (plan.content.empty()) {
+            PostToastNotification(L"File Created", L"Created empty file: " + result.finalName + flushNote, NIIF_INFO);
         }
-
-        std::wstring explorerPath = GetSingleExplorerPath();
-        if (!explorerPath.empty()) {
-            std::wstring fullPath = explorerPath + L"\\" + filename;
-            std::wstring finalPath = fullPath;
-
-            // Check if file exists and handle conflict
-            if (GetFileAttributesW(fullPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-                FileConflictAction action = ShowFileConflictDialog(filename);
-
-                switch (action) {
-                case FileConflictAction::Skip:
-                    return true; // User chose to skip, don't create file
-                case FileConflictAction::Rename:
-                    finalPath = GenerateUniqueFilename(fullPath);
-                    // Extract just the filename for the success message
-                    wchar_t fname[_MAX_FNAME];
-                    wchar_t ext[_MAX_EXT];
-                    _wsplitpath_s(finalPath.c_str(), NULL, 0, NULL, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
-                    filename = std::wstring(fname) + ext;
-                    break;
-                case FileConflictAction::Replace:
-                    // Will use atomic replacement
-                    break;
-                }
-            }
-
-            bool success = false;
-
-            if (content.empty()) {
-                // Create empty file (single-line content or multi-line with empty content)
-                if (GetFileAttributesW(finalPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-                    success = CreateEmptyFileAtomic(finalPath);
-                }
-                else {
-                    HANDLE hFile = CreateFileW(finalPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
-                    if (hFile != INVALID_HANDLE_VALUE) {
-                        CloseHandle(hFile);
-                        success = true;
-                    }
-                }
-
-                if (success) {
-                    std::wstring successMessage = L"Created empty file: " + filename;
-                    ShowToastNotification(g_hMainWnd, L"File Created", successMessage, NIIF_INFO);
-                }
-            }
-            else {
-                // Create file with content (multi-line content)
-                if (GetFileAttributesW(finalPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-                    success = CreateFileWithContentAtomic(finalPath, content);
-                }
-                else {
-                    std::wofstream outFile(finalPath);
-                    if (outFile.is_open()) {
-                        outFile << content;
-                        outFile.close();
-                        success = !outFile.fail();
-                    }
-                }
-
-                if (success) {
-                    std::wstring successMessage = L"Generated file with content: " + filename;
-                    ShowToastNotification(g_hMainWnd, L"File Generated", successMessage, NIIF_INFO);
-                }
-            }
-
-            return success;
+        else {
+            PostToastNotification(L"File Generated", L"Generated file with content: " + result.finalName + flushNote, NIIF_INFO);
         }
     }
-    return false;
+    return result.success;
 }
 
-// Helper function for atomic file replacement with content
-bool CreateFileWithContentAtomic(const std::wstring& targetPath, const std::wstring& content) {
-    // Generate temporary filename in same directory
-    wchar_t drive[_MAX_DRIVE];
-    wchar_t dir[_MAX_DIR];
-    wchar_t fname[_MAX_FNAME];
-    wchar_t ext[_MAX_EXT];
-
-    _wsplitpath_s(targetPath.c_str(), drive, _MAX_DRIVE, dir, _MAX_DIR, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-    // Create temporary filename
-    std::wstring tempPath;
-    int counter = 0;
-    do {
-        std::wstringstream ss;
-        ss << drive << dir << fname << L"_tmp_" << counter << ext;
-        tempPath = ss.str();
-        counter++;
-    } while (GetFileAttributesW(tempPath.c_str()) != INVALID_FILE_ATTRIBUTES && counter < 1000);
-
-    if (counter >= 1000) {
-        return false; // Couldn't generate unique temp name
-    }
-
-    // Create the temporary file with content
-    std::wofstream tempFile(tempPath);
-    if (!tempFile.is_open()) {
-        return false;
-    }
-
-    tempFile << content;
-    tempFile.close();
-
-    // Check if write was successful
-    if (tempFile.fail()) {
-        DeleteFileW(tempPath.c_str());
-        return false;
-    }
-
-    // Atomically replace the original file with the temporary file
-    if (MoveFileExW(tempPath.c_str(), targetPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
-        return true;
-    }
-    else {
-        // If atomic replacement failed, clean up the temporary file
-        DeleteFileW(tempPath.c_str());
-        return false;
-    }
-}
-
-// Helper function for atomic file replacement
-bool CreateEmptyFileAtomic(const std::wstring& targetPath) {
-    // Generate temporary filename in same directory
-    wchar_t drive[_MAX_DRIVE];
-    wchar_t dir[_MAX_DIR];
-    wchar_t fname[_MAX_FNAME];
-    wchar_t ext[_MAX_EXT];
-
-    _wsplitpath_s(targetPath.c_str(), drive, _MAX_DRIVE, dir, _MAX_DIR, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-    // Create temporary filename
-    std::wstring tempPath;
-    int counter = 0;
-    do {
-        std::wstringstream ss;
-        ss << drive << dir << fname << L"_tmp_" << counter << ext;
-        tempPath = ss.str();
-        counter++;
-    } while (GetFileAttributesW(tempPath.c_str()) != INVALID_FILE_ATTRIBUTES && counter < 1000);
-
-    if (counter >= 1000) {
-        return false; // Couldn't generate unique temp name
-    }
-
-    // Create the temporary empty file
-    HANDLE hTempFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hTempFile == INVALID_HANDLE_VALUE) {
-        return false;
-    }
-    CloseHandle(hTempFile);
-
-    // Atomically replace the original file with the temporary file
-    if (MoveFileExW(tempPath.c_str(), targetPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
-        return true;
-    }
-    else {
-        // If atomic replacement failed, clean up the temporary file
-        DeleteFileW(tempPath.c_str());
-        return false;
-    }
-}
-
-// Main dispatcher called on every clipboard change.
+// Main dispatcher called on every clipboard change (UI thread). Only snapshots the update: the
+// bounded early reject runs on the locked buffer, and accepted candidates are copied and handed
+// to ClipboardWorkerThread, so parsing, COM, dialogs and file I/O never block the message loop.
 void ProcessClipboardChange()
 {
+    // Repeated notifications for a clipboard that has not changed since
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (sequence != 0 && sequence == g_lastClipboardSequence) return;
+    g_lastClipboardSequence = sequence;
+
     if (!IsClipboardFormatAvailable(CF_UNICODETEXT) || !OpenClipboard(g_hMainWnd)) return;
     HANDLE hData = GetClipboardData(CF_UNICODETEXT);
     if (hData == NULL) { CloseClipboard(); return; }
 
     wchar_t* pszText = static_cast<wchar_t*>(GlobalLock(hData));
     if (pszText == NULL) { CloseClipboard(); return; }
-    std::wstring clipboardText(pszText);
+    // Bounded by the allocation in case the data is not terminated
+    std::wstring_view clipboardView(pszText, wcsnlen(pszText, GlobalSize(hData) / sizeof(wchar_t)));
+
+    // One snapshot for the whole event; a concurrent config reload publishes a new one.
+    std::shared_ptr<const EngineSettings> settings = CaptureEngineSettings();
+
+    std::unique_ptr<ClipboardEvent> event;
+    if (settings && IsCandidatePayload(clipboardView, *settings)) {
+        event.reset(new ClipboardEvent{ std::wstring(clipboardView), settings });
+    }
     GlobalUnlock(hData);
     CloseClipboard();
 
-    // Try directory structure creation first
-    if (TryDirectoryStructureCreation(clipboardText)) {
+    if (event) {
+        g_clipboardQueue.Push(std::move(event)); // Replaces an update the worker has not started
+        SetEvent(g_hClipboardEvent);
+    }
+}
+
+// Classifies and materializes one snapshotted update (worker thread).
+void HandleClipboardEvent(const ClipboardEvent& event)
+{
+    const EngineSettings& settings = *event.settings;
+
+    // Same text as a recent update: re-asserted by another app, or already known not to be a file
+    uint64_t fingerprint = FingerprintPayload(event.text);
+    ULONGLONG now = GetTickCount64();
+    if (g_payloadCache.IsDuplicate(fingerprint, event.settings, now)) return;
+
+    LineIndex lines(event.text); // Split once; shared by every detector and parser
+    DirectoryStructurePlan structure;
+    FileGenerationPlan files;
+    bool hasStructure = PlanDirectoryStructure(lines, settings, structure);
+    if (!hasStructure) files = PlanFileGeneration(lines, settings);
+
+    bool candidate = hasStructure || files.kind == FileGenerationKind::SingleFile || files.kind == FileGenerationKind::MultipleFiles;
+    if (!candidate) {
+        g_payloadCache.Remember(fingerprint, PayloadVerdict::NotAFile, now);
         return;
     }
 
-    // Fall back to file generation
-    TryFileGeneration(clipboardText);
+    // Try directory structure creation first, then fall back to file generation
+    bool created = false;
+    if (!hasStructure || !TryDirectoryStructureCreation(structure, settings, created)) {
+        if (hasStructure) files = PlanFileGeneration(lines, settings);
+        TryFileGeneration(files, settings, created);
+    }
+
+    // Only a paste that wrote something is final; after a failure, a missing Explorer window or a
+    // cancelled dialog, copying the same text again retries it
+    if (created) g_payloadCache.Remember(fingerprint, PayloadVerdict::Handled, now);
 }
 
 // Uses COM to find and return the path of a single open File Explorer window.
@@ -1598,16 +854,9 @@ std::wstring GetSingleExplorerPath()
     std::vector<std::wstring> paths;
     IShellWindows* pShellWindows = NULL;
 
-    // Check if COM is initialized, fallback to per-call initialization if not
-    if (!g_bComInitialized) {
-        if (SUCCEEDED(CoInitialize(NULL))) {
-            g_bComInitialized = true; // Set flag so future calls know COM is ready
-            // Don't call CoUninitialize() - leave COM initialized for future calls!
-        }
-        else {
-            return L""; // COM initialization failed
-        }
-    }
+    // COM is initialized by the thread that calls this (ClipboardWorkerThread); without it there
+    // is no Explorer window to ask
+    if (!t_comInitialized) return L"";
 
     HRESULT hr = CoCreateInstance(CLSID_ShellWindows, NULL, CLSCTX_ALL, IID_IShellWindows, (void**)&pShellWindows);
     if (SUCCEEDED(hr)) {
@@ -1678,16 +927,17 @@ void ShowContextMenu(HWND hwnd)
 {
     POINT pt; GetCursorPos(&pt);
     HMENU hMenu = CreatePopupMenu();
-    if (hMenu) {
-        std::lock_guard<std::mutex> lock(g_extensionsMutex);
+    std::shared_ptr<const EngineSettings> snapshot = CaptureEngineSettings();
+    if (hMenu && snapshot) {
+        const AppSettings& settings = snapshot->app;
 
-        UINT emptyFlags = g_settings.isCreateEmptyFileEnabled ? MF_STRING | MF_CHECKED : MF_STRING | MF_UNCHECKED;
+        UINT emptyFlags = settings.isCreateEmptyFileEnabled ? MF_STRING | MF_CHECKED : MF_STRING | MF_UNCHECKED;
         InsertMenu(hMenu, 0, MF_BYPOSITION | emptyFlags, ID_MENU_TOGGLE_EMPTY, L"Create Empty File");
 
-        UINT contentFlags = g_settings.isCreateWithContentEnabled ? MF_STRING | MF_CHECKED : MF_STRING | MF_UNCHECKED;
+        UINT contentFlags = settings.isCreateWithContentEnabled ? MF_STRING | MF_CHECKED : MF_STRING | MF_UNCHECKED;
         InsertMenu(hMenu, 1, MF_BYPOSITION | contentFlags, ID_MENU_TOGGLE_CONTENT, L"Create File with Content");
 
-        UINT dirFlags = g_settings.isCreateDirectoryStructureEnabled ? MF_STRING | MF_CHECKED : MF_STRING | MF_UNCHECKED;
+        UINT dirFlags = settings.isCreateDirectoryStructureEnabled ? MF_STRING | MF_CHECKED : MF_STRING | MF_UNCHECKED;
         InsertMenu(hMenu, 2, MF_BYPOSITION | dirFlags, ID_MENU_TOGGLE_DIRECTORY, L"Create Directory Structure");
 
         InsertMenu(hMenu, 3, MF_SEPARATOR, 0, NULL);
@@ -1704,6 +954,15 @@ void ShowContextMenu(HWND hwnd)
     }
 }
 
+// Hands a toast to the UI thread; used by the clipboard worker.
+void PostToastNotification(const std::wstring& title, const std::wstring& msg, DWORD iconType)
+{
+    ToastMessage* toast = new ToastMessage{ title, msg, iconType };
+    if (!PostMessage(g_hMainWnd, WM_APP_SHOW_TOAST, 0, reinterpret_cast<LPARAM>(toast))) {
+        delete toast;
+    }
+}
+
 // Displays a toast notification from the tray icon.
 void ShowToastNotification(HWND hwnd, const std::wstring& title, const std::wstring& msg, DWORD iconType)
 {
@@ -1713,8 +972,9 @@ void ShowToastNotification(HWND hwnd, const std::wstring& title, const std::wstr
     nid.uID = ID_TRAY_ICON;
     nid.uFlags = NIF_INFO;
     nid.dwInfoFlags = iconType;
-    wcscpy_s(nid.szInfoTitle, title.c_str());
-    wcscpy_s(nid.szInfo, msg.c_str());
+    // The fields hold 64 and 256 characters; a message naming a long path is cut short
+    wcsncpy_s(nid.szInfoTitle, title.c_str(), _TRUNCATE);
+    wcsncpy_s(nid.szInfo, msg.c_str(), _TRUNCATE);
     Shell_NotifyIconW(NIM_MODIFY, &nid);
 }
 
@@ -1753,245 +1013,3 @@ void SetStartup(bool enable)
         RegCloseKey(hKey);
     }
 }
-
-//------------------------------------------------------------------------------------------------//
-//                          FILE/DIRECTORY SECURITY & PATH VALIDATION                             //
-//------------------------------------------------------------------------------------------------//
-
-bool IsPathSafe(const std::wstring& path) {
-    // Check for path traversal
-    if (path.find(L"..\\") != std::wstring::npos || path.find(L"../") != std::wstring::npos) {
-        return false;
-    }
-
-    // Check for absolute paths
-    if (path.length() >= 2 && path[1] == L':') return false;
-    if (path[0] == L'\\' || path[0] == L'/') return false;
-
-    // Check for UNC paths
-    if (path.length() >= 2 && path[0] == L'\\' && path[1] == L'\\') return false;
-
-    return true;
-}
-
-void GetTreeSummary(const TreeNode* node, int& dirCount, int& fileCount) {
-    if (!node) return;
-
-    if (node->isDirectory && node->name != L"root") {
-        dirCount++;
-    }
-    else if (!node->isDirectory) {
-        fileCount++;
-    }
-
-    for (const auto& child : node->children) {
-        GetTreeSummary(child.get(), dirCount, fileCount);
-    }
-}
-
-// Comprehensive filename validation to prevent security issues and filesystem errors
-bool IsValidFilename(const std::wstring& filename)
-{
-    // Check for empty filename
-    if (filename.empty()) {
-        return false;
-    }
-
-    // Check filename length (Windows has a 255 character limit for filenames)
-    if (filename.length() > 255) {
-        return false;
-    }
-
-    // Check for path traversal attempts
-    if (filename.find(L"../") != std::wstring::npos || filename.find(L"..\\") != std::wstring::npos) {
-        return false;
-    }
-
-    // Check for absolute paths (should only be relative filenames)
-    if (filename.length() >= 2 && filename[1] == L':') { // Drive letter (C:, D:, etc.)
-        return false;
-    }
-    if (filename[0] == L'\\' || filename[0] == L'/') { // UNC paths or root paths
-        return false;
-    }
-
-    // Check for invalid characters in Windows filenames
-    const wchar_t* invalidChars = L"\\/:*?\"<>|";
-    if (filename.find_first_of(invalidChars) != std::wstring::npos) {
-        return false;
-    }
-
-    // Check for control characters (0x00-0x1F)
-    for (wchar_t c : filename) {
-        if (c >= 0x00 && c <= 0x1F) {
-            return false;
-        }
-    }
-
-    // Check for reserved Windows device names (case-insensitive)
-    std::wstring upperFilename = filename;
-    std::transform(upperFilename.begin(), upperFilename.end(), upperFilename.begin(), ::towupper);
-
-    // Extract base name without extension for reserved name checking
-    std::wstring baseName = upperFilename;
-    size_t dotPos = baseName.find_last_of(L'.');
-    if (dotPos != std::wstring::npos) {
-        baseName = baseName.substr(0, dotPos);
-    }
-
-    // Check basic reserved device names
-    const std::vector<std::wstring> basicReservedNames = {
-        L"CON", L"PRN", L"AUX", L"NUL"
-    };
-
-    for (const auto& reserved : basicReservedNames) {
-        if (baseName == reserved) {
-            return false;
-        }
-    }
-
-    // Check COM ports (COMx where x is any number)
-    if (baseName.length() >= 4 && baseName.substr(0, 3) == L"COM") {
-        std::wstring numberPart = baseName.substr(3);
-        if (!numberPart.empty() && std::all_of(numberPart.begin(), numberPart.end(), ::iswdigit)) {
-            return false;
-        }
-    }
-
-    // Check LPT ports (LPTx where x is any number)
-    if (baseName.length() >= 4 && baseName.substr(0, 3) == L"LPT") {
-        std::wstring numberPart = baseName.substr(3);
-        if (!numberPart.empty() && std::all_of(numberPart.begin(), numberPart.end(), ::iswdigit)) {
-            return false;
-        }
-    }
-
-    // Check for filenames ending with period (not allowed in Windows)
-    // Note: Leading/trailing spaces are handled by trimming before this function is called
-    if (filename.back() == L'.') {
-        return false;
-    }
-
-    // Additional check: ensure filename doesn't contain only dots
-    bool onlyDots = true;
-    for (wchar_t c : filename) {
-        if (c != L'.') {
-            onlyDots = false;
-            break;
-        }
-    }
-    if (onlyDots) {
-        return false;
-    }
-
-    return true;
-}
-
-// Smart search for additional filenames using line logic
-std::vector<std::wstring> FindAdditionalFilenames(const std::wstring& text, size_t startPos) {
-    std::vector<std::wstring> filenames;
-
-    // Split remaining text into lines
-    std::vector<std::wstring> lines;
-    std::wstringstream ss(text.substr(startPos));
-    std::wstring line;
-
-    while (std::getline(ss, line)) {
-        // Trim whitespace from line
-        line.erase(0, line.find_first_not_of(L" \t\r"));
-        line.erase(line.find_last_not_of(L" \t\r") + 1);
-        lines.push_back(line);
-    }
-
-    if (lines.empty()) return filenames;
-
-    // Check first line for multiple space-separated filenames
-    std::wstringstream firstLineStream(lines[0]);
-    std::wstring word;
-    int wordsInFirstLine = 0;
-    std::vector<std::wstring> firstLineFilenames;
-
-    while (firstLineStream >> word) {
-        wordsInFirstLine++;
-        if (IsValidFilename(word)) {
-            // Check if it has a valid extension
-            wchar_t ext[_MAX_EXT];
-            _wsplitpath_s(word.c_str(), NULL, 0, NULL, 0, NULL, 0, ext, _MAX_EXT);
-            std::wstring extension(ext);
-            std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
-
-            bool isAllowedExtension = false;
-            int wordCountLimit;
-            {
-                std::lock_guard<std::mutex> lock(g_extensionsMutex);
-                wordCountLimit = g_settings.heuristicWordCountLimit;
-                for (const auto& allowedExt : g_settings.allowedExtensions) {
-                    if (extension == allowedExt) {
-                        isAllowedExtension = true;
-                        break;
-                    }
-                }
-            }
-
-            if (isAllowedExtension && CountWords(word) <= wordCountLimit) {
-                firstLineFilenames.push_back(word);
-            }
-        }
-    }
-
-    // If we found multiple space-separated filenames in first line, return those
-    if (firstLineFilenames.size() > 1) {
-        return firstLineFilenames;
-    }
-
-    // If first line had exactly one valid filename, add it and continue checking other lines
-    if (firstLineFilenames.size() == 1) {
-        filenames.push_back(firstLineFilenames[0]);
-    }
-
-    // Check subsequent lines one by one
-    for (size_t i = 1; i < lines.size(); ++i) {
-        if (lines[i].empty()) {
-            // Empty line - skip and continue checking
-            continue;
-        }
-        else {
-            // Line has content - check if it's a valid filename
-            if (IsValidFilename(lines[i])) {
-                // Check if it has a valid extension
-                wchar_t ext[_MAX_EXT];
-                _wsplitpath_s(lines[i].c_str(), NULL, 0, NULL, 0, NULL, 0, ext, _MAX_EXT);
-                std::wstring extension(ext);
-                std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
-
-                bool isAllowedExtension = false;
-                int wordCountLimit;
-                {
-                    std::lock_guard<std::mutex> lock(g_extensionsMutex);
-                    wordCountLimit = g_settings.heuristicWordCountLimit;
-                    for (const auto& allowedExt : g_settings.allowedExtensions) {
-                        if (extension == allowedExt) {
-                            isAllowedExtension = true;
-                            break;
-                        }
-                    }
-                }
-
-                if (isAllowedExtension && CountWords(lines[i]) <= wordCountLimit) {
-                    filenames.push_back(lines[i]);
-                    // Continue checking next lines
-                }
-                else {
-                    // Not a valid filename - stop searching
-                    break;
-                }
-            }
-            else {
-                // Line has content but isn't a valid filename - stop searching
-                break;
-            }
-        }
-    }
-
-    return filenames;
-}
\ No newline at end of file
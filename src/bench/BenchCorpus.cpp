@@ -0,0 +1,164 @@
+//================================================================================================//
+//                              Clipboard To File - Benchmark corpus                              //
+//                                                                                                //
+//  Synthetic but realistic payloads. Everything is generated from fixed seeds so numbers are    //
+//  comparable between runs and machines.                                                         //
+//================================================================================================//
+#include <cwchar>
+#include "BenchHarness.h"
+
+
+namespace {
+
+// Small xorshift generator; std::mt19937 would be overkill and slower to seed.
+struct Rng {
+    uint32_t state;
+    explicit Rng(uint32_t seed) : state(seed ? seed : 0x9E3779B9u) {}
+    uint32_t Next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint32_t Below(uint32_t n) { return Next() % n; }
+};
+
+const wchar_t* const kWords[] = {
+    L"the", L"clipboard", L"file", L"explorer", L"window", L"content", L"quickly", L"create",
+    L"a", L"of", L"and", L"to", L"in", L"is", L"that", L"with", L"for", L"as", L"was", L"on",
+    L"developer", L"snippet", L"directory", L"structure", L"paste", L"copy", L"when", L"which",
+    L"performance", L"latency", L"throughput", L"measure", L"before", L"after", L"every", L"change",
+};
+
+const wchar_t* const kCodeTokens[] = {
+    L"function", L"var", L"return", L"if", L"else", L"for", L"(", L")", L"{", L"}", L";", L"=",
+    L"==", L"&&", L"||", L"+", L"-", L"*", L"/", L"a", L"b", L"c", L"e", L"t", L"n", L"0", L"1",
+    L"this", L"null", L"new", L"Array", L".push", L".length", L"\"use strict\"", L",", L":",
+};
+
+template <size_t N>
+const wchar_t* Pick(Rng& rng, const wchar_t* const (&table)[N]) {
+    return table[rng.Below(static_cast<uint32_t>(N))];
+}
+
+std::wstring MakeCodeBlock(size_t lines) {
+    std::wstring code;
+    for (size_t i = 0; i < lines; ++i) {
+        code += L"int helper" + std::to_wstring(i) + L"(int value) { return value * " + std::to_wstring(i) + L"; }\n";
+    }
+    return code;
+}
+
+} // namespace
+
+
+std::wstring MakeProse(size_t chars, uint32_t seed) {
+    Rng rng(seed);
+    std::wstring text;
+    text.reserve(chars + 64);
+    size_t sentenceWords = 0;
+    size_t lineChars = 0;
+    while (text.size() < chars) {
+        const wchar_t* word = Pick(rng, kWords);
+        text += word;
+        lineChars += wcslen(word);
+        if (++sentenceWords >= 8 + rng.Below(10)) {
+            text += L". ";
+            sentenceWords = 0;
+        }
+        else {
+            text += L' ';
+        }
+        if (lineChars > 70) {
+            text += L'\n';
+            if (rng.Below(6) == 0) text += L'\n'; // Paragraph break
+            lineChars = 0;
+        }
+    }
+    return text;
+}
+
+std::wstring MakeMinifiedCode(size_t chars, uint32_t seed) {
+    Rng rng(seed);
+    std::wstring text;
+    text.reserve(chars + 64);
+    while (text.size() < chars) {
+        text += Pick(rng, kCodeTokens);
+    }
+    return text; // One enormous line, like real minified bundles
+}
+
+std::wstring MakeTreeCommandListing(size_t entries) {
+    std::wstring text = L"project/\n";
+    const std::wstring tee = std::wstring(1, wchar_t(0x251C)) + wchar_t(0x2500) + wchar_t(0x2500) + L" ";
+    const std::wstring elbow = std::wstring(1, wchar_t(0x2514)) + wchar_t(0x2500) + wchar_t(0x2500) + L" ";
+    const std::wstring pipe = std::wstring(1, wchar_t(0x2502)) + L"   ";
+    const size_t filesPerDir = 8;
+    size_t dirs = (entries + filesPerDir) / (filesPerDir + 1);
+    for (size_t d = 0; d < dirs; ++d) {
+        bool lastDir = (d + 1 == dirs);
+        text += (lastDir ? elbow : tee) + L"module" + std::to_wstring(d) + L"/\n";
+        for (size_t f = 0; f < filesPerDir; ++f) {
+            bool lastFile = (f + 1 == filesPerDir);
+            text += (lastDir ? L"    " : pipe) + (lastFile ? elbow : tee) + L"source" + std::to_wstring(f) + L".cpp\n";
+        }
+    }
+    return text;
+}
+
+std::wstring MakeIndentedListing(size_t entries) {
+    std::wstring text = L"project/\n";
+    const size_t filesPerDir = 8;
+    size_t dirs = (entries + filesPerDir) / (filesPerDir + 1);
+    for (size_t d = 0; d < dirs; ++d) {
+        text += L"  module" + std::to_wstring(d) + L"/\n";
+        for (size_t f = 0; f < filesPerDir; ++f) {
+            text += L"    source" + std::to_wstring(f) + L".cpp\n";
+        }
+    }
+    return text;
+}
+
+std::wstring MakePathList(size_t entries, size_t filesPerDirectory) {
+    std::wstring text;
+    if (filesPerDirectory == 0) filesPerDirectory = 1;
+    for (size_t i = 0; i < entries; ++i) {
+        size_t dir = i / filesPerDirectory;
+        text += L"repo/src/module" + std::to_wstring(dir % 64) + L"/part" + std::to_wstring(dir) +
+            L"/file" + std::to_wstring(i) + L".cpp\n";
+    }
+    return text;
+}
+
+std::wstring MakeEnhancedListing(size_t files, size_t linesPerFile) {
+    std::wstring text = L"project/\n  src/\n";
+    for (size_t f = 0; f < files; ++f) {
+        text += L"    unit" + std::to_wstring(f) + L".cpp\n";
+    }
+    std::wstring body = MakeCodeBlock(linesPerFile);
+    for (size_t f = 0; f < files; ++f) {
+        std::wstring name = L"unit" + std::to_wstring(f) + L".cpp";
+        text += L"---START: " + name + L"---\n" + body + L"---END: " + name + L"---\n";
+    }
+    return text;
+}
+
+std::vector<CorpusEntry> BuildCorpus(const BenchOptions& options) {
+    const size_t largeChars = options.largeMb * 1024 * 1024 / sizeof(wchar_t);
+    std::vector<CorpusEntry> corpus;
+    corpus.push_back({ "single-filename", L"new_component.js", true });
+    corpus.push_back({ "filename-with-content", L"notes.md remember to update the changelog before release", true });
+    corpus.push_back({ "multiple-filenames", L"index.js\nstyle.md\nREADME.txt\nnotes.log\n", true });
+    corpus.push_back({ "start-of-file-block", L"// --- START OF FILE: app.cpp ---\n" + MakeCodeBlock(200), true });
+    corpus.push_back({ "file-prefix-block", L"file: config.json\n{ \"enabled\": true, \"retries\": 3 }\n", true });
+    corpus.push_back({ "tree-command-1k", MakeTreeCommandListing(1000), true });
+    corpus.push_back({ "indentation-1k", MakeIndentedListing(1000), true });
+    corpus.push_back({ "path-list-1k", MakePathList(1000, 10), true });
+    corpus.push_back({ "path-list-20k", MakePathList(20000, 50), true });
+    corpus.push_back({ "enhanced-100x20", MakeEnhancedListing(100, 20), true });
+    corpus.push_back({ "enhanced-2000x20", MakeEnhancedListing(2000, 20), true });
+    corpus.push_back({ "prose-4k", MakeProse(4096, 7), false });
+    corpus.push_back({ "prose-" + std::to_string(options.largeMb) + "mb", MakeProse(largeChars, 11), false });
+    corpus.push_back({ "minified-" + std::to_string(options.largeMb) + "mb", MakeMinifiedCode(largeChars, 13), false });
+    return corpus;
+}
@@ -0,0 +1,104 @@
+//================================================================================================//
+//                              Clipboard To File - Benchmark harness                             //
+//================================================================================================//
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "BenchHarness.h"
+
+
+//------------------------------------------------------------------------------------------------//
+//                                   ALLOCATION COUNTING                                          //
+//------------------------------------------------------------------------------------------------//
+static std::atomic<uint64_t> g_allocCount{ 0 };
+static std::atomic<uint64_t> g_allocBytes{ 0 };
+static std::atomic<uint64_t> g_liveBytes{ 0 };
+static std::atomic<uint64_t> g_peakBytes{ 0 };
+
+// Every block carries its size in front, so delete knows how much is released.
+static const size_t kAllocHeader = 16;
+
+static void* TrackedAlloc(std::size_t size) {
+    void* block = std::malloc(size + kAllocHeader);
+    if (!block) return nullptr;
+    *static_cast<std::size_t*>(block) = size;
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    const uint64_t live = g_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = g_peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return static_cast<char*>(block) + kAllocHeader;
+}
+
+static void TrackedFree(void* p) {
+    if (!p) return;
+    void* block = static_cast<char*>(p) - kAllocHeader;
+    g_liveBytes.fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = TrackedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return TrackedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { TrackedFree(p); }
+void operator delete[](void* p) noexcept { TrackedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { TrackedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { TrackedFree(p); }
+
+AllocCounters ReadAllocCounters() {
+    AllocCounters counters;
+    counters.count = g_allocCount.load(std::memory_order_relaxed);
+    counters.bytes = g_allocBytes.load(std::memory_order_relaxed);
+    counters.liveBytes = g_liveBytes.load(std::memory_order_relaxed);
+    counters.peakBytes = g_peakBytes.load(std::memory_order_relaxed);
+    return counters;
+}
+
+void ResetAllocPeak() {
+    g_peakBytes.store(g_liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                        REPORTING                                               //
+//------------------------------------------------------------------------------------------------//
+bool BenchSelected(const BenchOptions& options, const std::string& caseName, const std::string& stage) {
+    if (options.filter.empty()) return true;
+    return (caseName + "/" + stage).find(options.filter) != std::string::npos;
+}
+
+void PrintBenchHeader(const char* title) {
+    std::printf("\n== %s ==\n", title);
+    std::printf("%-28s %-26s %12s %14s %10s %10s %10s\n",
+        "case", "stage", "bytes", "ns/op", "MB/s", "allocs/op", "iters");
+    std::fflush(stdout);
+}
+
+void PrintBenchRow(const std::string& caseName, const std::string& stage, size_t bytesPerOp,
+    double nsPerOp, double allocsPerOp, uint64_t iterations) {
+    double mbPerSec = (bytesPerOp > 0 && nsPerOp > 0) ? (bytesPerOp / (nsPerOp * 1e-9)) / (1024.0 * 1024.0) : 0.0;
+    std::printf("%-28s %-26s %12zu %14.1f %10.1f %10.1f %10llu\n",
+        caseName.c_str(), stage.c_str(), bytesPerOp, nsPerOp, mbPerSec, allocsPerOp,
+        static_cast<unsigned long long>(iterations));
+    std::fflush(stdout);
+}
+
+void PrintBenchNote(const std::string& caseName, const std::string& stage, const std::string& note) {
+    std::printf("%-28s %-26s %s\n", caseName.c_str(), stage.c_str(), note.c_str());
+    std::fflush(stdout);
+}
@@ -0,0 +1,114 @@
+//================================================================================================//
+//                              Clipboard To File - Benchmark harness                             //
+//                                                                                                //
+//  Minimal, dependency-free timing loop. Every row reports ns/op, throughput and heap            //
+//  allocations per op (counted by the global operator new replacement in BenchHarness.cpp).      //
+//================================================================================================//
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+struct BenchOptions {
+    double minTimeMs = 200.0;     // Minimum measured time per row
+    size_t largeMb = 4;           // Size of the multi-MB corpus entries
+    std::string filter;           // Only run rows whose "case/stage" contains this
+    std::string scratchDir;       // Where filesystem suites may create files
+};
+
+struct AllocCounters {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t liveBytes = 0;     // Allocated and not yet freed
+    uint64_t peakBytes = 0;     // Highest liveBytes since the last ResetAllocPeak
+};
+
+// Snapshot of the process-wide allocation counters.
+AllocCounters ReadAllocCounters();
+
+// Starts a new peak measurement from what is live now.
+void ResetAllocPeak();
+
+// Prevents the optimizer from discarding a computed value.
+template <class T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile void* sink = &value;
+    (void)sink;
+#endif
+}
+
+bool BenchSelected(const BenchOptions& options, const std::string& caseName, const std::string& stage);
+void PrintBenchHeader(const char* title);
+void PrintBenchRow(const std::string& caseName, const std::string& stage, size_t bytesPerOp,
+    double nsPerOp, double allocsPerOp, uint64_t iterations);
+void PrintBenchNote(const std::string& caseName, const std::string& stage, const std::string& note);
+
+// Runs fn() repeatedly until minTimeMs has elapsed and prints one result row. Returns ns/op,
+// or a negative value when the case is filtered out.
+template <class Fn>
+double RunBenchmark(const BenchOptions& options, const std::string& caseName, const std::string& stage,
+    size_t bytesPerOp, Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    if (!BenchSelected(options, caseName, stage)) return -1.0;
+
+    fn(); // Warm-up (also faults in lazily built state)
+
+    uint64_t iterations = 1;
+    while (true) {
+        AllocCounters before = ReadAllocCounters();
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) fn();
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        AllocCounters after = ReadAllocCounters();
+
+        if (elapsed >= options.minTimeMs * 1e6 || iterations >= (1ull << 30)) {
+            PrintBenchRow(caseName, stage, bytesPerOp, elapsed / iterations,
+                double(after.count - before.count) / iterations, iterations);
+            return elapsed / iterations;
+        }
+        // Aim for the target time in one more round, growing at most 10x per step.
+        double scale = elapsed > 0 ? (options.minTimeMs * 1e6 * 1.2) / elapsed : 10.0;
+        if (scale > 10.0) scale = 10.0;
+        if (scale < 2.0) scale = 2.0;
+        iterations = static_cast<uint64_t>(iterations * scale);
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                         CORPUS                                                 //
+//------------------------------------------------------------------------------------------------//
+struct CorpusEntry {
+    std::string name;
+    std::wstring payload;
+    bool expectAccepted;   // Whether a human would expect the app to act on this payload
+};
+
+// Deterministic corpus covering every detector plus large payloads that must be rejected.
+std::vector<CorpusEntry> BuildCorpus(const BenchOptions& options);
+
+std::wstring MakeProse(size_t chars, uint32_t seed);
+std::wstring MakeMinifiedCode(size_t chars, uint32_t seed);
+std::wstring MakeTreeCommandListing(size_t entries);
+std::wstring MakeIndentedListing(size_t entries);
+std::wstring MakePathList(size_t entries, size_t filesPerDirectory);
+std::wstring MakeEnhancedListing(size_t files, size_t linesPerFile);
+
+
+//------------------------------------------------------------------------------------------------//
+//                                         SUITES                                                 //
+//------------------------------------------------------------------------------------------------//
+void RunClassificationSuite(const BenchOptions& options);
+void RunPathListSuite(const BenchOptions& options);
+void RunMaterializeSuite(const BenchOptions& options);
+void RunWriteSuite(const BenchOptions& options);
+void RunLargeWriteSuite(const BenchOptions& options);
+void RunTranscodeSuite(const BenchOptions& options);
+void RunReplaceSuite(const BenchOptions& options);
+void RunStreamSuite(const BenchOptions& options);
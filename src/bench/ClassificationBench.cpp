@@ -0,0 +1,164 @@
+//================================================================================================//
+//                         Clipboard To File - Classification benchmarks                          //
+//                                                                                                //
+//  Times every stage ProcessClipboardChange runs before touching the filesystem, per corpus     //
+//  entry, and prints the verdict the full pipeline reaches for each entry.                       //
+//================================================================================================//
+#include <cstdio>
+#include "BenchHarness.h"
+#include "ClipboardEngine.h"
+#include "CoalescingQueue.h"
+#include "PayloadCache.h"
+
+
+namespace {
+
+std::wstring FirstLineOf(const std::wstring& text, size_t& nextLineStart) {
+    size_t end = text.find(L'\n');
+    nextLineStart = (end == std::wstring::npos) ? text.length() : end + 1;
+    std::wstring line = text.substr(0, end);
+    line.erase(0, line.find_first_not_of(L" \t\r\n"));
+    line.erase(line.find_last_not_of(L" \t\r\n") + 1);
+    return line;
+}
+
+const char* FormatName(TreeFormat format) {
+    switch (format) {
+    case TreeFormat::TreeCommand: return "TreeCommand";
+    case TreeFormat::Indentation: return "Indentation";
+    case TreeFormat::PathList: return "PathList";
+    case TreeFormat::Enhanced: return "Enhanced";
+    default: return "Unknown";
+    }
+}
+
+const char* KindName(FileGenerationKind kind) {
+    switch (kind) {
+    case FileGenerationKind::InvalidFilename: return "InvalidFilename";
+    case FileGenerationKind::SingleFile: return "SingleFile";
+    case FileGenerationKind::MultipleFiles: return "MultipleFiles";
+    default: return "None";
+    }
+}
+
+// Runs the same decision sequence as ProcessClipboardChange, minus UI and I/O.
+std::string PipelineVerdict(const std::wstring& payload, const EngineSettings& settings) {
+    if (!IsCandidatePayload(payload, settings)) return "None (early reject)";
+    LineIndex lines(payload);
+    DirectoryStructurePlan structure;
+    if (PlanDirectoryStructure(lines, settings, structure)) {
+        return std::string("Structure:") + FormatName(structure.format) + " (" +
+            std::to_string(structure.dirCount) + " dirs, " + std::to_string(structure.fileCount) + " files)";
+    }
+    return KindName(PlanFileGeneration(lines, settings).kind);
+}
+
+} // namespace
+
+
+void RunClassificationSuite(const BenchOptions& options) {
+    EngineSettings settings = CompileEngineSettings(GetDefaultSettings());
+    std::vector<CorpusEntry> corpus = BuildCorpus(options);
+
+    PrintBenchHeader("classification stages");
+    for (const auto& entry : corpus) {
+        const std::wstring& payload = entry.payload;
+        const size_t payloadBytes = payload.size() * sizeof(wchar_t);
+        size_t nextLineStart = 0;
+        const std::wstring firstLine = FirstLineOf(payload, nextLineStart);
+        const size_t firstLineBytes = firstLine.size() * sizeof(wchar_t);
+        const LineIndex lines(payload);
+
+        RunBenchmark(options, entry.name, "IsCandidatePayload", payloadBytes, [&] {
+            DoNotOptimize(IsCandidatePayload(payload, settings));
+        });
+
+        RunBenchmark(options, entry.name, "FingerprintPayload", payloadBytes, [&] {
+            DoNotOptimize(FingerprintPayload(payload));
+        });
+
+        // What a repeated update costs once its fingerprint is cached.
+        auto snapshot = std::make_shared<const EngineSettings>(settings);
+        PayloadCache cache;
+        cache.IsDuplicate(0, snapshot, 0);
+        cache.Remember(FingerprintPayload(payload), PayloadVerdict::NotAFile, 0);
+        RunBenchmark(options, entry.name, "DuplicateCheck", payloadBytes, [&] {
+            DoNotOptimize(cache.IsDuplicate(FingerprintPayload(payload), snapshot, 0));
+        });
+
+        RunBenchmark(options, entry.name, "LineIndex", payloadBytes, [&] {
+            LineIndex index(payload);
+            DoNotOptimize(index.Count());
+        });
+
+        RunBenchmark(options, entry.name, "DetectTreeFormat", payloadBytes, [&] {
+            DoNotOptimize(DetectTreeFormat(lines));
+        });
+
+        TreeFormat format = DetectTreeFormat(lines);
+        if (format != TreeFormat::Unknown) {
+            RunBenchmark(options, entry.name, "ParseTreeStructure", payloadBytes, [&] {
+                DirectoryTree tree;
+                DoNotOptimize(ParseTreeStructure(lines, format, tree));
+                DoNotOptimize(tree.Size());
+            });
+        }
+
+        RunBenchmark(options, entry.name, "MatchContentPattern", firstLineBytes, [&] {
+            std::wstring filename;
+            DoNotOptimize(MatchContentPattern(firstLine, settings, filename));
+        });
+
+        RunBenchmark(options, entry.name, "CountWords", firstLineBytes, [&] {
+            DoNotOptimize(CountWords(firstLine));
+        });
+
+        RunBenchmark(options, entry.name, "IsValidFilename", firstLineBytes, [&] {
+            DoNotOptimize(IsValidFilename(firstLine));
+        });
+
+        RunBenchmark(options, entry.name, "FilenameAcceptor", firstLineBytes, [&] {
+            DoNotOptimize(settings.filenames.Accepts(firstLine));
+        });
+
+        RunBenchmark(options, entry.name, "FindAdditionalFilenames", payloadBytes, [&] {
+            auto names = FindAdditionalFilenames(lines, nextLineStart, settings);
+            DoNotOptimize(names.size());
+        });
+
+        RunBenchmark(options, entry.name, "PlanFileGeneration", payloadBytes, [&] {
+            FileGenerationPlan plan = PlanFileGeneration(lines, settings);
+            DoNotOptimize(plan.kind);
+        });
+        // Includes the early reject and building the line index, as every clipboard event does.
+        RunBenchmark(options, entry.name, "Pipeline", payloadBytes, [&] {
+            if (!IsCandidatePayload(payload, settings)) return;
+            LineIndex index(payload);
+            DirectoryStructurePlan structure;
+            if (!PlanDirectoryStructure(index, settings, structure)) {
+                FileGenerationPlan plan = PlanFileGeneration(index, settings);
+                DoNotOptimize(plan.kind);
+            }
+            DoNotOptimize(structure.tree.Size());
+        });
+
+        // What the UI thread does per update since classification moved to the worker: the
+        // early reject, then a copy handed off through the queue. Pipeline is what it used to run.
+        CoalescingQueue<std::wstring> queue;
+        RunBenchmark(options, entry.name, "UiHandoff", payloadBytes, [&] {
+            if (!IsCandidatePayload(payload, settings)) return;
+            queue.Push(std::unique_ptr<std::wstring>(new std::wstring(payload)));
+            DoNotOptimize(queue.Take().get());
+        });
+    }
+
+    std::printf("\n== pipeline verdicts ==\n");
+    for (const auto& entry : corpus) {
+        if (!options.filter.empty() && entry.name.find(options.filter) == std::string::npos) continue;
+        std::string verdict = PipelineVerdict(entry.payload, settings);
+        bool accepted = verdict.compare(0, 4, "None") != 0;
+        std::printf("%-28s expected %-7s got %s%s\n", entry.name.c_str(),
+            entry.expectAccepted ? "accept" : "reject", verdict.c_str(),
+            accepted == entry.expectAccepted ? "" : "   <-- MISMATCH");
+    }
+}
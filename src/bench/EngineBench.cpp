@@ -0,0 +1,73 @@
+//================================================================================================//
+//                              Clipboard To File - ctf_bench                                     //
+//                                                                                                //
+//  Usage: ctf_bench [--suite NAME] [--filter TEXT] [--min-time-ms N] [--large-mb N]              //
+//                   [--scratch DIR]                                                              //
+//================================================================================================//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "BenchHarness.h"
+
+
+namespace {
+
+struct BenchSuite {
+    const char* name;
+    const char* description;
+    void (*run)(const BenchOptions&);
+};
+
+const BenchSuite kSuites[] = {
+    { "classify", "detectors, parsers and the full classification pipeline", RunClassificationSuite },
+    { "pathlist", "path-list parsing from 1k to 1M lines", RunPathListSuite },
+    { "materialize", "creating 10k-file trees on disk: 1 to 16 threads and io_uring", RunMaterializeSuite },
+    { "write", "encoding and writing 1 to 64 MB of file content", RunWriteSuite },
+    { "largewrite", "1 MB to 1 GB writes with each write strategy", RunLargeWriteSuite },
+    { "transcode", "wide <-> UTF-8 conversion, SIMD and scalar ASCII kernels", RunTranscodeSuite },
+    { "replace", "replacing 1 KB to 100 MB files: temp + rename, O_TMPFILE, in place", RunReplaceSuite },
+    { "stream", "16 MB to 1 GB enhanced payloads: whole tree against streamed, with peak heap", RunStreamSuite },
+};
+
+void PrintUsage() {
+    std::printf("usage: ctf_bench [--suite NAME] [--filter TEXT] [--min-time-ms N] [--large-mb N] [--scratch DIR]\n\nsuites:\n");
+    for (const auto& suite : kSuites) {
+        std::printf("  %-12s %s\n", suite.name, suite.description);
+    }
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    std::string suiteName;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--suite" && hasValue) suiteName = argv[++i];
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--min-time-ms" && hasValue) options.minTimeMs = std::atof(argv[++i]);
+        else if (arg == "--large-mb" && hasValue) options.largeMb = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--scratch" && hasValue) options.scratchDir = argv[++i];
+        else {
+            PrintUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    bool ranAny = false;
+    for (const auto& suite : kSuites) {
+        if (!suiteName.empty() && suiteName != suite.name) continue;
+        suite.run(options);
+        ranAny = true;
+    }
+    if (!ranAny) {
+        std::fprintf(stderr, "unknown suite '%s'\n", suiteName.c_str());
+        PrintUsage();
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+//================================================================================================//
+//                              Clipboard To File - Large writes                                  //
+//                                                                                                //
+//  Writes 1 MB to 1 GB of ASCII content with each write strategy (simple, preallocate,          //
+//  streaming) and reports MB/s, plus how much of the file is left in the page cache afterwards  //
+//  (Linux). Each row is the best of a few runs into a fresh file under --scratch (default: the  //
+//  system temp directory). The 1 GB case needs about 2 GB (Windows) or 4 GB (Linux) of memory    //
+//  for the wide content.                                                                         //
+//================================================================================================//
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "BenchHarness.h"
+#include "ClipboardEngine.h"
+#include "Platform.h"
+
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const size_t kSizesMb[] = { 1, 16, 128, 1024 };
+const int kRuns = 3;
+
+const WriteStrategy kStrategies[] = { WriteStrategy::Simple, WriteStrategy::Preallocate, WriteStrategy::Streaming };
+
+// ASCII source of the given length, built by repeating one generated megabyte.
+std::wstring MakeLargeCode(size_t chars) {
+    const std::wstring block = MakeMinifiedCode(1024 * 1024, 29);
+    std::wstring text;
+    text.reserve(chars);
+    while (text.size() < chars) text.append(block, 0, chars - text.size());
+    return text;
+}
+
+// Megabytes of the file held in the page cache, or a negative value where that cannot be measured.
+double CachedMb(const fs::path& file) {
+#ifdef __linux__
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1.0;
+    struct stat st;
+    double cached = -1.0;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        const size_t size = static_cast<size_t>(st.st_size);
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED) {
+            const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            std::vector<unsigned char> resident((size + page - 1) / page);
+            if (mincore(mapping, size, resident.data()) == 0) {
+                size_t pages = 0;
+                for (unsigned char r : resident) pages += r & 1;
+                cached = double(pages * page) / (1024.0 * 1024.0);
+            }
+            munmap(mapping, size);
+        }
+    }
+    close(fd);
+    return cached;
+#else
+    (void)file;
+    return -1.0;
+#endif
+}
+
+} // namespace
+
+
+void RunLargeWriteSuite(const BenchOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    PrintBenchHeader("large writes");
+
+    std::error_code ec;
+    fs::path scratch = options.scratchDir.empty() ? fs::temp_directory_path(ec) / "ctf_bench" : fs::path(options.scratchDir);
+    fs::create_directories(scratch, ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot use scratch directory %s\n", scratch.string().c_str());
+        return;
+    }
+    const fs::path target = scratch / "large.txt";
+
+    // Generated once at the largest selected size; smaller cases write a prefix of it
+    size_t largestMb = 0;
+    for (size_t mb : kSizesMb) {
+        const std::string caseName = std::to_string(mb) + "mb";
+        for (WriteStrategy strategy : kStrategies) {
+            if (BenchSelected(options, caseName, WriteStrategyName(strategy))) largestMb = mb;
+        }
+    }
+    if (largestMb == 0) return;
+    const std::wstring content = MakeLargeCode(largestMb * 1024 * 1024);
+
+    for (size_t mb : kSizesMb) {
+        if (mb > largestMb) break;
+        const std::string caseName = std::to_string(mb) + "mb";
+        const std::wstring_view text = std::wstring_view(content).substr(0, mb * 1024 * 1024);
+
+        for (WriteStrategy strategy : kStrategies) {
+            const char* stage = WriteStrategyName(strategy);
+            if (!BenchSelected(options, caseName, stage)) continue;
+            FsWriteOptions writeOptions;
+            writeOptions.strategy = strategy;
+
+            double bestNs = 0;
+            double cachedMb = -1.0;
+            uint64_t allocs = 0;
+            for (int run = 0; run < kRuns; ++run) {
+                fs::remove(target, ec);
+                const std::wstring path = target.wstring();
+                AllocCounters before = ReadAllocCounters();
+                auto start = Clock::now();
+                bool ok = FsWriteTextFile(path, text, writeOptions);
+                double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+                AllocCounters after = ReadAllocCounters();
+                if (!ok) {
+                    PrintBenchNote(caseName, stage, "FAILED");
+                    bestNs = 0;
+                    break;
+                }
+                if (run == 0 || ns < bestNs) {
+                    bestNs = ns;
+                    allocs = after.count - before.count;
+                    cachedMb = CachedMb(target);
+                }
+            }
+            fs::remove(target, ec);
+            if (bestNs <= 0) continue;
+
+            PrintBenchRow(caseName, stage, text.size(), bestNs, double(allocs), kRuns);
+            if (cachedMb >= 0) {
+                char note[64];
+                std::snprintf(note, sizeof(note), "%.0f of %zu MB left in page cache", cachedMb, mb);
+                PrintBenchNote(caseName, stage, note);
+            }
+        }
+    }
+}
@@ -0,0 +1,211 @@
+//================================================================================================//
+//                          Clipboard To File - Materialization scaling                           //
+//                                                                                                //
+//  Creates 10k-file trees on disk with the plain backend on 1 to 16 threads and with io_uring,   //
+//  and reports ms per tree and the speedup over one plain thread, then what each durability      //
+//  setting (none, batch, file, volume) adds to that, and creating in place against building in   //
+//  a stage and publishing it. Every run writes into a fresh directory and removes it afterwards; //
+//  only CreateDirectoryStructure is timed. Runs under                                            //
+//  --scratch DIR, or else under the system temp directory and (on Linux) /dev/shm, which covers  //
+//  a disk filesystem and tmpfs.                                                                  //
+//================================================================================================//
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+#include "BenchHarness.h"
+#include "Platform.h"
+#include "ClipboardEngine.h"
+
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct TreeShape {
+    const char* name;
+    std::wstring (*make)();
+    DirectoryTree (*parse)(const LineIndex&);
+};
+
+std::wstring MakeNestedEmptyFiles() { return MakePathList(10000, 50); }
+std::wstring MakeFlatFilesWithContent() { return MakeEnhancedListing(10000, 20); }
+
+const TreeShape kShapes[] = {
+    { "path-list-10k", MakeNestedEmptyFiles, ParsePathListFormat },
+    { "enhanced-10000x20", MakeFlatFilesWithContent, ParseEnhancedFormat },
+};
+
+struct Backend {
+    std::string name;
+    int threads;
+    bool ioUring;
+};
+
+std::vector<Backend> Backends() {
+    std::vector<Backend> backends;
+    for (int threads : { 1, 2, 4, 8, 16 }) backends.push_back({ "threads=" + std::to_string(threads), threads, false });
+    if (FsBatchCreateAvailable()) backends.push_back({ "io_uring", 1, true });
+    return backends;
+}
+
+const int kRuns = 3;   // Best of, to keep page-cache and journal noise out
+
+// Names the filesystem a directory lives on, for the case label.
+std::string FilesystemName(const fs::path& directory) {
+#ifdef __linux__
+    struct statfs info;
+    if (statfs(directory.c_str(), &info) == 0) {
+        switch (static_cast<unsigned long>(info.f_type)) {
+        case 0x01021994: return "tmpfs";
+        case 0xEF53: return "ext4";
+        case 0x9123683E: return "btrfs";
+        case 0x58465342: return "xfs";
+        default: break;
+        }
+    }
+#endif
+    return directory.filename().string();
+}
+
+// Best-of-kRuns time for creating tree in a fresh directory under scratch, or 0 if a run failed.
+double BestCreateNs(const DirectoryTree& tree, const fs::path& scratch, const AppSettings& settings, int& runId, uint64_t& allocs) {
+    using Clock = std::chrono::steady_clock;
+    double bestNs = 0;
+    for (int run = 0; run < kRuns; ++run) {
+        std::error_code ec;
+        fs::path target = scratch / ("run" + std::to_string(runId++));
+        fs::remove_all(target, ec);
+        fs::create_directories(target, ec);
+
+        MaterializeReport report;
+        AllocCounters before = ReadAllocCounters();
+        auto start = Clock::now();
+        bool ok = CreateDirectoryStructure(tree, target.wstring(), settings, report);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        AllocCounters after = ReadAllocCounters();
+        fs::remove_all(target, ec);
+
+        if (!ok) return 0;
+        if (run == 0 || ns < bestNs) {
+            bestNs = ns;
+            allocs = after.count - before.count;
+        }
+    }
+    return bestNs;
+}
+
+std::vector<fs::path> ScratchDirectories(const BenchOptions& options) {
+    if (!options.scratchDir.empty()) return { fs::path(options.scratchDir) };
+    std::error_code ec;
+    std::vector<fs::path> directories = { fs::temp_directory_path(ec) / "ctf_bench" };
+#ifdef __linux__
+    if (fs::is_directory("/dev/shm", ec)) directories.push_back(fs::path("/dev/shm") / "ctf_bench");
+#endif
+    return directories;
+}
+
+} // namespace
+
+
+void RunMaterializeSuite(const BenchOptions& options) {
+    PrintBenchHeader("materialization scaling");
+
+    int runId = 0;
+    for (const fs::path& scratch : ScratchDirectories(options)) {
+        std::error_code ec;
+        fs::create_directories(scratch, ec);
+        if (ec) {
+            std::fprintf(stderr, "cannot use scratch directory %s\n", scratch.string().c_str());
+            continue;
+        }
+        const std::string fsName = FilesystemName(scratch);
+
+        for (const auto& shape : kShapes) {
+            const std::string caseName = std::string(shape.name) + "@" + fsName;
+            const std::wstring payload = shape.make();
+            const LineIndex lines(payload);
+            const DirectoryTree tree = shape.parse(lines);
+            int dirCount = 0, fileCount = 0;
+            GetTreeSummary(tree, dirCount, fileCount);
+
+            double singleThreadMs = 0;
+            for (const auto& backend : Backends()) {
+                if (!BenchSelected(options, caseName, backend.name)) continue;
+
+                // Creation only; the durability rows below add the flush
+                AppSettings settings = GetDefaultSettings();
+                settings.materializeThreads = backend.threads;
+                settings.useIoUring = backend.ioUring;
+                settings.durability = Durability::None;
+
+                uint64_t allocs = 0;
+                const double bestNs = BestCreateNs(tree, scratch, settings, runId, allocs);
+                if (bestNs <= 0) {
+                    PrintBenchNote(caseName, backend.name, "FAILED");
+                    continue;
+                }
+
+                PrintBenchRow(caseName, backend.name, payload.size() * sizeof(wchar_t), bestNs, double(allocs), kRuns);
+                if (backend.threads == 1 && !backend.ioUring) singleThreadMs = bestNs / 1e6;
+                char note[96];
+                if (singleThreadMs > 0) {
+                    std::snprintf(note, sizeof(note), "%d dirs, %d files, %.1f ms, %.2fx vs 1 thread",
+                        dirCount, fileCount, bestNs / 1e6, singleThreadMs / (bestNs / 1e6));
+                }
+                else {
+                    std::snprintf(note, sizeof(note), "%d dirs, %d files, %.1f ms", dirCount, fileCount, bestNs / 1e6);
+                }
+                PrintBenchNote(caseName, backend.name, note);
+            }
+
+            // What each durability setting adds, with the default backend
+            double noneMs = 0;
+            for (Durability durability : { Durability::None, Durability::PerBatch, Durability::PerFile, Durability::Volume }) {
+                const std::string stage = std::string("durability=") + DurabilityName(durability);
+                if (!BenchSelected(options, caseName, stage)) continue;
+                AppSettings settings = GetDefaultSettings();
+                settings.durability = durability;
+
+                uint64_t allocs = 0;
+                const double bestNs = BestCreateNs(tree, scratch, settings, runId, allocs);
+                if (bestNs <= 0) {
+                    PrintBenchNote(caseName, stage, "FAILED");
+                    continue;
+                }
+                PrintBenchRow(caseName, stage, payload.size() * sizeof(wchar_t), bestNs, double(allocs), kRuns);
+                if (durability == Durability::None) noneMs = bestNs / 1e6;
+                char note[96];
+                if (noneMs > 0 && durability != Durability::None) {
+                    std::snprintf(note, sizeof(note), "%.1f ms, %+.1f ms to flush", bestNs / 1e6, bestNs / 1e6 - noneMs);
+                }
+                else {
+                    std::snprintf(note, sizeof(note), "%.1f ms", bestNs / 1e6);
+                }
+                PrintBenchNote(caseName, stage, note);
+            }
+
+            // Building in a stage and publishing it, against creating in place
+            for (bool stage : { false, true }) {
+                const std::string stageName = stage ? "staging=on" : "staging=off";
+                if (!BenchSelected(options, caseName, stageName)) continue;
+                AppSettings settings = GetDefaultSettings();
+                settings.durability = Durability::None;
+                settings.stageStructures = stage;
+
+                uint64_t allocs = 0;
+                const double bestNs = BestCreateNs(tree, scratch, settings, runId, allocs);
+                if (bestNs <= 0) {
+                    PrintBenchNote(caseName, stageName, "FAILED");
+                    continue;
+                }
+                PrintBenchRow(caseName, stageName, payload.size() * sizeof(wchar_t), bestNs, double(allocs), kRuns);
+            }
+        }
+    }
+    std::printf("\n%u hardware threads, io_uring %s\n", std::thread::hardware_concurrency(),
+        FsBatchCreateAvailable() ? "available" : "unavailable");
+}
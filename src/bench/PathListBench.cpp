@@ -0,0 +1,56 @@
+//================================================================================================//
+//                           Clipboard To File - Path list scaling                                //
+//                                                                                                //
+//  Parses path lists of 1k to 1M lines, both spread over many directories and with every file   //
+//  in one directory, and reports ns per line. Flat ns/line across sizes means a linear build.    //
+//================================================================================================//
+#include <cstdio>
+#include "BenchHarness.h"
+#include "ClipboardEngine.h"
+
+
+namespace {
+
+struct PathListShape {
+    const char* name;
+    size_t filesPerDirectory;   // 0 = every file in one directory
+};
+
+const PathListShape kShapes[] = {
+    { "nested", 50 },
+    { "flat", 0 },
+};
+
+const size_t kLineCounts[] = { 1000, 10000, 100000, 1000000 };
+
+std::string LineCountName(size_t lines) {
+    if (lines >= 1000000) return std::to_string(lines / 1000000) + "m";
+    return std::to_string(lines / 1000) + "k";
+}
+
+} // namespace
+
+
+void RunPathListSuite(const BenchOptions& options) {
+    PrintBenchHeader("path list scaling");
+    for (const auto& shape : kShapes) {
+        for (size_t lineCount : kLineCounts) {
+            const std::string caseName = std::string("path-list-") + shape.name + "-" + LineCountName(lineCount);
+            if (!BenchSelected(options, caseName, "ParsePathListFormat")) continue;
+
+            const std::wstring payload = MakePathList(lineCount, shape.filesPerDirectory ? shape.filesPerDirectory : lineCount);
+            const size_t payloadBytes = payload.size() * sizeof(wchar_t);
+            const LineIndex lines(payload);
+
+            double nsPerOp = RunBenchmark(options, caseName, "ParsePathListFormat", payloadBytes, [&] {
+                DirectoryTree tree = ParsePathListFormat(lines);
+                DoNotOptimize(tree.Size());
+            });
+            if (nsPerOp > 0) {
+                char note[64];
+                std::snprintf(note, sizeof(note), "%.1f ns/line", nsPerOp / lineCount);
+                PrintBenchNote(caseName, "ParsePathListFormat", note);
+            }
+        }
+    }
+}
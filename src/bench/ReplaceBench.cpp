@@ -0,0 +1,82 @@
+//================================================================================================//
+//                             Clipboard To File - File replacement                               //
+//                                                                                                //
+//  Replaces an existing file of 1 KB to 100 MB with each FsReplaceTextFile method: a named temp  //
+//  sibling renamed over the target, an O_TMPFILE linked in and renamed over it (Linux; the same  //
+//  as temprename elsewhere), and truncating the target in place, which is not atomic and only    //
+//  there as the floor. The "+sync" rows flush the data before the new file becomes visible.      //
+//  Files go under --scratch (default: the system temp directory).                                //
+//================================================================================================//
+#include <cstdio>
+#include <filesystem>
+#include "BenchHarness.h"
+#include "Platform.h"
+
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct ReplaceSize {
+    const char* name;
+    size_t chars;
+};
+
+const ReplaceSize kSizes[] = {
+    { "1kb", 1024 },
+    { "64kb", 64 * 1024 },
+    { "1mb", 1024 * 1024 },
+    { "16mb", 16 * 1024 * 1024 },
+    { "100mb", 100 * 1024 * 1024 },
+};
+
+struct NamedMethod {
+    const char* name;
+    ReplaceMethod method;
+};
+
+const NamedMethod kMethods[] = {
+    { "temprename", ReplaceMethod::TempRename },
+    { "tmpfile", ReplaceMethod::AnonymousTemp },
+    { "inplace", ReplaceMethod::InPlace },
+};
+
+} // namespace
+
+
+void RunReplaceSuite(const BenchOptions& options) {
+    PrintBenchHeader("file replacement");
+
+    std::error_code ec;
+    fs::path scratch = options.scratchDir.empty() ? fs::temp_directory_path(ec) / "ctf_bench" : fs::path(options.scratchDir);
+    fs::create_directories(scratch, ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot use scratch directory %s\n", scratch.string().c_str());
+        return;
+    }
+    const std::wstring target = (scratch / "replace.txt").wstring();
+
+    for (const auto& size : kSizes) {
+        std::wstring content;   // Built on first use, so filtered-out sizes cost nothing
+        for (const auto& method : kMethods) {
+            for (bool sync : { false, true }) {
+                const std::string stage = std::string(method.name) + (sync ? "+sync" : "");
+                if (!BenchSelected(options, size.name, stage)) continue;
+                if (content.empty()) content = MakeMinifiedCode(size.chars, 31);
+
+                FsWriteOptions writeOptions;
+                writeOptions.syncData = sync;
+                if (!FsWriteTextFile(target, content)) {
+                    PrintBenchNote(size.name, stage, "FAILED");
+                    continue;
+                }
+                bool ok = true;
+                RunBenchmark(options, size.name, stage, content.size(), [&] {
+                    ok = FsReplaceTextFile(target, content, writeOptions, method.method) && ok;
+                });
+                if (!ok) PrintBenchNote(size.name, stage, "FAILED");
+            }
+        }
+    }
+    fs::remove(target, ec);
+}
@@ -0,0 +1,173 @@
+//================================================================================================//
+//                            Clipboard To File - Streamed structures                             //
+//                                                                                                //
+//  Creates an enhanced-format payload of 16 MB to 1 GB (64 files with content) from a UTF-8 file //
+//  two ways: "tree" reads the whole file, decodes it, indexes it, parses it and calls            //
+//  CreateDirectoryStructure; "stream" feeds 1 MB reads through Utf8StreamDecoder into            //
+//  StreamDirectoryStructure. Each row is one run and notes the peak heap it needed. The tree     //
+//  path needs about 5x the payload in memory and only runs up to 256 MB. Files go under         //
+//  --scratch (default: the system temp directory).                                               //
+//================================================================================================//
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include "BenchHarness.h"
+#include "ClipboardEngine.h"
+#include "TextEncoding.h"
+
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct StreamSize {
+    const char* name;
+    size_t bytes;
+    bool tree;      // Small enough to hold whole, with its index, in a typical machine's memory
+};
+
+const StreamSize kSizes[] = {
+    { "16mb", 16ull << 20, true },
+    { "256mb", 256ull << 20, true },
+    { "1gb", 1ull << 30, false },
+};
+
+const size_t kPayloadFiles = 64;
+const size_t kReadBytes = 1 << 20;
+const size_t kLineChars = 100;
+
+// Writes an enhanced payload of about totalBytes: the file list, then one section per file.
+bool WritePayload(const fs::path& path, size_t totalBytes) {
+    std::FILE* out = std::fopen(path.string().c_str(), "wb");
+    if (!out) return false;
+
+    // One megabyte of code in kLineChars lines, repeated for every file's content
+    const std::wstring code = MakeMinifiedCode(1 << 20, 37);
+    std::string block;
+    for (size_t pos = 0; pos < code.size(); pos += kLineChars) {
+        block += WideToUtf8(std::wstring_view(code).substr(pos, kLineChars));
+        block += '\n';
+    }
+
+    std::string head = "streamed/\n";
+    for (size_t f = 0; f < kPayloadFiles; ++f) head += "  part" + std::to_string(f) + ".js\n";
+    bool ok = std::fwrite(head.data(), 1, head.size(), out) == head.size();
+
+    const size_t perFile = totalBytes / kPayloadFiles;
+    for (size_t f = 0; ok && f < kPayloadFiles; ++f) {
+        const std::string name = "part" + std::to_string(f) + ".js";
+        const std::string start = "---START: " + name + " ---\n";
+        const std::string end = "---END: " + name + " ---\n";
+        ok = std::fwrite(start.data(), 1, start.size(), out) == start.size();
+        for (size_t written = 0; ok && written < perFile; written += block.size()) {
+            const size_t size = std::min(block.size(), perFile - written);
+            ok = std::fwrite(block.data(), 1, size, out) == size;
+        }
+        ok = ok && std::fwrite(end.data(), 1, end.size(), out) == end.size();
+    }
+    return std::fclose(out) == 0 && ok;
+}
+
+bool ReadWholeFile(const fs::path& path, std::string& bytes) {
+    std::FILE* in = std::fopen(path.string().c_str(), "rb");
+    if (!in) return false;
+    std::error_code ec;
+    bytes.resize(static_cast<size_t>(fs::file_size(path, ec)));
+    const bool ok = !ec && std::fread(&bytes[0], 1, bytes.size(), in) == bytes.size();
+    std::fclose(in);
+    return ok;
+}
+
+bool CreateAsTree(const fs::path& payload, const std::wstring& target, const AppSettings& settings) {
+    std::string bytes;
+    if (!ReadWholeFile(payload, bytes)) return false;
+    const std::wstring text = Utf8ToWide(bytes);
+    std::string().swap(bytes);
+    const LineIndex lines(text);
+    const DirectoryTree tree = ParseEnhancedFormat(lines);
+    MaterializeReport report;
+    return CreateDirectoryStructure(tree, target, settings, report);
+}
+
+bool CreateAsStream(const fs::path& payload, const std::wstring& target, const AppSettings& settings) {
+    std::FILE* in = std::fopen(payload.string().c_str(), "rb");
+    if (!in) return false;
+    std::string bytes(kReadBytes, '\0');
+    Utf8StreamDecoder decoder;
+    bool finished = false;
+    auto read = [&](std::wstring& chunk) {
+        if (finished) return false;
+        const size_t got = std::fread(&bytes[0], 1, bytes.size(), in);
+        if (got > 0) {
+            decoder.Decode(std::string_view(bytes.data(), got), chunk);
+            return true;
+        }
+        finished = true;
+        decoder.Finish(chunk);
+        return !chunk.empty();
+    };
+    MaterializeReport report;
+    const bool ok = StreamDirectoryStructure(TreeFormat::Enhanced, read, target, settings, report);
+    std::fclose(in);
+    return ok;
+}
+
+} // namespace
+
+
+void RunStreamSuite(const BenchOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    PrintBenchHeader("streamed structures");
+
+    std::error_code ec;
+    fs::path scratch = options.scratchDir.empty() ? fs::temp_directory_path(ec) / "ctf_bench" : fs::path(options.scratchDir);
+    fs::create_directories(scratch, ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot use scratch directory %s\n", scratch.string().c_str());
+        return;
+    }
+    const fs::path payload = scratch / "stream-payload.txt";
+    const fs::path target = scratch / "stream-target";
+
+    AppSettings settings = GetDefaultSettings();
+    settings.durability = Durability::None;
+
+    for (const auto& size : kSizes) {
+        bool written = false;   // Written on first use, so filtered-out sizes cost nothing
+        for (bool stream : { false, true }) {
+            const std::string stage = stream ? "stream" : "tree";
+            if (!BenchSelected(options, size.name, stage)) continue;
+            if (!stream && !size.tree) {
+                PrintBenchNote(size.name, stage, "skipped: the whole payload would not fit in memory");
+                continue;
+            }
+            if (!written && !(written = WritePayload(payload, size.bytes))) {
+                PrintBenchNote(size.name, stage, "FAILED to write the payload");
+                break;
+            }
+
+            fs::remove_all(target, ec);
+            fs::create_directories(target, ec);
+            ResetAllocPeak();
+            const AllocCounters before = ReadAllocCounters();
+            auto start = Clock::now();
+            const bool ok = stream
+                ? CreateAsStream(payload, target.wstring(), settings)
+                : CreateAsTree(payload, target.wstring(), settings);
+            const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            const AllocCounters after = ReadAllocCounters();
+            fs::remove_all(target, ec);
+            if (!ok) {
+                PrintBenchNote(size.name, stage, "FAILED");
+                continue;
+            }
+
+            PrintBenchRow(size.name, stage, size.bytes, ns, double(after.count - before.count), 1);
+            char note[96];
+            std::snprintf(note, sizeof(note), "%.0f ms, peak heap %.1f MB", ns / 1e6,
+                double(after.peakBytes - before.liveBytes) / (1 << 20));
+            PrintBenchNote(size.name, stage, note);
+        }
+    }
+    fs::remove(payload, ec);
+}
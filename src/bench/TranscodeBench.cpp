@@ -0,0 +1,97 @@
+//================================================================================================//
+//                               Clipboard To File - Transcoding                                  //
+//                                                                                                //
+//  Wide <-> UTF-8 conversion over ASCII code, prose with scattered non-ASCII characters and     //
+//  mostly non-ASCII text, from 4 KB to 16 MB. The raw ASCII kernels run twice, once with the    //
+//  kernels picked for this CPU and once with the scalar ones, to show what the SIMD paths buy.  //
+//================================================================================================//
+#include <string>
+#include "AsciiKernels.h"
+#include "BenchHarness.h"
+#include "TextEncoding.h"
+
+
+namespace {
+
+std::wstring MakeAsciiCode(size_t chars, uint32_t seed) { return MakeMinifiedCode(chars, seed); }
+
+// Prose with an accented letter every 64 characters, like a code paste with a few names in it.
+std::wstring MakeSparseNonAscii(size_t chars, uint32_t seed) {
+    std::wstring text = MakeProse(chars, seed);
+    for (size_t i = 0; i < text.size(); i += 64) text[i] = L'é';
+    return text;
+}
+
+// Cyrillic and CJK text with ASCII spaces and punctuation between words.
+std::wstring MakeDenseNonAscii(size_t chars, uint32_t seed) {
+    std::wstring text = MakeProse(chars, seed);
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] >= L'a' && text[i] <= L'z') text[i] = (i & 1) ? static_cast<wchar_t>(0x0430 + (text[i] - L'a')) : static_cast<wchar_t>(0x4E00 + text[i]);
+    }
+    return text;
+}
+
+struct TextShape {
+    const char* name;
+    std::wstring (*make)(size_t chars, uint32_t seed);
+};
+
+const TextShape kShapes[] = {
+    { "ascii", MakeAsciiCode },
+    { "sparse", MakeSparseNonAscii },
+    { "dense", MakeDenseNonAscii },
+};
+
+struct TextSize {
+    const char* name;
+    size_t chars;
+};
+
+const TextSize kSizes[] = {
+    { "4k", 4096 },
+    { "1mb", 1024 * 1024 },
+    { "16mb", 16 * 1024 * 1024 },
+};
+
+} // namespace
+
+
+void RunTranscodeSuite(const BenchOptions& options) {
+    PrintBenchHeader("transcoding");
+    const AsciiKernels& best = GetAsciiKernels();
+    const AsciiKernels& scalar = GetScalarAsciiKernels();
+
+    for (const auto& shape : kShapes) {
+        for (const auto& size : kSizes) {
+            const std::string caseName = std::string(shape.name) + "-" + size.name;
+            const std::wstring wide = shape.make(size.chars, 23);
+            const std::string utf8 = WideToUtf8(wide);
+            const size_t wideBytes = wide.size() * sizeof(wchar_t);
+            std::string encoded(wide.size() * kMaxUtf8PerWide, '\0');
+            std::wstring decoded(utf8.size(), L'\0');
+
+            RunBenchmark(options, caseName, "EncodeUtf8", wideBytes, [&] {
+                DoNotOptimize(EncodeUtf8(wide, encoded.data()));
+            });
+            RunBenchmark(options, caseName, "Utf8Length", wideBytes, [&] {
+                DoNotOptimize(Utf8Length(wide));
+            });
+            RunBenchmark(options, caseName, "DecodeUtf8", utf8.size(), [&] {
+                DoNotOptimize(DecodeUtf8(utf8, decoded.data()));
+            });
+
+            // Only whole-buffer ASCII makes the raw kernels comparable; elsewhere they stop early
+            if (shape.make != MakeAsciiCode) continue;
+            for (const AsciiKernels* kernels : { &best, &scalar }) {
+                if (kernels == &scalar && &best == &scalar) break;   // No SIMD on this CPU
+                const std::string suffix = std::string("/") + kernels->name;
+                RunBenchmark(options, caseName, "narrow" + suffix, wideBytes, [&] {
+                    DoNotOptimize(kernels->narrow(wide.data(), wide.size(), encoded.data()));
+                });
+                RunBenchmark(options, caseName, "widen" + suffix, utf8.size(), [&] {
+                    DoNotOptimize(kernels->widen(reinterpret_cast<const unsigned char*>(utf8.data()), utf8.size(), decoded.data()));
+                });
+            }
+        }
+    }
+}
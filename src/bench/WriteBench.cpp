@@ -0,0 +1,70 @@
+//================================================================================================//
+//                              Clipboard To File - Content writes                                //
+//                                                                                                //
+//  Encodes and writes MB-sized contents, ASCII source and text with non-ASCII characters, and   //
+//  reports MB/s of UTF-8 written. Files go to --scratch (default: the system temp directory).   //
+//================================================================================================//
+#include <cstdio>
+#include <filesystem>
+#include "BenchHarness.h"
+#include "Platform.h"
+#include "TextEncoding.h"
+
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const size_t kSizesMb[] = { 1, 16, 64 };
+
+// Prose with an accented letter every 16 characters and a CJK one every 64.
+std::wstring MakeNonAsciiText(size_t chars, uint32_t seed) {
+    std::wstring text = MakeProse(chars, seed);
+    for (size_t i = 0; i < text.size(); i += 16) text[i] = (i % 64 == 0) ? L'世' : L'é';
+    return text;
+}
+
+struct ContentShape {
+    const char* name;
+    std::wstring (*make)(size_t chars, uint32_t seed);
+};
+
+const ContentShape kShapes[] = {
+    { "ascii", MakeMinifiedCode },
+    { "non-ascii", MakeNonAsciiText },
+};
+
+} // namespace
+
+
+void RunWriteSuite(const BenchOptions& options) {
+    PrintBenchHeader("content writes");
+
+    std::error_code ec;
+    fs::path scratch = options.scratchDir.empty() ? fs::temp_directory_path(ec) / "ctf_bench" : fs::path(options.scratchDir);
+    fs::create_directories(scratch, ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot use scratch directory %s\n", scratch.string().c_str());
+        return;
+    }
+    const std::wstring target = (scratch / "write.txt").wstring();
+
+    for (const auto& shape : kShapes) {
+        for (size_t mb : kSizesMb) {
+            const std::string caseName = std::string(shape.name) + "-" + std::to_string(mb) + "mb";
+            if (!BenchSelected(options, caseName, "EncodeUtf8") && !BenchSelected(options, caseName, "FsWriteTextFile")) continue;
+
+            const std::wstring content = shape.make(mb * 1024 * 1024, 17);
+            const size_t utf8Bytes = Utf8Length(content);
+
+            std::string buffer(utf8Bytes, '\0');
+            RunBenchmark(options, caseName, "EncodeUtf8", utf8Bytes, [&] {
+                DoNotOptimize(EncodeUtf8(content, buffer.data()));
+            });
+            RunBenchmark(options, caseName, "FsWriteTextFile", utf8Bytes, [&] {
+                DoNotOptimize(FsWriteTextFile(target, content));
+            });
+        }
+    }
+    fs::remove(scratch / "write.txt", ec);
+}
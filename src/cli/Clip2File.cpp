@@ -0,0 +1,519 @@
+//================================================================================================//
+//                               Clipboard To File - clip2file                                    //
+//                                                                                                //
+//  Runs the engine on payloads read from stdin or files, without a tray icon: each payload goes  //
+//  through the steps the tray app takes for a clipboard update (early reject, line index,        //
+//  classification, then a structure, several files or one file) and lands in a target           //
+//  directory, or with --dry-run is only classified. --batch runs thousands of payloads in one    //
+//  process and prints throughput and per-stage latency; it is the harness for profiling the      //
+//  engine on Linux. Payload files are UTF-8; settings come from a config.json, or the defaults.  //
+//================================================================================================//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+#include "ClipboardEngine.h"
+#include "Platform.h"
+#include "SettingsFile.h"
+#include "StreamingTreeParser.h"
+#include "TextEncoding.h"
+
+
+namespace {
+
+struct CliOptions {
+    std::vector<std::string> payloads;      // "-" is stdin
+    std::string listFile;                   // Payload paths, one per line; "-" is stdin
+    std::string target = ".";
+    std::string config;
+    FileConflictAction onConflict = FileConflictAction::Skip;
+    bool dryRun = false;
+    bool batch = false;
+    bool subdirectories = false;
+    bool stream = false;
+    int repeat = 1;
+};
+
+enum Stage { kRead, kReject, kIndex, kClassify, kCreate, kStageCount };
+const char* const kStageNames[kStageCount] = { "read", "reject", "index", "classify", "create" };
+
+enum class Outcome {
+    NotAFile,   // Nothing the app would act on
+    Created,    // Created, or with --dry-run would be
+    Skipped,    // Every file already existed and --on-conflict is skip
+    Failed
+};
+
+struct PayloadResult {
+    Outcome outcome = Outcome::NotAFile;
+    std::wstring message;
+    double stageNs[kStageCount] = {};
+    bool staged[kStageCount] = {};          // Which stages ran
+};
+
+const size_t kReadBytes = 1 << 20;
+const size_t kStreamProbeBytes = 64 * 1024;     // --stream: what the format is detected from
+const size_t kListedNames = 10;
+
+using Clock = std::chrono::steady_clock;
+
+// Times one stage of a payload.
+class StageTimer {
+public:
+    StageTimer(PayloadResult& result, Stage stage) : m_result(result), m_stage(stage), m_start(Clock::now()) {}
+    ~StageTimer() {
+        m_result.stageNs[m_stage] += std::chrono::duration<double, std::nano>(Clock::now() - m_start).count();
+        m_result.staged[m_stage] = true;
+    }
+
+private:
+    PayloadResult& m_result;
+    Stage m_stage;
+    Clock::time_point m_start;
+};
+
+// Takes records without keeping them, for a --stream dry run.
+class CountingSink : public TreeOperationSink {
+public:
+    bool AddEntry(uint32_t, std::wstring_view, bool) override { return true; }
+    bool BeginContent(const std::vector<uint32_t>&) override { return true; }
+    bool AppendContent(std::wstring_view) override { return true; }
+    bool EndContent(bool) override { return true; }
+};
+
+
+//------------------------------------------------------------------------------------------------//
+//                                        INPUT                                                   //
+//------------------------------------------------------------------------------------------------//
+// An open payload source, read a piece at a time and decoded as UTF-8 without its BOM.
+class PayloadReader {
+public:
+    bool Open(const std::string& source) {
+        m_file = source == "-" ? stdin : std::fopen(source.c_str(), "rb");
+        m_buffer.resize(kReadBytes);
+        m_first = true;
+        m_finished = false;
+        return m_file != nullptr;
+    }
+    ~PayloadReader() {
+        if (m_file && m_file != stdin) std::fclose(m_file);
+    }
+
+    // Replaces chunk with the next piece of text (up to maxBytes of input); false at the end.
+    bool Read(std::wstring& chunk, size_t maxBytes = kReadBytes) {
+        if (m_finished) return false;
+        size_t got = std::fread(&m_buffer[0], 1, std::min(maxBytes, m_buffer.size()), m_file);
+        m_bytes += got;
+        std::string_view bytes(m_buffer.data(), got);
+        if (m_first && bytes.size() >= 3 && std::memcmp(bytes.data(), "\xEF\xBB\xBF", 3) == 0) bytes.remove_prefix(3);
+        m_first = false;
+        if (got > 0) {
+            m_decoder.Decode(bytes, chunk);
+            return true;
+        }
+        m_finished = true;
+        m_decoder.Finish(chunk);
+        return !chunk.empty();
+    }
+
+    bool Failed() const { return m_file && std::ferror(m_file) != 0; }
+    uint64_t Bytes() const { return m_bytes; }
+
+private:
+    std::FILE* m_file = nullptr;
+    std::string m_buffer;
+    Utf8StreamDecoder m_decoder;
+    uint64_t m_bytes = 0;
+    bool m_first = true;
+    bool m_finished = false;
+};
+
+bool ReadListFile(const std::string& path, std::vector<std::string>& sources) {
+    std::FILE* file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::string line;
+    char buffer[4096];
+    while (std::fgets(buffer, sizeof(buffer), file)) {
+        line += buffer;
+        if (line.back() != '\n' && !std::feof(file)) continue;
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        if (!line.empty()) sources.push_back(line);
+        line.clear();
+    }
+    if (!line.empty()) sources.push_back(line);
+    const bool ok = !std::ferror(file);
+    if (file != stdin) std::fclose(file);
+    return ok;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      PROCESSING                                                //
+//------------------------------------------------------------------------------------------------//
+std::wstring FormatNames(const std::vector<std::wstring>& names) {
+    std::wstring list;
+    for (size_t i = 0; i < names.size() && i < kListedNames; ++i) list += (i ? L", " : L"") + names[i];
+    if (names.size() > kListedNames) list += L", ... " + std::to_wstring(names.size() - kListedNames) + L" more";
+    return list;
+}
+
+const wchar_t* FormatName(TreeFormat format) {
+    switch (format) {
+    case TreeFormat::TreeCommand: return L"tree";
+    case TreeFormat::Indentation: return L"indented";
+    case TreeFormat::PathList: return L"path list";
+    case TreeFormat::Enhanced: return L"enhanced";
+    default: return L"unknown";
+    }
+}
+
+// A structure, as TryDirectoryStructureCreation creates it. Large structures are not confirmed.
+bool CreateStructure(const DirectoryStructurePlan& plan, const std::wstring& target, const EngineSettings& settings, bool dryRun, PayloadResult& result) {
+    std::wstring counts = std::to_wstring(plan.dirCount) + L" directories and " + std::to_wstring(plan.fileCount) + L" files";
+    if (dryRun) {
+        // CreateDirectoryStructure checks every path before it touches the disk; the names will do
+        for (uint32_t i = 1; i < plan.tree.Size(); ++i) {
+            const std::wstring name(plan.tree.Node(i).name);
+            if (IsPathSafe(name)) continue;
+            result.outcome = Outcome::Failed;
+            result.message = L"would fail: Security Error: Invalid path detected: " + name;
+            return false;
+        }
+        result.outcome = Outcome::Created;
+        result.message = L"would create " + counts + L" (" + FormatName(plan.format) + L")";
+        return true;
+    }
+    MaterializeReport report;
+    if (CreateDirectoryStructure(plan.tree, target, settings.app, report)) {
+        result.outcome = Outcome::Created;
+        result.message = L"created " + counts;
+        return true;
+    }
+    result.outcome = Outcome::Failed;
+    result.message = L"failed to create directory structure";
+    if (!report.errorMessage.empty()) result.message += L": " + report.errorTitle + L": " + report.errorMessage;
+    return false;
+}
+
+// Several files or one, as TryFileGeneration creates them, with --on-conflict in place of the
+// conflict dialogs.
+void CreateFiles(const FileGenerationPlan& plan, const std::wstring& target, const EngineSettings& settings, const CliOptions& options, PayloadResult& result) {
+    const bool dryRun = options.dryRun;
+    switch (plan.kind) {
+    case FileGenerationKind::None:
+        return;
+    case FileGenerationKind::InvalidFilename:
+        result.outcome = Outcome::Failed;
+        result.message = L"invalid filename: " + plan.filename;
+        return;
+    case FileGenerationKind::MultipleFiles: {
+        if (dryRun) {
+            result.outcome = Outcome::Created;
+            result.message = L"would create " + std::to_wstring(plan.filenames.size()) + L" files: " + FormatNames(plan.filenames);
+            return;
+        }
+        std::vector<std::wstring> newFiles;
+        std::vector<std::wstring> existingFiles;
+        SplitExistingFiles(target, plan.filenames, newFiles, existingFiles);
+        BatchResult batch = CreateFileBatch(target, newFiles, existingFiles, options.onConflict, settings.app.durability);
+
+        result.outcome = batch.successCount > 0 ? Outcome::Created : batch.failedFiles.empty() ? Outcome::Skipped : Outcome::Failed;
+        result.message = batch.successCount > 0
+            ? L"created " + std::to_wstring(batch.successCount) + L" files"
+            : std::wstring(L"no files were created");
+        if (batch.skipCount > 0) result.message += L", skipped " + std::to_wstring(batch.skipCount) + L" existing";
+        if (!batch.failedFiles.empty()) {
+            result.outcome = Outcome::Failed;
+            result.message += L", failed: " + FormatNames(batch.failedFiles);
+        }
+        if (batch.syncFailed) {
+            result.outcome = Outcome::Failed;
+            result.message += L" (could not flush them to disk)";
+        }
+        return;
+    }
+    case FileGenerationKind::SingleFile: {
+        const std::wstring kind = plan.content.empty() ? L"empty file " : L"file with content ";
+        if (dryRun) {
+            result.outcome = Outcome::Created;
+            result.message = L"would create " + kind + plan.filename;
+            if (!plan.content.empty()) result.message += L" (" + std::to_wstring(plan.content.size()) + L" characters)";
+            return;
+        }
+        FileConflictAction action = FsPathExists(JoinPath(target, plan.filename)) ? options.onConflict : FileConflictAction::Replace;
+        SingleFileResult file = CreateSingleFile(target, plan.filename, plan.content, action, settings.app.writeOptions, settings.app.durability);
+        if (file.skipped) {
+            result.outcome = Outcome::Skipped;
+            result.message = L"skipped existing file " + plan.filename;
+        }
+        else if (file.success) {
+            result.outcome = file.syncFailed ? Outcome::Failed : Outcome::Created;
+            result.message = L"created " + kind + file.finalName;
+            if (file.syncFailed) result.message += L" (could not flush it to disk)";
+        }
+        else {
+            result.outcome = Outcome::Failed;
+            result.message = L"failed to create " + plan.filename;
+        }
+        return;
+    }
+    }
+}
+
+// The work of HandleClipboardEvent for one payload, without the duplicate check: every payload
+// given on the command line is meant to be handled.
+void ProcessPayload(const std::wstring& text, const std::wstring& target, const EngineSettings& settings, const CliOptions& options, PayloadResult& result) {
+    {
+        StageTimer timer(result, kReject);
+        if (!IsCandidatePayload(text, settings)) return;
+    }
+
+    std::optional<LineIndex> lines;
+    {
+        StageTimer timer(result, kIndex);
+        lines.emplace(text);
+    }
+
+    DirectoryStructurePlan structure;
+    FileGenerationPlan files;
+    bool hasStructure;
+    {
+        StageTimer timer(result, kClassify);
+        hasStructure = PlanDirectoryStructure(*lines, settings, structure);
+        if (!hasStructure) files = PlanFileGeneration(*lines, settings);
+    }
+    if (!hasStructure && files.kind == FileGenerationKind::None) return;
+
+    StageTimer timer(result, kCreate);
+    if (hasStructure) {
+        if (CreateStructure(structure, target, settings, options.dryRun, result)) return;
+        files = PlanFileGeneration(*lines, settings);
+    }
+
+    // Fall back to file generation
+    const std::wstring structureError = result.message;
+    if (files.kind == FileGenerationKind::None) return;
+    CreateFiles(files, target, settings, options, result);
+    if (!structureError.empty()) result.message = structureError + L"; " + result.message;
+}
+
+// --stream: path lists and enhanced payloads larger than the probe are created while they are
+// read; anything else is read whole and goes through ProcessPayload. The format is detected from
+// the first kStreamProbeBytes.
+void StreamPayload(PayloadReader& reader, const std::wstring& target, const EngineSettings& settings, const CliOptions& options, PayloadResult& result) {
+    std::wstring text;
+    std::wstring chunk;
+    bool more = true;
+    TreeFormat format = TreeFormat::Unknown;
+    {
+        StageTimer timer(result, kRead);
+        while (reader.Bytes() < kStreamProbeBytes && (more = reader.Read(chunk, kStreamProbeBytes - reader.Bytes()))) text += chunk;
+    }
+    if (more && settings.app.isCreateDirectoryStructureEnabled) {
+        StageTimer timer(result, kClassify);
+        if (IsCandidatePayload(text, settings)) format = DetectTreeFormat(LineIndex(text));
+    }
+    if (format != TreeFormat::PathList && format != TreeFormat::Enhanced) {
+        {
+            StageTimer timer(result, kRead);
+            while (more && (more = reader.Read(chunk))) text += chunk;
+        }
+        ProcessPayload(text, target, settings, options, result);
+        return;
+    }
+
+    // The probe goes first, then the rest as it is read
+    bool probe = true;
+    auto read = [&](std::wstring& next) {
+        if (!probe) return reader.Read(next);
+        probe = false;
+        next.swap(text);
+        return true;
+    };
+    StageTimer timer(result, kCreate);
+    if (options.dryRun) {
+        CountingSink sink;
+        StreamingTreeParser parser(format, sink);
+        while (read(chunk)) parser.Feed(chunk);
+        parser.Finish();
+        result.outcome = Outcome::Created;
+        result.message = L"would create " + std::to_wstring(parser.DirectoryCount()) + L" directories and " +
+            std::to_wstring(parser.FileCount()) + L" files (" + FormatName(format) + L", streamed)";
+        return;
+    }
+    MaterializeReport report;
+    if (StreamDirectoryStructure(format, read, target, settings.app, report)) {
+        result.outcome = Outcome::Created;
+        result.message = L"created " + std::to_wstring(report.dirCount) + L" directories and " +
+            std::to_wstring(report.fileCount) + L" files (streamed)";
+        return;
+    }
+    result.outcome = report.dirCount + report.fileCount == 0 ? Outcome::NotAFile : Outcome::Failed;
+    result.message = L"failed to create directory structure";
+    if (!report.errorMessage.empty()) result.message += L": " + report.errorTitle + L": " + report.errorMessage;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                       REPORTING                                                //
+//------------------------------------------------------------------------------------------------//
+void PrintResult(const std::string& source, const PayloadResult& result) {
+    const char* prefix = result.outcome == Outcome::Failed ? "error: " : "";
+    const std::wstring& message = result.outcome == Outcome::NotAFile ? std::wstring(L"not a file") : result.message;
+    std::printf("%s: %s%s\n", source.c_str(), prefix, WideToUtf8(message).c_str());
+}
+
+double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void PrintSummary(const std::vector<PayloadResult>& results, uint64_t bytes, double wallNs) {
+    size_t counts[4] = {};
+    for (const auto& result : results) counts[static_cast<int>(result.outcome)]++;
+    std::printf("payloads  %zu: %zu created, %zu skipped, %zu not a file, %zu failed\n", results.size(),
+        counts[static_cast<int>(Outcome::Created)], counts[static_cast<int>(Outcome::Skipped)],
+        counts[static_cast<int>(Outcome::NotAFile)], counts[static_cast<int>(Outcome::Failed)]);
+    const double seconds = wallNs / 1e9;
+    std::printf("input     %.1f MB in %.3f s: %.0f payloads/s, %.1f MB/s\n\n", bytes / 1e6, seconds,
+        seconds > 0 ? results.size() / seconds : 0.0, seconds > 0 ? bytes / 1e6 / seconds : 0.0);
+
+    std::printf("%-10s %10s %10s %10s %10s %10s %8s\n", "stage (us)", "mean", "p50", "p90", "p99", "max", "count");
+    std::vector<double> samples;
+    for (int stage = 0; stage < kStageCount; ++stage) {
+        samples.clear();
+        double total = 0;
+        for (const auto& result : results) {
+            if (!result.staged[stage]) continue;
+            samples.push_back(result.stageNs[stage] / 1e3);
+            total += samples.back();
+        }
+        if (samples.empty()) continue;
+        std::sort(samples.begin(), samples.end());
+        std::printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.1f %8zu\n", kStageNames[stage], total / samples.size(),
+            Percentile(samples, 0.5), Percentile(samples, 0.9), Percentile(samples, 0.99), samples.back(), samples.size());
+    }
+}
+
+void PrintUsage() {
+    std::printf(
+        "usage: clip2file [options] [PAYLOAD...]\n\n"
+        "Handles each PAYLOAD file (\"-\" or none: stdin) the way Clipboard To File handles copied text.\n\n"
+        "  -t, --target DIR        where files are created (default: the current directory)\n"
+        "  -c, --config FILE       settings, as in config.json (default: the built-in defaults)\n"
+        "  -n, --dry-run           classify only and print what would be created\n"
+        "  -l, --list FILE         also read payload paths from FILE, one per line (\"-\": stdin)\n"
+        "      --on-conflict WHAT  existing files: skip (default), replace or rename\n"
+        "      --batch             print a summary with throughput and per-stage latency instead\n"
+        "      --repeat N          handle the payloads N times (with --subdirs, for profiling)\n"
+        "      --subdirs           give each payload its own numbered directory in the target\n"
+        "      --stream            create large path lists and enhanced payloads while reading them\n"
+        "\nExit status: 0 when nothing failed, 1 when a payload failed, 2 on a usage or settings error.\n");
+}
+
+bool ParseConflictAction(const std::string& name, FileConflictAction& action) {
+    if (name == "skip") action = FileConflictAction::Skip;
+    else if (name == "replace") action = FileConflictAction::Replace;
+    else if (name == "rename") action = FileConflictAction::Rename;
+    else return false;
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    CliOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "-t" || arg == "--target") && hasValue) options.target = argv[++i];
+        else if ((arg == "-c" || arg == "--config") && hasValue) options.config = argv[++i];
+        else if ((arg == "-l" || arg == "--list") && hasValue) options.listFile = argv[++i];
+        else if (arg == "--on-conflict" && hasValue && ParseConflictAction(argv[i + 1], options.onConflict)) ++i;
+        else if (arg == "--repeat" && hasValue && std::atoi(argv[i + 1]) > 0) options.repeat = std::atoi(argv[++i]);
+        else if (arg == "-n" || arg == "--dry-run") options.dryRun = true;
+        else if (arg == "--batch") options.batch = true;
+        else if (arg == "--subdirs") options.subdirectories = true;
+        else if (arg == "--stream") options.stream = true;
+        else if (arg == "-" || arg[0] != '-') options.payloads.push_back(arg);
+        else {
+            PrintUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+    if (!options.listFile.empty() && !ReadListFile(options.listFile, options.payloads)) {
+        std::fprintf(stderr, "clip2file: cannot read %s\n", options.listFile.c_str());
+        return 2;
+    }
+    if (options.payloads.empty() && options.listFile.empty()) options.payloads.push_back("-");
+
+    AppSettings app = GetDefaultSettings();
+    if (!options.config.empty()) {
+        SettingsFileStatus status = LoadSettingsFile(Utf8ToWide(options.config), app);
+        if (status != SettingsFileStatus::Loaded) {
+            std::fprintf(stderr, "clip2file: %s %s\n", status == SettingsFileStatus::Missing ? "cannot open" : "cannot parse", options.config.c_str());
+            return 2;
+        }
+    }
+    const EngineSettings settings = CompileEngineSettings(app);
+    const std::wstring target = Utf8ToWide(options.target);
+    if (!options.dryRun && !FsPathExists(target) && !FsCreateDirectories(target)) {
+        std::fprintf(stderr, "clip2file: cannot create %s\n", options.target.c_str());
+        return 2;
+    }
+
+    std::vector<PayloadResult> results;
+    results.reserve(options.payloads.size() * options.repeat);
+    uint64_t bytes = 0;
+    bool failed = false;
+    const auto started = Clock::now();
+    for (int run = 0; run < options.repeat; ++run) {
+        for (const std::string& source : options.payloads) {
+            PayloadResult result;
+            std::wstring payloadTarget = target;
+            if (options.subdirectories) {
+                char name[16];
+                std::snprintf(name, sizeof(name), "%06zu", results.size());
+                payloadTarget = JoinPath(target, Utf8ToWide(name));
+                if (!options.dryRun) FsCreateDirectories(payloadTarget);
+            }
+
+            PayloadReader reader;
+            if (!reader.Open(source)) {
+                result.outcome = Outcome::Failed;
+                result.message = L"cannot open " + Utf8ToWide(source);
+            }
+            else if (options.stream) {
+                StreamPayload(reader, payloadTarget, settings, options, result);
+            }
+            else {
+                std::wstring text;
+                {
+                    StageTimer timer(result, kRead);
+                    std::wstring chunk;
+                    while (reader.Read(chunk)) text += chunk;
+                }
+                ProcessPayload(text, payloadTarget, settings, options, result);
+            }
+            if (reader.Failed()) {
+                result.outcome = Outcome::Failed;
+                result.message = L"cannot read " + Utf8ToWide(source);
+            }
+
+            bytes += reader.Bytes();
+            failed = failed || result.outcome == Outcome::Failed;
+            if (!options.batch) PrintResult(source, result);
+            results.push_back(std::move(result));
+        }
+    }
+    const double wallNs = std::chrono::duration<double, std::nano>(Clock::now() - started).count();
+
+    if (options.batch) PrintSummary(results, bytes, wallNs);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,242 @@
+//================================================================================================//
+//                             Clipboard To File - ASCII kernels                                  //
+//================================================================================================//
+#include <cstdint>
+#include "AsciiKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CTF_ASCII_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CTF_TARGET_AVX2
+#else
+#define CTF_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+namespace {
+
+constexpr bool kWide16 = sizeof(wchar_t) == 2;
+
+inline bool IsAsciiUnit(wchar_t c) { return static_cast<uint32_t>(c) < 0x80; }
+
+
+//------------------------------------------------------------------------------------------------//
+//                                        SCALAR                                                  //
+//------------------------------------------------------------------------------------------------//
+size_t ScanWideScalar(const wchar_t* text, size_t count) {
+    size_t i = 0;
+    // Eight characters at a time while they are all ASCII
+    for (; i + 8 <= count; i += 8) {
+        uint32_t any = 0;
+        for (int k = 0; k < 8; ++k) any |= static_cast<uint32_t>(text[i + k]);
+        if (any >= 0x80) break;
+    }
+    while (i < count && IsAsciiUnit(text[i])) ++i;
+    return i;
+}
+
+size_t NarrowScalar(const wchar_t* text, size_t count, char* out) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint32_t any = 0;
+        for (int k = 0; k < 8; ++k) any |= static_cast<uint32_t>(text[i + k]);
+        if (any >= 0x80) break;
+        for (int k = 0; k < 8; ++k) out[i + k] = static_cast<char>(text[i + k]);
+    }
+    for (; i < count && IsAsciiUnit(text[i]); ++i) out[i] = static_cast<char>(text[i]);
+    return i;
+}
+
+size_t WidenScalar(const unsigned char* text, size_t count, wchar_t* out) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        unsigned any = 0;
+        for (int k = 0; k < 8; ++k) any |= text[i + k];
+        if (any >= 0x80) break;
+        for (int k = 0; k < 8; ++k) out[i + k] = static_cast<wchar_t>(text[i + k]);
+    }
+    for (; i < count && text[i] < 0x80; ++i) out[i] = static_cast<wchar_t>(text[i]);
+    return i;
+}
+
+const AsciiKernels kScalarKernels = { "scalar", ScanWideScalar, NarrowScalar, WidenScalar };
+
+
+#ifdef CTF_ASCII_X64
+//------------------------------------------------------------------------------------------------//
+//                                         SSE2                                                   //
+//------------------------------------------------------------------------------------------------//
+// 16 characters per step. Any bit above the low seven in any unit means non-ASCII.
+inline __m128i WideHighMask128() {
+    return kWide16 ? _mm_set1_epi16(static_cast<short>(0xFF80)) : _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+}
+
+inline bool IsZero128(__m128i v) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+}
+
+// Loads 16 wide characters as two (UTF-16) or four (UTF-32) vectors and reports whether all are ASCII.
+inline bool LoadAscii16(const wchar_t* text, __m128i (&v)[4]) {
+    const __m128i* src = reinterpret_cast<const __m128i*>(text);
+    const int vectors = kWide16 ? 2 : 4;
+    __m128i any = _mm_setzero_si128();
+    for (int k = 0; k < vectors; ++k) {
+        v[k] = _mm_loadu_si128(src + k);
+        any = _mm_or_si128(any, v[k]);
+    }
+    return IsZero128(_mm_and_si128(any, WideHighMask128()));
+}
+
+size_t ScanWideSse2(const wchar_t* text, size_t count) {
+    size_t i = 0;
+    __m128i v[4];
+    for (; i + 16 <= count; i += 16) {
+        if (!LoadAscii16(text + i, v)) break;
+    }
+    return i + ScanWideScalar(text + i, count - i);
+}
+
+size_t NarrowSse2(const wchar_t* text, size_t count, char* out) {
+    size_t i = 0;
+    __m128i v[4];
+    for (; i + 16 <= count; i += 16) {
+        if (!LoadAscii16(text + i, v)) break;
+        // Every unit is below 0x80, so the saturating packs are plain truncations
+        __m128i bytes;
+        if constexpr (kWide16) bytes = _mm_packus_epi16(v[0], v[1]);
+        else bytes = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+    }
+    return i + NarrowScalar(text + i, count - i, out + i);
+}
+
+size_t WidenSse2(const unsigned char* text, size_t count, wchar_t* out) {
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        if (_mm_movemask_epi8(bytes) != 0) break;
+        __m128i* dst = reinterpret_cast<__m128i*>(out + i);
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        if constexpr (kWide16) {
+            _mm_storeu_si128(dst, low);
+            _mm_storeu_si128(dst + 1, high);
+        }
+        else {
+            _mm_storeu_si128(dst, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high, zero));
+        }
+    }
+    return i + WidenScalar(text + i, count - i, out + i);
+}
+
+const AsciiKernels kSse2Kernels = { "sse2", ScanWideSse2, NarrowSse2, WidenSse2 };
+
+
+//------------------------------------------------------------------------------------------------//
+//                                         AVX2                                                   //
+//------------------------------------------------------------------------------------------------//
+// 32 characters per step. Packs work within 128-bit lanes, so results are permuted back in order.
+// A block that fails the test is finished by the scalar kernel, a short tail at the end by SSE2.
+// Both are legacy-encoded: clearing the upper halves first avoids an AVX-to-SSE transition stall
+// on every call, which otherwise dominates for text with short ASCII runs.
+CTF_TARGET_AVX2 inline bool LoadAscii32(const wchar_t* text, __m256i (&v)[4]) {
+    const __m256i* src = reinterpret_cast<const __m256i*>(text);
+    const int vectors = kWide16 ? 2 : 4;
+    __m256i any = _mm256_setzero_si256();
+    for (int k = 0; k < vectors; ++k) {
+        v[k] = _mm256_loadu_si256(src + k);
+        any = _mm256_or_si256(any, v[k]);
+    }
+    const __m256i mask = kWide16 ? _mm256_set1_epi16(static_cast<short>(0xFF80)) : _mm256_set1_epi32(static_cast<int>(0xFFFFFF80));
+    return _mm256_testz_si256(any, mask) != 0;
+}
+
+CTF_TARGET_AVX2 size_t ScanWideAvx2(const wchar_t* text, size_t count) {
+    size_t i = 0;
+    __m256i v[4];
+    for (; i + 32 <= count; i += 32) {
+        if (!LoadAscii32(text + i, v)) break;
+    }
+    _mm256_zeroupper();
+    return i + (count - i >= 32 ? ScanWideScalar(text + i, count - i) : ScanWideSse2(text + i, count - i));
+}
+
+CTF_TARGET_AVX2 size_t NarrowAvx2(const wchar_t* text, size_t count, char* out) {
+    size_t i = 0;
+    __m256i v[4];
+    const __m256i dwordOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i + 32 <= count; i += 32) {
+        if (!LoadAscii32(text + i, v)) break;
+        __m256i bytes;
+        if constexpr (kWide16) {
+            bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(v[0], v[1]), 0xD8);
+        }
+        else {
+            __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(v[0], v[1]), _mm256_packs_epi32(v[2], v[3]));
+            bytes = _mm256_permutevar8x32_epi32(packed, dwordOrder);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), bytes);
+    }
+    _mm256_zeroupper();
+    return i + (count - i >= 32 ? NarrowScalar(text + i, count - i, out + i) : NarrowSse2(text + i, count - i, out + i));
+}
+
+CTF_TARGET_AVX2 size_t WidenAvx2(const unsigned char* text, size_t count, wchar_t* out) {
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        if (_mm256_movemask_epi8(bytes) != 0) break;
+        __m256i* dst = reinterpret_cast<__m256i*>(out + i);
+        __m128i halves[2] = { _mm256_castsi256_si128(bytes), _mm256_extracti128_si256(bytes, 1) };
+        for (int h = 0; h < 2; ++h) {
+            if constexpr (kWide16) {
+                _mm256_storeu_si256(dst + h, _mm256_cvtepu8_epi16(halves[h]));
+            }
+            else {
+                _mm256_storeu_si256(dst + 2 * h, _mm256_cvtepu8_epi32(halves[h]));
+                _mm256_storeu_si256(dst + 2 * h + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(halves[h], 8)));
+            }
+        }
+    }
+    _mm256_zeroupper();
+    return i + (count - i >= 32 ? WidenScalar(text + i, count - i, out + i) : WidenSse2(text + i, count - i, out + i));
+}
+
+const AsciiKernels kAvx2Kernels = { "avx2", ScanWideAvx2, NarrowAvx2, WidenAvx2 };
+
+bool CpuHasAvx2() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 1);
+    const bool osSavesYmm = (regs[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    if (!osSavesYmm) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // CTF_ASCII_X64
+
+} // namespace
+
+
+const AsciiKernels& GetAsciiKernels() {
+#ifdef CTF_ASCII_X64
+    static const AsciiKernels& selected = CpuHasAvx2() ? kAvx2Kernels : kSse2Kernels;
+    return selected;
+#else
+    return kScalarKernels;
+#endif
+}
+
+const AsciiKernels& GetScalarAsciiKernels() {
+    return kScalarKernels;
+}
@@ -0,0 +1,25 @@
+//================================================================================================//
+//                             Clipboard To File - ASCII kernels                                  //
+//                                                                                                //
+//  The fast paths behind TextEncoding: find and convert runs of ASCII between wide and UTF-8    //
+//  text. Each runs with SSE2 or AVX2 on x64 (picked once from the CPU) and as plain C++          //
+//  elsewhere. Every kernel stops at the first non-ASCII character and returns how far it got;   //
+//  the caller decodes that character itself and calls again.                                    //
+//================================================================================================//
+#pragma once
+
+#include <cstddef>
+
+
+struct AsciiKernels {
+    const char* name;                                                       // "avx2", "sse2" or "scalar"
+    size_t (*scanWide)(const wchar_t* text, size_t count);                  // Length of the ASCII prefix
+    size_t (*narrow)(const wchar_t* text, size_t count, char* out);         // Copies the ASCII prefix
+    size_t (*widen)(const unsigned char* text, size_t count, wchar_t* out); // Copies the ASCII prefix
+};
+
+// The best kernels this CPU supports.
+const AsciiKernels& GetAsciiKernels();
+
+// The portable kernels, whatever the CPU.
+const AsciiKernels& GetScalarAsciiKernels();
@@ -0,0 +1,352 @@
+//================================================================================================//
+//                          Clipboard To File - Payload classification                            //
+//                                                                                                //
+//  Decides whether a clipboard payload names one or more files, and what content goes in them.   //
+//  Nothing in here touches the filesystem.                                                       //
+//================================================================================================//
+#include <algorithm>
+#include <cwctype>
+#include "ClipboardEngine.h"
+
+
+//------------------------------------------------------------------------------------------------//
+//                                    SETTINGS SNAPSHOTS                                          //
+//------------------------------------------------------------------------------------------------//
+AppSettings GetDefaultSettings() {
+    AppSettings defaults;
+    defaults.allowedExtensions = { L".txt", L".md", L".log", L".sql", L".cpp", L".h", L".js", L".json", L".xml", L".cs", L".c" };
+    defaults.contentCreationRegexes = {
+        L"^// --- START OF FILE: (.*) ---$",
+        L"^file: (.*)$",
+        L"^(.*\\.[a-zA-Z0-9]+)$"
+    };
+    defaults.isCreateDirectoryStructureEnabled = true;
+    defaults.createEmptyDirectories = true;
+    defaults.skipExistingDirectories = true;
+    return defaults;
+}
+
+const char* WriteStrategyName(WriteStrategy strategy) {
+    switch (strategy) {
+    case WriteStrategy::Simple: return "simple";
+    case WriteStrategy::Preallocate: return "preallocate";
+    case WriteStrategy::Streaming: return "streaming";
+    default: return "auto";
+    }
+}
+
+WriteStrategy ParseWriteStrategy(std::string_view name, WriteStrategy fallback) {
+    for (WriteStrategy strategy : { WriteStrategy::Auto, WriteStrategy::Simple, WriteStrategy::Preallocate, WriteStrategy::Streaming }) {
+        if (name == WriteStrategyName(strategy)) return strategy;
+    }
+    return fallback;
+}
+
+const char* DurabilityName(Durability durability) {
+    switch (durability) {
+    case Durability::None: return "none";
+    case Durability::PerFile: return "file";
+    case Durability::Volume: return "volume";
+    default: return "batch";
+    }
+}
+
+Durability ParseDurability(std::string_view name, Durability fallback) {
+    for (Durability durability : { Durability::None, Durability::PerBatch, Durability::PerFile, Durability::Volume }) {
+        if (name == DurabilityName(durability)) return durability;
+    }
+    return fallback;
+}
+
+PatternSet CompileContentPatterns(const std::vector<std::wstring>& patterns) {
+    return PatternSet::Compile(patterns);
+}
+
+EngineSettings CompileEngineSettings(const AppSettings& settings) {
+    EngineSettings engine;
+    engine.app = settings;
+    engine.contentPatterns = CompileContentPatterns(settings.contentCreationRegexes);
+    engine.filenames = FilenameAcceptor::Compile(settings);
+    return engine;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                  FILENAME HEURISTICS                                           //
+//------------------------------------------------------------------------------------------------//
+// A simple helper to count words in a string, used by the content-creation heuristic.
+int CountWords(std::wstring_view str) {
+    int count = 0;
+    bool inWord = false;
+    for (wchar_t c : str) {
+        bool space = std::iswspace(static_cast<wint_t>(c)) != 0;
+        if (!space && !inWord) count++;
+        inWord = !space;
+    }
+    return count;
+}
+
+// Windows filename validation to prevent security issues and filesystem errors: no separators
+// (so no traversal or absolute paths), invalid or control characters, reserved device names,
+// trailing period or more than 255 characters.
+bool IsValidFilename(std::wstring_view filename) {
+    return FilenameAcceptor::IsValidName(filename);
+}
+
+// Runs the configured content-creation patterns against the first line; on a match with a
+// capture group, returns the captured filename.
+bool MatchContentPattern(std::wstring_view firstLine, const EngineSettings& settings, std::wstring& filename) {
+    PatternMatch match;
+    if (!settings.contentPatterns.Match(firstLine, match)) return false;
+    filename = std::wstring(firstLine.substr(match.captureBegin, match.captureEnd - match.captureBegin));
+    return true;
+}
+
+// Smart search for additional filenames using line logic. The first line examined is the
+// remainder of the line containing startPos.
+std::vector<std::wstring> FindAdditionalFilenames(const LineIndex& lines, size_t startPos, const EngineSettings& settings) {
+    std::vector<std::wstring> filenames;
+
+    const std::wstring_view text = lines.Text();
+    if (startPos >= text.length()) return filenames;
+    const size_t firstIndex = lines.FindLine(startPos);
+    if (firstIndex == lines.Count()) return filenames;
+
+    const FilenameAcceptor& acceptor = settings.filenames;
+
+    // Check first line for multiple space-separated filenames
+    std::wstring_view firstLine = text.substr(startPos, lines.Span(firstIndex).end - startPos);
+    firstLine = TrimView(firstLine, L" \t\r");
+    std::vector<std::wstring_view> words;
+
+    size_t pos = 0;
+    while (pos < firstLine.length()) {
+        while (pos < firstLine.length() && std::iswspace(static_cast<wint_t>(firstLine[pos]))) ++pos;
+        size_t wordStart = pos;
+        while (pos < firstLine.length() && !std::iswspace(static_cast<wint_t>(firstLine[pos]))) ++pos;
+        if (pos > wordStart) words.push_back(firstLine.substr(wordStart, pos - wordStart));
+    }
+
+    std::vector<uint8_t> accepted;
+    std::vector<std::wstring> firstLineFilenames;
+    if (acceptor.AcceptMany(words, accepted) > 0) {
+        for (size_t i = 0; i < words.size(); ++i) {
+            if (accepted[i]) firstLineFilenames.emplace_back(words[i]);
+        }
+    }
+
+    // If we found multiple space-separated filenames in first line, return those
+    if (firstLineFilenames.size() > 1) {
+        return firstLineFilenames;
+    }
+
+    // If first line had exactly one valid filename, add it and continue checking other lines
+    if (firstLineFilenames.size() == 1) {
+        filenames.push_back(firstLineFilenames[0]);
+    }
+
+    // Check subsequent lines one by one
+    for (size_t i = firstIndex + 1; i < lines.Count(); ++i) {
+        std::wstring_view line = TrimView(lines.Line(i), L" \t\r");
+        if (line.empty()) {
+            // Empty line - skip and continue checking
+            continue;
+        }
+
+        // Line has content - stop searching at the first line that isn't a valid filename
+        if (acceptor.Accepts(line)) {
+            filenames.emplace_back(line);
+        }
+        else {
+            break;
+        }
+    }
+
+    return filenames;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                 FILE GENERATION PLANNING                                       //
+//------------------------------------------------------------------------------------------------//
+// First whitespace-delimited word of a line (empty if the line is blank).
+static std::wstring_view FirstWordOf(std::wstring_view line) {
+    size_t wordStart = 0;
+    while (wordStart < line.length() && std::iswspace(static_cast<wint_t>(line[wordStart]))) ++wordStart;
+    size_t wordEnd = wordStart;
+    while (wordEnd < line.length() && !std::iswspace(static_cast<wint_t>(line[wordEnd]))) ++wordEnd;
+    return line.substr(wordStart, wordEnd - wordStart);
+}
+
+// Unified detector that handles both empty file generation and file generation with content
+FileGenerationPlan PlanFileGeneration(const LineIndex& lines, const EngineSettings& settings) {
+    FileGenerationPlan plan;
+    const AppSettings& app = settings.app;
+    bool emptyEnabled = app.isCreateEmptyFileEnabled;
+    bool contentEnabled = app.isCreateWithContentEnabled;
+
+    if (!emptyEnabled && !contentEnabled) return plan;
+
+    const std::wstring_view clipboardText = lines.Text();
+    size_t first_line_end = clipboardText.find(L'\n');
+
+    std::wstring_view firstLine;
+    std::wstring_view content;
+    bool isMultiLine = (first_line_end != std::wstring_view::npos);
+
+    if (isMultiLine) {
+        // Multi-line content: split at newline
+        firstLine = clipboardText.substr(0, first_line_end);
+        content = clipboardText.substr(first_line_end + 1);
+
+        // If content creation is disabled, don't process multi-line content
+        if (!contentEnabled) return plan;
+    }
+    else {
+        // Single-line content: treat entire clipboard as "first line" initially
+        firstLine = clipboardText;
+    }
+
+    // Trim the first line
+    firstLine = TrimView(firstLine, L" \t\r\n");
+
+    std::wstring filename;
+    bool format_detected = false;
+    size_t filename_end_pos = 0;
+
+    // Priority 1: Use pre-compiled regex patterns from config (if content creation is enabled)
+    if (contentEnabled && MatchContentPattern(firstLine, settings, filename)) {
+        format_detected = true;
+        filename_end_pos = isMultiLine ? first_line_end + 1 : clipboardText.length();
+    }
+
+    // Priority 2: Check if first word is a filename with content following (single-line only)
+    if (!format_detected && !isMultiLine) {
+        std::wstring_view firstWord = FirstWordOf(firstLine);
+        size_t firstWordEnd = static_cast<size_t>(firstWord.data() - firstLine.data()) + firstWord.size();
+
+        if (!firstWord.empty() && settings.filenames.HasAllowedExtension(firstWord)) {
+            // Extract content after the filename
+            filename = std::wstring(firstWord);
+            format_detected = true;
+            filename_end_pos = static_cast<size_t>(firstLine.data() - clipboardText.data()) + firstWordEnd;
+
+            if (firstWordEnd < firstLine.length()) {
+                // There's content after the filename
+                content = firstLine.substr(firstWordEnd);
+                content.remove_prefix(std::min(content.find_first_not_of(L" \t"), content.size())); // Trim leading whitespace
+
+                // For this case, we need content creation enabled since we found content
+                if (!contentEnabled) return plan;
+            }
+            else {
+                // Just the filename, no content - treat as empty file case
+                content = std::wstring_view();
+
+                // For empty file, we need empty file creation enabled
+                if (!emptyEnabled) return plan;
+            }
+        }
+    }
+
+    // Priority 3: Fallback to the simpler word-count heuristic (for both modes)
+    if (!format_detected) {
+        if (settings.filenames.HasAllowedExtension(firstLine) && CountWords(firstLine) <= app.heuristicWordCountLimit) {
+            filename = std::wstring(firstLine);
+            format_detected = true;
+            filename_end_pos = isMultiLine ? first_line_end + 1 : clipboardText.length();
+
+            // Priority 3 creates empty files, so check if empty file creation is enabled
+            if (!emptyEnabled) return plan;
+        }
+    }
+
+    if (!format_detected) return plan;
+
+    // If we found a filename, check if there are more filenames following it
+    if (emptyEnabled) {
+        std::vector<std::wstring> allFilenames;
+        allFilenames.push_back(filename);
+
+        // Look for additional filenames using smart line-based logic
+        std::vector<std::wstring> additionalFilenames = FindAdditionalFilenames(lines, filename_end_pos, settings);
+        allFilenames.insert(allFilenames.end(), additionalFilenames.begin(), additionalFilenames.end());
+
+        // If we found multiple filenames, handle as batch creation
+        if (allFilenames.size() >= 2) {
+            plan.kind = FileGenerationKind::MultipleFiles;
+            plan.filenames = std::move(allFilenames);
+            return plan;
+        }
+    }
+
+    // If not multiple files or only found one filename, proceed with single file logic
+    filename.erase(0, filename.find_first_not_of(L" \t\n\r"));
+    filename.erase(filename.find_last_not_of(L" \t\n\r") + 1);
+    plan.filename = filename;
+    if (!IsValidFilename(filename)) {
+        // Detected a pattern but filename is invalid. Stop all further processing.
+        plan.kind = FileGenerationKind::InvalidFilename;
+        return plan;
+    }
+
+    plan.kind = FileGenerationKind::SingleFile;
+    plan.content = std::wstring(content);
+    return plan;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      EARLY REJECT                                              //
+//------------------------------------------------------------------------------------------------//
+// The evidence DetectTreeFormat needs, over the whole payload so that no tree it would accept is
+// rejected: tree-drawing characters, enhanced-format markers, or a line with a slash or leading
+// indentation. Each check is a linear scan without allocation.
+static bool HasTreeEvidence(std::wstring_view text) {
+    // 0x251C = '├', 0x2514 = '└', 0x2502 = '│'
+    for (wchar_t c : { static_cast<wchar_t>(0x251C), static_cast<wchar_t>(0x2514), static_cast<wchar_t>(0x2502), L'/', L'\\' }) {
+        if (text.find(c) != std::wstring_view::npos) return true;
+    }
+    if (text.find(L"---START:") != std::wstring_view::npos || text.find(L"---END:") != std::wstring_view::npos) {
+        return true;
+    }
+    for (size_t pos = 0; pos < text.size();) {
+        if (text[pos] == L' ' || text[pos] == L'\t') return true;
+        size_t newline = text.find(L'\n', pos);
+        if (newline == std::wstring_view::npos) break;
+        pos = newline + 1;
+    }
+    return false;
+}
+
+// Whether the first line could start any PlanFileGeneration priority. Only the priorities'
+// first-line conditions are checked; the full planner decides the rest.
+static bool ProbeHasFilenameLine(std::wstring_view text, std::wstring_view probe, const EngineSettings& settings) {
+    const AppSettings& app = settings.app;
+    if (!app.isCreateEmptyFileEnabled && !app.isCreateWithContentEnabled) return false;
+
+    size_t lineEnd = probe.find(L'\n');
+    if (lineEnd == std::wstring_view::npos && probe.size() < text.size()) {
+        // The first line runs past the probe. Such a line is far too long to be a filename, so
+        // only a single-line "name.ext content" payload can still produce a file.
+        std::wstring_view firstWord = FirstWordOf(probe);
+        if (firstWord.data() + firstWord.size() == probe.data() + probe.size()) return false;
+        return !firstWord.empty() && settings.filenames.HasAllowedExtension(firstWord);
+    }
+
+    bool isMultiLine = lineEnd != std::wstring_view::npos;
+    if (isMultiLine && !app.isCreateWithContentEnabled) return false;
+    std::wstring_view firstLine = TrimView(probe.substr(0, lineEnd), L" \t\r\n");
+
+    if (app.isCreateWithContentEnabled && settings.contentPatterns.Matches(firstLine)) return true;
+    if (!isMultiLine) {
+        std::wstring_view firstWord = FirstWordOf(firstLine);
+        if (!firstWord.empty() && settings.filenames.HasAllowedExtension(firstWord)) return true;
+    }
+    return settings.filenames.HasAllowedExtension(firstLine);
+}
+
+bool IsCandidatePayload(std::wstring_view text, const EngineSettings& settings) {
+    if (settings.app.isCreateDirectoryStructureEnabled && HasTreeEvidence(text)) return true;
+    return ProbeHasFilenameLine(text, text.substr(0, kCandidateProbeLength), settings);
+}
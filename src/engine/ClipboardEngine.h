@@ -0,0 +1,230 @@
+//================================================================================================//
+//                                  Clipboard To File - Engine                                    //
+//                                                                                                //
+//  Platform-neutral classification and materialization logic. The engine takes a clipboard      //
+//  payload plus a settings snapshot and returns a plan; the Win32 tray app (and any other host)  //
+//  owns the clipboard, the UI and the choice of target directory.                                //
+//================================================================================================//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <string_view>
+#include "FilenameAcceptor.h"
+#include "LineIndex.h"
+#include "PatternSet.h"
+#include "Platform.h"
+
+
+//------------------------------------------------------------------------------------------------//
+//                                   SETTINGS & SNAPSHOTS                                         //
+//------------------------------------------------------------------------------------------------//
+// When created files are flushed to disk. Without a flush, a crash or power loss shortly after
+// "Structure Created" can lose files the user was told exist.
+enum class Durability : uint8_t {
+    None,       // Leave it to the OS, which writes back within about 30 seconds
+    PerBatch,   // Flush everything one structure or batch created together, once, at the end
+    PerFile,    // Flush each file's data as it is written; directories are still flushed at the end
+    Volume      // As PerBatch, but a large batch flushes its whole filesystem at once (syncfs, Linux)
+};
+
+// User-facing settings as persisted in config.json.
+struct AppSettings {
+    bool isCreateEmptyFileEnabled = true;
+    bool isCreateWithContentEnabled = true;
+    bool isCreateDirectoryStructureEnabled = true;
+    std::vector<std::wstring> allowedExtensions;
+    std::vector<std::wstring> contentCreationRegexes;
+    int heuristicWordCountLimit = 5;
+    bool createEmptyDirectories = true;
+    bool skipExistingDirectories = true;
+    int materializeThreads = 0;         // Threads that create a structure's files; 0 = automatic
+    bool useIoUring = true;             // Batch structure creation through io_uring where available (Linux)
+    FsWriteOptions writeOptions;        // How large file contents are written
+    Durability durability = Durability::PerBatch;
+    bool stageStructures = false;       // Build a structure in a hidden directory, then publish it with a few renames
+};
+
+// Settings plus everything derived from them (compiled patterns, filename acceptor). Built once
+// per settings load and passed by const reference to every engine call, so the engine never
+// touches host globals.
+struct EngineSettings {
+    AppSettings app;
+    PatternSet contentPatterns;
+    FilenameAcceptor filenames;
+};
+
+// Returns the built-in defaults written to config.json on first run.
+AppSettings GetDefaultSettings();
+
+// WriteStrategy as stored in config.json ("auto", "simple", "preallocate", "streaming").
+const char* WriteStrategyName(WriteStrategy strategy);
+WriteStrategy ParseWriteStrategy(std::string_view name, WriteStrategy fallback);
+
+// Durability as stored in config.json ("none", "batch", "file", "volume").
+const char* DurabilityName(Durability durability);
+Durability ParseDurability(std::string_view name, Durability fallback);
+
+// Compiles contentCreationRegexes into one automaton; invalid patterns are skipped.
+PatternSet CompileContentPatterns(const std::vector<std::wstring>& patterns);
+
+// Builds a ready-to-use snapshot from plain settings.
+EngineSettings CompileEngineSettings(const AppSettings& settings);
+
+
+//------------------------------------------------------------------------------------------------//
+//                                       PLAN TYPES                                               //
+//------------------------------------------------------------------------------------------------//
+// Enum for file conflict resolution actions
+enum class FileConflictAction {
+    Replace,
+    Skip,
+    Rename
+};
+
+const uint32_t kNoNode = UINT32_MAX;
+
+// One entry of a parsed structure. Names and contents are views into the clipboard text.
+struct TreeNode {
+    std::wstring_view name;
+    std::wstring_view content;  // For enhanced format with file contents
+    bool isDirectory = false;
+    uint32_t parent = kNoNode;
+    uint32_t firstChild = kNoNode;
+    uint32_t lastChild = kNoNode;
+    uint32_t nextSibling = kNoNode;
+};
+
+// Flat tree: every node in one array, linked by index. Node 0 is the synthetic root that stands
+// for the target directory. The clipboard text must outlive the tree.
+class DirectoryTree {
+public:
+    DirectoryTree();
+
+    static uint32_t Root() { return 0; }
+    size_t Size() const { return m_nodes.size(); }
+    const TreeNode& Node(uint32_t index) const { return m_nodes[index]; }
+    TreeNode& Node(uint32_t index) { return m_nodes[index]; }
+
+    // Appends a node as the last child of parent and returns its index.
+    uint32_t AddChild(uint32_t parent, std::wstring_view name, bool isDirectory);
+
+private:
+    std::vector<TreeNode> m_nodes;
+};
+
+enum class TreeFormat {
+    Unknown,
+    TreeCommand,      // Uses ├── └── characters
+    Indentation,      // Uses spaces/tabs
+    PathList,         // Full paths like path/to/file.txt
+    Enhanced          // With file content markers
+};
+
+// Result of the directory-structure detector.
+struct DirectoryStructurePlan {
+    TreeFormat format = TreeFormat::Unknown;
+    DirectoryTree tree;
+    int dirCount = 0;
+    int fileCount = 0;
+};
+
+enum class FileGenerationKind {
+    None,             // Not a file request
+    InvalidFilename,  // A pattern matched but the filename is unsafe; stop all further processing
+    SingleFile,       // One file, empty when content is empty
+    MultipleFiles     // Several empty files (batch creation)
+};
+
+// Result of the file-generation detector.
+struct FileGenerationPlan {
+    FileGenerationKind kind = FileGenerationKind::None;
+    std::wstring filename;               // SingleFile / InvalidFilename
+    std::wstring content;                // SingleFile
+    std::vector<std::wstring> filenames; // MultipleFiles
+};
+
+// Outcome of a multi-file batch.
+struct BatchResult {
+    int successCount = 0;
+    int skipCount = 0;
+    std::vector<std::wstring> failedFiles;
+    bool syncFailed = false;    // The files were created but could not be flushed to disk
+};
+
+// Outcome of a single-file creation.
+struct SingleFileResult {
+    bool success = false;
+    bool skipped = false;
+    bool syncFailed = false; // The file was created but could not be flushed to disk
+    std::wstring finalName;  // Differs from the requested name after a Rename
+};
+
+// Error details for the host to surface (toast, stderr, ...).
+struct MaterializeReport {
+    std::wstring errorTitle;
+    std::wstring errorMessage;
+    int dirCount = 0;           // StreamDirectoryStructure: what the payload listed
+    int fileCount = 0;
+};
+
+
+//------------------------------------------------------------------------------------------------//
+//                                 CLASSIFICATION (PURE)                                          //
+//------------------------------------------------------------------------------------------------//
+// Every detector and parser takes the payload's LineIndex, built once per clipboard event.
+int CountWords(std::wstring_view str);
+bool IsValidFilename(std::wstring_view filename);
+bool IsPathSafe(const std::wstring& path);
+bool MatchContentPattern(std::wstring_view firstLine, const EngineSettings& settings, std::wstring& filename);
+std::vector<std::wstring> FindAdditionalFilenames(const LineIndex& lines, size_t startPos, const EngineSettings& settings);
+FileGenerationPlan PlanFileGeneration(const LineIndex& lines, const EngineSettings& settings);
+
+// Early reject, run before the payload is indexed or copied. The tree evidence checks are linear
+// scans of the whole payload; the first-line filename checks look at no more than the first
+// kCandidateProbeLength characters. This is a heuristic: true only means some detector may accept
+// the payload, and false assumes that a first line running past the probe never names a file.
+const size_t kCandidateProbeLength = 4096;
+bool IsCandidatePayload(std::wstring_view text, const EngineSettings& settings);
+
+TreeFormat DetectTreeFormat(const LineIndex& lines);
+bool ParseTreeStructure(const LineIndex& lines, TreeFormat format, DirectoryTree& tree);
+DirectoryTree ParseTreeCommandFormat(const LineIndex& lines);
+DirectoryTree ParseIndentationFormat(const LineIndex& lines);
+DirectoryTree ParsePathListFormat(const LineIndex& lines);
+DirectoryTree ParseEnhancedFormat(const LineIndex& lines);
+void GetTreeSummary(const DirectoryTree& tree, int& dirCount, int& fileCount);
+bool PlanDirectoryStructure(const LineIndex& lines, const EngineSettings& settings, DirectoryStructurePlan& plan);
+
+
+//------------------------------------------------------------------------------------------------//
+//                                    MATERIALIZATION                                             //
+//------------------------------------------------------------------------------------------------//
+std::wstring JoinPath(const std::wstring& directory, const std::wstring& name);
+bool CreateFileWithContentAtomic(const std::wstring& targetPath, const std::wstring& content, const FsWriteOptions& writeOptions);
+bool CreateEmptyFileAtomic(const std::wstring& targetPath);
+
+// Polled between entries while a structure is created; true stops it (e.g. the host is exiting).
+using CancelCheck = std::function<bool()>;
+
+bool CreateDirectoryStructure(const DirectoryTree& tree, const std::wstring& basePath, const AppSettings& settings, MaterializeReport& report,
+    const CancelCheck& cancelled = nullptr);
+
+// Replaces chunk with the next piece of a payload; false once there is none.
+using TextChunkReader = std::function<bool(std::wstring& chunk)>;
+
+// Parses a PathList or Enhanced payload as read delivers it and creates the structure while it
+// goes, without holding the payload or its tree: memory is a chunk plus the entries' paths,
+// whatever the size of the file contents. Returns false without a message for a payload that
+// lists nothing.
+bool StreamDirectoryStructure(TreeFormat format, const TextChunkReader& read, const std::wstring& basePath,
+    const AppSettings& settings, MaterializeReport& report);
+
+void SplitExistingFiles(const std::wstring& directory, const std::vector<std::wstring>& filenames,
+    std::vector<std::wstring>& newFiles, std::vector<std::wstring>& existingFiles);
+BatchResult CreateFileBatch(const std::wstring& directory, const std::vector<std::wstring>& newFiles,
+    const std::vector<std::wstring>& existingFiles, FileConflictAction conflictAction, Durability durability);
+SingleFileResult CreateSingleFile(const std::wstring& directory, const std::wstring& filename,
+    const std::wstring& content, FileConflictAction conflictAction, const FsWriteOptions& writeOptions, Durability durability);
@@ -0,0 +1,34 @@
+//================================================================================================//
+//                            Clipboard To File - Coalescing queue                                //
+//                                                                                                //
+//  Hands work from the UI thread to a worker without locks. It holds at most one item: pushing  //
+//  while an item is still waiting replaces it, so a burst of updates collapses into its latest. //
+//================================================================================================//
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+
+template <typename T>
+class CoalescingQueue {
+public:
+    CoalescingQueue() = default;
+    ~CoalescingQueue() { delete m_slot.load(std::memory_order_acquire); }
+    CoalescingQueue(const CoalescingQueue&) = delete;
+    CoalescingQueue& operator=(const CoalescingQueue&) = delete;
+
+    // Publishes an item (any thread). Returns true when it replaced one that was never taken.
+    bool Push(std::unique_ptr<T> item) {
+        std::unique_ptr<T> replaced(m_slot.exchange(item.release(), std::memory_order_acq_rel));
+        return replaced != nullptr;
+    }
+
+    // Takes the latest item, or null when there is none.
+    std::unique_ptr<T> Take() {
+        return std::unique_ptr<T>(m_slot.exchange(nullptr, std::memory_order_acq_rel));
+    }
+
+private:
+    std::atomic<T*> m_slot{ nullptr };
+};
@@ -0,0 +1,155 @@
+//================================================================================================//
+//                            Clipboard To File - Directory snapshot                              //
+//================================================================================================//
+#include <cstdint>
+#include "DirectorySnapshot.h"
+
+
+namespace {
+
+#if defined(_WIN32) || defined(__APPLE__)
+constexpr bool kFoldCase = true;
+#else
+constexpr bool kFoldCase = false;
+#endif
+
+inline wchar_t FoldChar(wchar_t c) {
+    if (kFoldCase && c >= L'A' && c <= L'Z') return static_cast<wchar_t>(c + (L'a' - L'A'));
+    return c;
+}
+
+bool IsAscii(std::wstring_view name) {
+    for (wchar_t c : name) {
+        if (static_cast<uint32_t>(c) >= 0x80) return false;
+    }
+    return true;
+}
+
+bool HasSeparator(std::wstring_view name) {
+    return name.find_first_of(L"\\/") != std::wstring_view::npos;
+}
+
+// Splits at the last dot, the way the Rename action numbers names: "a.tar.gz" -> "a.tar" ".gz".
+void SplitName(std::wstring_view name, std::wstring_view& stem, std::wstring_view& ext) {
+    size_t dot = name.find_last_of(L'.');
+    if (dot == std::wstring_view::npos) dot = name.size();
+    stem = name.substr(0, dot);
+    ext = name.substr(dot);
+}
+
+// Separators cannot appear in a name, so "stem/ext" keeps stem and extension apart.
+std::wstring NumberKey(std::wstring_view stem, std::wstring_view ext) {
+    std::wstring key;
+    key.reserve(stem.size() + 1 + ext.size());
+    key.append(stem);
+    key += L'/';
+    key.append(ext);
+    return key;
+}
+
+// Reads "base (N)" into base and N; false for anything else.
+bool ParseNumberedStem(std::wstring_view stem, std::wstring_view& base, uint32_t& number) {
+    if (stem.size() < 4 || stem.back() != L')') return false;
+    size_t open = stem.rfind(L" (");
+    if (open == std::wstring_view::npos) return false;
+    std::wstring_view digits = stem.substr(open + 2, stem.size() - open - 3);
+    if (digits.empty() || digits.size() > 9) return false;
+    uint32_t value = 0;
+    for (wchar_t c : digits) {
+        if (c < L'0' || c > L'9') return false;
+        value = value * 10 + static_cast<uint32_t>(c - L'0');
+    }
+    base = stem.substr(0, open);
+    number = value;
+    return true;
+}
+
+} // namespace
+
+
+size_t DirectorySnapshot::NameHash::operator()(std::wstring_view name) const {
+    // FNV-1a over the folded characters
+    uint64_t hash = 14695981039346656037ull;
+    for (wchar_t c : name) {
+        hash ^= static_cast<uint32_t>(FoldChar(c));
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool DirectorySnapshot::NameEqual::operator()(std::wstring_view a, std::wstring_view b) const {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (FoldChar(a[i]) != FoldChar(b[i])) return false;
+    }
+    return true;
+}
+
+DirectorySnapshot::DirectorySnapshot(const std::wstring& directory)
+    : m_directory(directory) {
+    m_listed = FsListDirectory(directory, [this](std::wstring_view name, PathType type) { Add(name, type); });
+}
+
+PathType DirectorySnapshot::TypeOf(std::wstring_view name) const {
+    if (m_listed && !HasSeparator(name)) {
+        auto it = m_types.find(name);
+        if (it != m_types.end()) return it->second;
+        // Case-insensitive filesystems fold far more than ASCII; let the filesystem decide
+        if (!kFoldCase || IsAscii(name)) return PathType::None;
+    }
+    std::wstring path = m_directory;
+    if (!path.empty() && path.back() != L'\\' && path.back() != L'/') path += kPathSeparator;
+    path += name;
+    return FsGetPathType(path);
+}
+
+void DirectorySnapshot::Add(std::wstring_view name, PathType type) {
+    auto it = m_types.find(name);
+    if (it != m_types.end()) {
+        it->second = type;
+        return;
+    }
+    m_names.emplace_back(name);
+    m_types.emplace(m_names.back(), type);
+    if (m_numbersIndexed) IndexNumberedName(name);
+}
+
+void DirectorySnapshot::IndexNumberedName(std::wstring_view name) {
+    std::wstring_view stem, ext, base;
+    uint32_t number;
+    SplitName(name, stem, ext);
+    if (!ParseNumberedStem(stem, base, number)) return;
+    uint32_t& highest = m_highestNumber[NumberKey(base, ext)];
+    if (number > highest) highest = number;
+}
+
+std::wstring DirectorySnapshot::ReserveUniqueName(const std::wstring& filename) {
+    if (!Contains(filename)) {
+        Add(filename, PathType::File);
+        return filename;
+    }
+
+    if (!m_numbersIndexed) {
+        for (const auto& name : m_names) IndexNumberedName(name);
+        m_numbersIndexed = true;
+    }
+
+    std::wstring_view stem, ext;
+    SplitName(filename, stem, ext);
+    uint32_t& highest = m_highestNumber[NumberKey(stem, ext)];
+
+    // Above the highest number the listing is free by construction; the check only matters for
+    // names the listing cannot answer (see TypeOf)
+    std::wstring candidate;
+    do {
+        ++highest;
+        candidate.assign(stem);
+        candidate += L" (";
+        candidate += std::to_wstring(highest);
+        candidate += L')';
+        candidate.append(ext);
+    } while (Contains(candidate));
+
+    Add(candidate, PathType::File);
+    return candidate;
+}
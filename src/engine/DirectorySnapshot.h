@@ -0,0 +1,64 @@
+//================================================================================================//
+//                            Clipboard To File - Directory snapshot                              //
+//                                                                                                //
+//  Lists a directory once and answers "what is at directory/name" from memory for the rest of    //
+//  one clipboard event, instead of a stat per name. Names are matched the way the filesystem     //
+//  does: case-insensitively on Windows and macOS, where a non-ASCII name that is not found is    //
+//  still checked on disk, since only ASCII case folding is done here.                            //
+//                                                                                                //
+//  It also hands out free "stem (N)ext" names for the Rename conflict action: one pass over the  //
+//  listing finds the highest N per name, and every name handed out is recorded, so a batch of    //
+//  renames never collides with itself or probes numbers one at a time.                           //
+//================================================================================================//
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Platform.h"
+
+
+class DirectorySnapshot {
+public:
+    // Lists directory. A directory that cannot be listed (missing, no access) gives a snapshot
+    // that answers every query from the filesystem.
+    explicit DirectorySnapshot(const std::wstring& directory);
+    DirectorySnapshot(const DirectorySnapshot&) = delete;
+    DirectorySnapshot& operator=(const DirectorySnapshot&) = delete;
+
+    const std::wstring& Directory() const { return m_directory; }
+    bool IsListed() const { return m_listed; }
+    size_t Size() const { return m_types.size(); }
+
+    // What is at directory/name, where name is a single path component.
+    PathType TypeOf(std::wstring_view name) const;
+    bool Contains(std::wstring_view name) const { return TypeOf(name) != PathType::None; }
+
+    // Records an entry created after the listing, so later queries see it.
+    void Add(std::wstring_view name, PathType type);
+
+    // filename if nothing is there, otherwise "stem (N)ext" with N above every number already in
+    // use for that stem and extension. The name is recorded as a file before it is returned, so
+    // creating it is still up to the caller, preferably exclusively.
+    std::wstring ReserveUniqueName(const std::wstring& filename);
+
+private:
+    struct NameHash {
+        size_t operator()(std::wstring_view name) const;
+    };
+    struct NameEqual {
+        bool operator()(std::wstring_view a, std::wstring_view b) const;
+    };
+
+    std::wstring m_directory;
+    bool m_listed = false;
+    std::deque<std::wstring> m_names;   // Stable storage for the keys below
+    std::unordered_map<std::wstring_view, PathType, NameHash, NameEqual> m_types;
+
+    // Highest "(N)" per stem and extension, keyed "stem/ext"; built on the first reservation
+    void IndexNumberedName(std::wstring_view name);
+    bool m_numbersIndexed = false;
+    std::unordered_map<std::wstring, uint32_t, NameHash, NameEqual> m_highestNumber;
+};
@@ -0,0 +1,207 @@
+//================================================================================================//
+//                           Clipboard To File - Filename acceptor                                //
+//================================================================================================//
+#include <algorithm>
+#include <cwctype>
+#include "ClipboardEngine.h"
+#include "FilenameAcceptor.h"
+
+
+namespace {
+
+const size_t kMaxFilenameLength = 255;  // Windows component limit
+
+// Per-character facts for ASCII; anything above is rare in filenames and goes to the C library.
+struct AsciiTables {
+    bool invalid[128];      // \ / : * ? " < > | and control characters
+    bool space[128];        // iswspace in the C locale
+    wchar_t lower[128];
+};
+
+constexpr AsciiTables MakeAsciiTables() {
+    AsciiTables tables{};
+    for (int c = 0; c < 128; ++c) {
+        tables.invalid[c] = c <= 0x1F;
+        tables.space[c] = c == L' ' || (c >= L'\t' && c <= L'\r');
+        tables.lower[c] = static_cast<wchar_t>((c >= L'A' && c <= L'Z') ? c + (L'a' - L'A') : c);
+    }
+    for (wchar_t c : L"\\/:*?\"<>|") {
+        if (c) tables.invalid[c] = true;
+    }
+    return tables;
+}
+
+constexpr AsciiTables kAscii = MakeAsciiTables();
+
+// Reserved device names, compared against the uppercased part before the last dot.
+constexpr const wchar_t* kReservedNames[] = { L"CON", L"PRN", L"AUX", L"NUL" };
+constexpr const wchar_t* kNumberedDevices[] = { L"COM", L"LPT" };   // Followed by digits only
+
+inline bool IsAscii(wchar_t c) { return static_cast<uint32_t>(c) < 128; }
+
+inline bool IsSpace(wchar_t c) {
+    return IsAscii(c) ? kAscii.space[c] : std::iswspace(static_cast<wint_t>(c)) != 0;
+}
+
+inline wchar_t Lower(wchar_t c) {
+    return IsAscii(c) ? kAscii.lower[c] : static_cast<wchar_t>(std::towlower(static_cast<wint_t>(c)));
+}
+
+// Case-insensitive compare against an uppercase ASCII literal. No non-ASCII character
+// uppercases to the letters used by device names, so ASCII folding matches towupper here.
+bool EqualsUpperAscii(std::wstring_view text, const wchar_t* upper) {
+    size_t i = 0;
+    for (; upper[i]; ++i) {
+        if (i >= text.size()) return false;
+        wchar_t c = text[i];
+        if (c >= L'a' && c <= L'z') c = static_cast<wchar_t>(c - (L'a' - L'A'));
+        if (c != upper[i]) return false;
+    }
+    return i == text.size();
+}
+
+bool IsReservedBaseName(std::wstring_view base) {
+    if (base.size() == 3) {
+        for (const wchar_t* reserved : kReservedNames) {
+            if (EqualsUpperAscii(base, reserved)) return true;
+        }
+        return false;
+    }
+    if (base.size() < 4) return false;
+    for (const wchar_t* device : kNumberedDevices) {
+        if (!EqualsUpperAscii(base.substr(0, 3), device)) continue;
+        return std::all_of(base.begin() + 3, base.end(), [](wchar_t c) { return c >= L'0' && c <= L'9'; });
+    }
+    return false;
+}
+
+// The one pass behind every check: validity, position of the last dot and the word count.
+bool ScanName(std::wstring_view name, size_t& lastDot, int& words) {
+    lastDot = std::wstring_view::npos;
+    words = 0;
+    if (name.empty() || name.size() > kMaxFilenameLength) return false;
+
+    bool inWord = false;
+    for (size_t i = 0; i < name.size(); ++i) {
+        const wchar_t c = name[i];
+        if (IsAscii(c) && kAscii.invalid[c]) return false;
+        if (c == L'.') lastDot = i;
+        const bool space = IsSpace(c);
+        if (!space && !inWord) words++;
+        inWord = !space;
+    }
+
+    // A trailing period is not allowed on Windows (this also rejects names made only of dots)
+    if (name.back() == L'.') return false;
+
+    return !IsReservedBaseName(name.substr(0, lastDot));
+}
+
+uint32_t HashLowered(std::wstring_view text, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (wchar_t c : text) {
+        hash ^= static_cast<uint32_t>(Lower(c));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      COMPILATION                                               //
+//------------------------------------------------------------------------------------------------//
+FilenameAcceptor FilenameAcceptor::Compile(const AppSettings& settings) {
+    FilenameAcceptor acceptor;
+    acceptor.m_wordLimit = settings.heuristicWordCountLimit;
+
+    // Candidates are lowercased before comparison, so entries with uppercase never match.
+    for (const auto& extension : settings.allowedExtensions) {
+        bool lowercase = std::all_of(extension.begin(), extension.end(), [](wchar_t c) { return Lower(c) == c; });
+        if (!lowercase) continue;
+        if (std::find(acceptor.m_extensions.begin(), acceptor.m_extensions.end(), extension) != acceptor.m_extensions.end()) continue;
+        acceptor.m_extensions.push_back(extension);
+        acceptor.m_maxExtensionLength = std::max(acceptor.m_maxExtensionLength, extension.size());
+    }
+    if (acceptor.m_extensions.empty()) return acceptor;
+
+    // Search for a seed and table size that put every extension in its own slot, so a lookup is
+    // one hash, one slot and one compare. Without one, lookups fall back to a linear scan.
+    for (size_t size = 16; size <= (1u << 16); size *= 2) {
+        if (size < acceptor.m_extensions.size() * 2) continue;
+        for (uint32_t seed = 0; seed < 64; ++seed) {
+            std::vector<int32_t> slots(size, -1);
+            bool perfect = true;
+            for (size_t i = 0; i < acceptor.m_extensions.size() && perfect; ++i) {
+                int32_t& slot = slots[HashLowered(acceptor.m_extensions[i], seed) & (size - 1)];
+                if (slot != -1) perfect = false;
+                else slot = static_cast<int32_t>(i);
+            }
+            if (perfect) {
+                acceptor.m_slots = std::move(slots);
+                acceptor.m_seed = seed;
+                return acceptor;
+            }
+        }
+    }
+    return acceptor;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                        CHECKS                                                  //
+//------------------------------------------------------------------------------------------------//
+bool FilenameAcceptor::IsValidName(std::wstring_view name) {
+    size_t lastDot;
+    int words;
+    return ScanName(name, lastDot, words);
+}
+
+bool FilenameAcceptor::IsAllowed(std::wstring_view extension) const {
+    if (extension.size() > m_maxExtensionLength) return false;
+
+    auto matches = [&extension](const std::wstring& allowed) {
+        if (allowed.size() != extension.size()) return false;
+        for (size_t i = 0; i < allowed.size(); ++i) {
+            if (Lower(extension[i]) != allowed[i]) return false;
+        }
+        return true;
+    };
+
+    if (m_slots.empty()) {
+        return std::any_of(m_extensions.begin(), m_extensions.end(), matches);
+    }
+    int32_t index = m_slots[HashLowered(extension, m_seed) & (m_slots.size() - 1)];
+    return index >= 0 && matches(m_extensions[index]);
+}
+
+bool FilenameAcceptor::HasAllowedExtension(std::wstring_view path) const {
+    // The extension starts at the last dot, unless a separator comes after it.
+    size_t pos = path.size();
+    while (pos > 0) {
+        wchar_t c = path[pos - 1];
+        if (c == L'\\' || c == L'/') break;
+        if (c == L'.') return IsAllowed(path.substr(pos - 1));
+        --pos;
+    }
+    return IsAllowed(std::wstring_view());
+}
+
+bool FilenameAcceptor::Accepts(std::wstring_view candidate) const {
+    size_t lastDot;
+    int words;
+    if (!ScanName(candidate, lastDot, words) || words > m_wordLimit) return false;
+    // A valid name has no separators, so the last dot starts the extension.
+    return IsAllowed(lastDot == std::wstring_view::npos ? std::wstring_view() : candidate.substr(lastDot));
+}
+
+size_t FilenameAcceptor::AcceptMany(const std::vector<std::wstring_view>& candidates, std::vector<uint8_t>& accepted) const {
+    accepted.resize(candidates.size());
+    size_t count = 0;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        accepted[i] = Accepts(candidates[i]) ? 1 : 0;
+        count += accepted[i];
+    }
+    return count;
+}
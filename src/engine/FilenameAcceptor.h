@@ -0,0 +1,47 @@
+//================================================================================================//
+//                           Clipboard To File - Filename acceptor                                //
+//                                                                                                //
+//  Decides whether a span of clipboard text is a filename the app should create: Windows-valid,  //
+//  an allowed extension and within the word limit. Built once per settings load; every check    //
+//  is a single allocation-free pass over the span.                                               //
+//================================================================================================//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct AppSettings;
+
+
+class FilenameAcceptor {
+public:
+    // Captures allowedExtensions and heuristicWordCountLimit.
+    static FilenameAcceptor Compile(const AppSettings& settings);
+
+    // Windows filename rules: no separators, invalid or control characters, reserved device
+    // names, trailing period or more than 255 characters. Needs no settings.
+    static bool IsValidName(std::wstring_view name);
+
+    // Lowercased extension of the last path component is in allowedExtensions.
+    bool HasAllowedExtension(std::wstring_view path) const;
+
+    // Valid name with an allowed extension and at most heuristicWordCountLimit words.
+    bool Accepts(std::wstring_view candidate) const;
+
+    // Checks many candidates at once; accepted[i] is set to 0 or 1. Returns the number accepted.
+    size_t AcceptMany(const std::vector<std::wstring_view>& candidates, std::vector<uint8_t>& accepted) const;
+
+    int WordLimit() const { return m_wordLimit; }
+
+private:
+    // Lowercased extension (dot included, empty for none) is one of m_extensions.
+    bool IsAllowed(std::wstring_view extension) const;
+
+    std::vector<std::wstring> m_extensions;     // Distinct allowed extensions, as configured
+    std::vector<int32_t> m_slots;               // Perfect hash: slot -> extension index or -1
+    uint32_t m_seed = 0;
+    size_t m_maxExtensionLength = 0;
+    int m_wordLimit = 0;
+};
@@ -0,0 +1,53 @@
+//================================================================================================//
+//                               Clipboard To File - Line index                                   //
+//================================================================================================//
+#include <algorithm>
+#include <cwchar>
+#include "LineIndex.h"
+
+
+LineIndex::LineIndex(std::wstring_view text) : m_text(text) {
+    const wchar_t* data = text.data();
+    const size_t length = text.size();
+    m_lines.reserve(std::count(text.begin(), text.end(), L'\n') + 1);
+
+    size_t begin = 0;
+    while (begin < length) {
+        const wchar_t* newline = std::wmemchr(data + begin, L'\n', length - begin);
+        size_t end = newline ? static_cast<size_t>(newline - data) : length;
+
+        LineSpan span;
+        span.begin = begin;
+        span.end = end;
+
+        size_t pos = begin;
+        for (; pos < end; ++pos) {
+            if (data[pos] == L' ') span.indent++;
+            else if (data[pos] == L'\t') span.indent += 4;
+            else break;
+        }
+        span.trimBegin = pos;
+
+        size_t last = end;
+        while (last > pos && (data[last - 1] == L' ' || data[last - 1] == L'\t' || data[last - 1] == L'\r')) --last;
+        span.trimEnd = last;
+
+        m_lines.push_back(span);
+        begin = end + 1;
+    }
+}
+
+size_t LineIndex::FindLine(size_t offset) const {
+    auto it = std::upper_bound(m_lines.begin(), m_lines.end(), offset,
+        [](size_t value, const LineSpan& span) { return value < span.begin; });
+    if (it == m_lines.begin()) return m_lines.size();
+    size_t index = static_cast<size_t>(it - m_lines.begin()) - 1;
+    return offset <= m_lines[index].end ? index : m_lines.size();
+}
+
+std::wstring_view TrimView(std::wstring_view text, std::wstring_view chars) {
+    size_t first = text.find_first_not_of(chars);
+    if (first == std::wstring_view::npos) return text.substr(0, 0);
+    size_t last = text.find_last_not_of(chars);
+    return text.substr(first, last - first + 1);
+}
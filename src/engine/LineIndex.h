@@ -0,0 +1,48 @@
+//================================================================================================//
+//                               Clipboard To File - Line index                                   //
+//                                                                                                //
+//  Splits a clipboard payload into lines once per event. Every detector and parser works from   //
+//  these offsets into the original buffer instead of re-splitting (and copying) the text.        //
+//================================================================================================//
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+
+// One line of a payload as offsets into the original text.
+struct LineSpan {
+    size_t begin = 0;       // First character of the line
+    size_t end = 0;         // One past the last character; '\n' excluded, '\r' kept (like getline)
+    size_t trimBegin = 0;   // After leading spaces and tabs
+    size_t trimEnd = 0;     // Before trailing spaces, tabs and '\r'
+    int indent = 0;         // Leading whitespace width, tabs counted as 4 spaces
+};
+
+// Line boundaries of one payload, split exactly like repeated std::getline calls: there is no
+// empty line after a trailing '\n'. Holds a view, so the text must outlive the index.
+class LineIndex {
+public:
+    explicit LineIndex(std::wstring_view text);
+
+    std::wstring_view Text() const { return m_text; }
+    size_t Count() const { return m_lines.size(); }
+    const LineSpan& Span(size_t i) const { return m_lines[i]; }
+
+    std::wstring_view Line(size_t i) const {
+        return m_text.substr(m_lines[i].begin, m_lines[i].end - m_lines[i].begin);
+    }
+    std::wstring_view Trimmed(size_t i) const {
+        return m_text.substr(m_lines[i].trimBegin, m_lines[i].trimEnd - m_lines[i].trimBegin);
+    }
+
+    // Index of the line containing (or ending at) a text offset; Count() past the last line.
+    size_t FindLine(size_t offset) const;
+
+private:
+    std::wstring_view m_text;
+    std::vector<LineSpan> m_lines;
+};
+
+// Strips any of the given characters from both ends of a view.
+std::wstring_view TrimView(std::wstring_view text, std::wstring_view chars);
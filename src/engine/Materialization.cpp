@@ -0,0 +1,1133 @@
+//================================================================================================//
+//                          Clipboard To File - Materialization                                   //
+//                                                                                                //
+//  Turns plans into files and directories. Conflict decisions are made by the host beforehand    //
+//  and passed in; errors are returned rather than shown.                                         //
+//================================================================================================//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "ClipboardEngine.h"
+#include "DirectorySnapshot.h"
+#include "Platform.h"
+#include "StreamingTreeParser.h"
+#include "WorkerPool.h"
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      PATH HELPERS                                              //
+//------------------------------------------------------------------------------------------------//
+std::wstring JoinPath(const std::wstring& directory, const std::wstring& name) {
+    if (directory.empty()) return name;
+    wchar_t last = directory.back();
+    if (last == L'\\' || last == L'/') return directory + name;
+    return directory + kPathSeparator + name;
+}
+
+// Validates a path relative to the target directory: no traversal, no absolute or UNC paths.
+bool IsPathSafe(const std::wstring& path) {
+    if (path.empty()) return false;
+
+    // Check for path traversal
+    if (path.find(L"..\\") != std::wstring::npos || path.find(L"../") != std::wstring::npos) {
+        return false;
+    }
+    if (path == L".." || (path.length() >= 3 && path.compare(path.length() - 3, 3, L"\\..") == 0) ||
+        (path.length() >= 3 && path.compare(path.length() - 3, 3, L"/..") == 0)) {
+        return false;
+    }
+
+    // Check for absolute paths
+    if (path.length() >= 2 && path[1] == L':') return false;
+    if (path[0] == L'\\' || path[0] == L'/') return false;
+
+    // Check for UNC paths
+    if (path.length() >= 2 && path[0] == L'\\' && path[1] == L'\\') return false;
+
+    return true;
+}
+
+static std::wstring GetFileNamePart(const std::wstring& path) {
+    size_t sep = path.find_last_of(L"\\/");
+    return (sep == std::wstring::npos) ? path : path.substr(sep + 1);
+}
+
+static std::wstring GetDirectoryPart(const std::wstring& path) {
+    size_t sep = path.find_last_of(L"\\/");
+    return (sep == std::wstring::npos) ? std::wstring() : path.substr(0, sep);
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                              FILE CONFLICT RESOLUTION                                          //
+//------------------------------------------------------------------------------------------------//
+// Below this many names, a stat each is cheaper than listing the directory.
+const size_t kSnapshotMinNames = 16;
+
+// A name can be taken by someone else between the listing and the create; give up after this many.
+const int kUniqueCreateAttempts = 16;
+
+// Creates an empty file under a free "stem (N)ext" form of filename. The create is exclusive, so
+// a name taken since the listing was made fails and the next number is tried.
+static bool CreateUniqueFile(DirectorySnapshot& snapshot, const std::wstring& filename, std::wstring& finalName) {
+    for (int attempt = 0; attempt < kUniqueCreateAttempts; ++attempt) {
+        finalName = snapshot.ReserveUniqueName(filename);
+        std::wstring path = JoinPath(snapshot.Directory(), finalName);
+        if (FsCreateNewFile(path)) return true;
+        if (!FsPathExists(path)) return false;   // Failed for some other reason than the name
+    }
+    return false;
+}
+
+// Replaces targetPath with content; readers see the old file or the complete new one.
+bool CreateFileWithContentAtomic(const std::wstring& targetPath, const std::wstring& content, const FsWriteOptions& writeOptions) {
+    return FsReplaceTextFile(targetPath, content, writeOptions);
+}
+
+// Replaces targetPath with an empty file in one step.
+bool CreateEmptyFileAtomic(const std::wstring& targetPath) {
+    return FsReplaceTextFile(targetPath, std::wstring_view());
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      DURABILITY                                                //
+//------------------------------------------------------------------------------------------------//
+namespace {
+
+const size_t kSyncThreads = 16;     // Syncs wait on the disk, not the CPU, so this is not per core
+
+// Durability::Volume only: from here one syncfs beats syncing file by file (Linux). syncfs also
+// writes back every other program's dirty pages on the filesystem, which on a busy disk can stall
+// a paste for seconds, and the tray app pastes in the background. So the default, PerBatch, never
+// calls it and flushes the files in parallel instead; Volume is for users whose disk is mostly
+// this app's writes.
+const size_t kSyncfsMinFiles = 64;
+
+// What one operation wrote, flushed together at the end so the disk sees a few large flushes
+// instead of one per file. PerBatch and Volume flush the files' data and then every directory that
+// gained a name; under PerFile the data went out as it was written and only the directories are
+// left. An empty file has no data: flushing its directory is what makes it survive.
+class DeferredSync {
+public:
+    explicit DeferredSync(Durability durability) : m_durability(durability) {}
+
+    void AddFile(const std::wstring& path) {
+        if (m_durability == Durability::PerBatch || m_durability == Durability::Volume) m_files.push_back(path);
+    }
+    void AddDirectory(const std::wstring& path) {
+        if (m_durability != Durability::None) m_directories.push_back(path);
+    }
+
+    bool Flush() {
+        std::sort(m_directories.begin(), m_directories.end());
+        m_directories.erase(std::unique(m_directories.begin(), m_directories.end()), m_directories.end());
+        if (m_files.empty() && m_directories.empty()) return true;
+
+        // One syncfs covers data and directory entries alike. Everything here is under one base
+        // directory, so it is one filesystem unless something is mounted inside the tree.
+        if (m_durability == Durability::Volume && m_files.size() >= kSyncfsMinFiles && FsSyncFilesystem(m_directories.empty() ? m_files[0] : m_directories[0])) {
+            return true;
+        }
+
+        std::atomic<bool> ok{ true };
+        WorkerPool pool(std::min(kSyncThreads, std::max(m_files.size(), m_directories.size())));
+        pool.ForEach(m_files.size(), [&](size_t i) {
+            if (!FsSyncFile(m_files[i])) ok = false;
+        });
+        pool.ForEach(m_directories.size(), [&](size_t i) {
+            if (!FsSyncDirectory(m_directories[i])) ok = false;
+        });
+        return ok;
+    }
+
+private:
+    Durability m_durability;
+    std::vector<std::wstring> m_files;
+    std::vector<std::wstring> m_directories;
+};
+
+} // namespace
+
+
+//------------------------------------------------------------------------------------------------//
+//                                  DIRECTORY STRUCTURES                                          //
+//------------------------------------------------------------------------------------------------//
+// Appends one component to a path with JoinPath's separator rules.
+static void AppendPathComponent(std::wstring& path, std::wstring_view name) {
+    if (!path.empty() && path.back() != L'\\' && path.back() != L'/') path += kPathSeparator;
+    path += name;
+}
+
+// Removes a directory and everything in it. Only used on a stage, which holds nothing but what
+// this file created there; a link is still removed rather than followed.
+static bool RemoveTree(const std::wstring& path) {
+    std::vector<std::pair<std::wstring, PathType>> children;
+    FsListDirectory(path, [&](std::wstring_view name, PathType type) { children.emplace_back(std::wstring(name), type); });
+    for (const auto& child : children) {
+        std::wstring childPath = path;
+        AppendPathComponent(childPath, child.first);
+        if (FsDeleteFile(childPath)) continue;
+        if (child.second == PathType::Directory) RemoveTree(childPath);
+    }
+    return FsRemoveDirectory(path);
+}
+
+static const wchar_t kStagePrefix[] = L".ctf-stage-";
+static const int64_t kStaleStageSeconds = 60 * 60;  // Far longer than any paste runs
+
+// Removes the stages in basePath that a crash or a killed process left behind. A stage's name
+// starts with the wall-clock second it was made in; younger ones may belong to a running paste.
+static void RemoveStaleStages(const std::wstring& basePath, int64_t now) {
+    const size_t prefixLength = sizeof(kStagePrefix) / sizeof(wchar_t) - 1;
+    std::vector<std::wstring> stale;
+    FsListDirectory(basePath, [&](std::wstring_view name, PathType type) {
+        if (type != PathType::Directory || name.compare(0, prefixLength, kStagePrefix) != 0) return;
+        int64_t made = 0;      // Digits past now are not a stage of ours; the loop stops before they overflow
+        size_t pos = prefixLength;
+        for (; pos < name.size() && name[pos] >= L'0' && name[pos] <= L'9' && made < now; ++pos) made = made * 10 + (name[pos] - L'0');
+        if (pos > prefixLength && pos < name.size() && name[pos] == L'-' && now - made > kStaleStageSeconds) stale.emplace_back(name);
+    });
+    for (const auto& name : stale) {
+        std::wstring path = basePath;
+        AppendPathComponent(path, name);
+        RemoveTree(path);
+    }
+}
+
+// Makes a hidden directory inside basePath to build a structure in, first clearing out stale
+// ones. Inside rather than next to it, so the stage is on the same filesystem as every path it
+// is renamed to. Returns an empty path if the stage cannot be made.
+static std::wstring CreateStage(const std::wstring& basePath) {
+    static std::atomic<uint32_t> counter{ 0 };
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+    RemoveStaleStages(basePath, now);
+
+    std::wstring path = basePath;
+    AppendPathComponent(path, kStagePrefix + std::to_wstring(now) + L"-" + std::to_wstring(ticks) + L"-" + std::to_wstring(counter++));
+    return FsCreateHiddenDirectory(path) ? path : std::wstring();
+}
+
+namespace {
+
+const uint32_t kNoEntry = UINT32_MAX;
+const size_t kFilesPerWorker = 16;      // Below this many files per thread, threads cost more than they save
+const size_t kAutoMaxThreads = 16;
+
+// Outcome of one node; written by exactly one worker, read after the phase has finished.
+enum class EntryState : uint8_t {
+    Pending,
+    Created,
+    Existed,
+    FileInTheWay,   // A file sits where the directory should be and skipExistingDirectories is on
+    Conflict,       // Same, with skipExistingDirectories off
+    Failed,         // The filesystem refused
+    Skipped,        // An ancestor could not be created
+    Cancelled       // Not attempted: the caller asked to stop
+};
+
+struct MaterializeEntry {
+    uint32_t node;
+    uint32_t parent;            // Entry index of the containing directory, or kNoEntry for the base
+    std::wstring fullPath;
+    size_t relativeLength;      // Trailing part of fullPath that came from the clipboard
+    EntryState state;
+    uint32_t childCount;        // Directories: entries directly inside
+    uint32_t stageRoot;         // Staged entries: the entry whose rename publishes this one, else kNoEntry
+};
+
+bool IsUnusable(EntryState state) {
+    return state == EntryState::Conflict || state == EntryState::Failed || state == EntryState::Skipped || state == EntryState::Cancelled;
+}
+
+// A cancelled entry counts as a failure, so a staged structure is not published half-built.
+bool IsFailure(EntryState state) {
+    return state == EntryState::Conflict || state == EntryState::Failed || state == EntryState::Cancelled;
+}
+
+bool IsParentUnusable(const std::vector<MaterializeEntry>& entries, const MaterializeEntry& entry) {
+    return entry.parent != kNoEntry && IsUnusable(entries[entry.parent].state);
+}
+
+// State of a directory entry when something is already at its path.
+EntryState ExistingDirectoryState(PathType existing, bool skipExisting) {
+    switch (existing) {
+    case PathType::Directory:
+        return EntryState::Existed;
+    case PathType::File:
+        // File exists with same name; with skipping on, its children are still attempted
+        return skipExisting ? EntryState::FileInTheWay : EntryState::Conflict;
+    default:
+        return EntryState::Failed;   // Vanished between the attempt and the check
+    }
+}
+
+// Creates one directory or file with the plain filesystem calls. existing is what the caller
+// found at the path.
+EntryState CreateEntry(const MaterializeEntry& entry, const TreeNode& node, bool skipExisting, const FsWriteOptions& writeOptions, PathType existing) {
+    if (node.isDirectory) {
+        if (existing != PathType::None) return ExistingDirectoryState(existing, skipExisting);
+        return FsCreateDirectory(entry.fullPath) ? EntryState::Created : EntryState::Failed;
+    }
+
+    if (existing != PathType::None) return EntryState::Existed;
+    if (!node.content.empty()) return FsWriteTextFile(entry.fullPath, node.content, writeOptions) ? EntryState::Created : EntryState::Failed;
+    if (FsCreateNewFile(entry.fullPath)) return EntryState::Created;
+    // Taken since existing was found, e.g. by a name that differs only in case on Windows
+    return FsPathExists(entry.fullPath) ? EntryState::Existed : EntryState::Failed;
+}
+
+// Maps the outcome of a batched create onto the same states CreateEntry produces.
+EntryState BatchResultState(const FsCreateRequest& request, const MaterializeEntry& entry, bool skipExisting) {
+    switch (request.status) {
+    case FsCreateStatus::Created:
+        return EntryState::Created;
+    case FsCreateStatus::Exists:
+        return request.isDirectory ? ExistingDirectoryState(FsGetPathType(entry.fullPath), skipExisting) : EntryState::Existed;
+    default:
+        return EntryState::Failed;
+    }
+}
+
+size_t ResolveThreadCount(const AppSettings& settings, size_t fileCount) {
+    size_t threads = settings.materializeThreads > 0
+        ? static_cast<size_t>(settings.materializeThreads)
+        // Creating files is latency-bound, so more threads than cores still pays off
+        : std::min(kAutoMaxThreads, std::max<size_t>(4, std::thread::hardware_concurrency()));
+    return std::max<size_t>(1, std::min(threads, fileCount / kFilesPerWorker));
+}
+
+} // namespace
+
+// Creates the tree in three steps:
+//   1. Walk it in document order, building every path and rejecting the whole tree if any path
+//      is unsafe, before anything touches the disk.
+//   2. Create directories one depth level at a time; a level only depends on the one above it.
+//   3. Create the files, since each one only depends on its directory.
+// Steps 2 and 3 are submitted as batches where the platform supports it (io_uring on Linux) and
+// otherwise run on a worker pool.
+// A node whose directory could not be created is skipped, and everything else still goes ahead.
+// The report names the first failure in document order, so it does not depend on scheduling.
+// cancelled, when set, is polled before each entry (before each batch when batched); once it
+// returns true nothing more is created or flushed, and what was created stays, unless staged.
+// With stageStructures on, what is already on disk is checked first, and everything missing is
+// built in a hidden stage directory inside basePath and then renamed into place, one rename per
+// missing entry whose directory exists, never over anything. A failure anywhere leaves the target
+// as it was, and watchers see a few renames instead of every create.
+bool CreateDirectoryStructure(const DirectoryTree& tree, const std::wstring& basePath, const AppSettings& settings, MaterializeReport& report,
+    const CancelCheck& cancelled) {
+    const TreeNode& root = tree.Node(DirectoryTree::Root());
+    if (root.firstChild == kNoNode) return false;
+
+    bool skipExisting = settings.skipExistingDirectories;
+    bool createEmptyDirs = settings.createEmptyDirectories;
+    FsWriteOptions writeOptions = settings.writeOptions;
+    writeOptions.syncData = settings.durability == Durability::PerFile;
+
+    // One frame per open directory: the next child to visit and the directory's entry and paths.
+    struct Frame {
+        uint32_t next;
+        uint32_t entry;
+        size_t fullLength;
+        size_t relativeLength;
+    };
+    std::wstring fullPath = basePath;
+    std::wstring relativePath;
+    std::vector<Frame> stack;
+    stack.push_back({ root.firstChild, kNoEntry, fullPath.length(), 0 });
+
+    std::vector<MaterializeEntry> entries;
+    std::vector<std::vector<uint32_t>> directoryLevels;
+    std::vector<uint32_t> files;
+    bool rootHasFiles = false;
+    uint32_t baseChildCount = 0;
+
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next == kNoNode) {
+            stack.pop_back();
+            continue;
+        }
+        const uint32_t nodeIndex = frame.next;
+        const TreeNode& node = tree.Node(nodeIndex);
+        frame.next = node.nextSibling;
+
+        fullPath.resize(frame.fullLength);
+        relativePath.resize(frame.relativeLength);
+        AppendPathComponent(fullPath, node.name);
+        AppendPathComponent(relativePath, node.name);
+
+        // Security check (on the part that came from the clipboard)
+        if (!IsPathSafe(relativePath)) {
+            report.errorTitle = L"Security Error";
+            report.errorMessage = L"Invalid path detected: " + std::wstring(node.name);
+            return false;
+        }
+
+        const uint32_t entryIndex = static_cast<uint32_t>(entries.size());
+        entries.push_back({ nodeIndex, frame.entry, fullPath, relativePath.length(), EntryState::Pending, 0, kNoEntry });
+        if (frame.entry == kNoEntry) baseChildCount++;
+        else entries[frame.entry].childCount++;
+
+        if (node.isDirectory) {
+            const size_t depth = stack.size() - 1;
+            if (directoryLevels.size() <= depth) directoryLevels.resize(depth + 1);
+            directoryLevels[depth].push_back(entryIndex);
+            stack.push_back({ node.firstChild, entryIndex, fullPath.length(), relativePath.length() });
+        }
+        else {
+            files.push_back(entryIndex);
+            if (frame.entry == kNoEntry) rootHasFiles = true;
+        }
+    }
+
+    // A file listed twice in one directory is created once; the copies find it there, as they
+    // would if the files were created one after another.
+    std::unordered_set<std::wstring_view> filePaths;
+    filePaths.reserve(files.size());
+    size_t uniqueFiles = 0;
+    for (uint32_t index : files) {
+        if (filePaths.insert(entries[index].fullPath).second) files[uniqueFiles++] = index;
+        else entries[index].state = EntryState::Existed;
+    }
+    files.resize(uniqueFiles);
+
+    // Each step (one directory level, then all files) goes to the batched backend when the
+    // platform has one, otherwise to the worker pool, one entry per task.
+    const bool batched = settings.useIoUring && FsBatchCreateAvailable();
+    WorkerPool pool(batched ? 1 : ResolveThreadCount(settings, files.size()));
+    std::vector<FsCreateRequest> batch;
+    std::vector<uint32_t> batchEntries;
+    std::vector<uint32_t> sizedEntries;
+
+    // Latched, so every worker stops once any of them sees the request
+    std::atomic<bool> stopped{ false };
+    auto stopRequested = [&] {
+        if (!stopped && cancelled && cancelled()) stopped = true;
+        return stopped.load();
+    };
+
+    // What is already at an entry's path. Directories made by this call are known to be empty;
+    // directories that already existed and have many entries here are listed once (listings,
+    // indexed by entry, and baseListing); anything else costs a stat.
+    std::vector<std::unique_ptr<DirectorySnapshot>> listings(entries.size());
+    std::unique_ptr<DirectorySnapshot> baseListing;
+    std::vector<uint32_t> toList;
+
+    auto listParents = [&](const std::vector<uint32_t>& step) {
+        toList.clear();
+        bool listBase = false;
+        for (uint32_t index : step) {
+            if (entries[index].stageRoot != kNoEntry) continue;   // Made in the stage, which starts empty
+            const uint32_t parent = entries[index].parent;
+            if (parent == kNoEntry) {
+                listBase = listBase || (!baseListing && baseChildCount >= kSnapshotMinNames);
+            }
+            else if (entries[parent].state == EntryState::Existed && !listings[parent] && entries[parent].childCount >= kSnapshotMinNames) {
+                toList.push_back(parent);
+            }
+        }
+        std::sort(toList.begin(), toList.end());
+        toList.erase(std::unique(toList.begin(), toList.end()), toList.end());
+        if (listBase) baseListing.reset(new DirectorySnapshot(basePath));
+        pool.ForEach(toList.size(), [&](size_t i) {
+            listings[toList[i]].reset(new DirectorySnapshot(entries[toList[i]].fullPath));
+        });
+    };
+
+    auto existingType = [&](const MaterializeEntry& entry) {
+        if (entry.stageRoot != kNoEntry) return PathType::None;
+        const std::wstring_view name = tree.Node(entry.node).name;
+        if (entry.parent == kNoEntry) return baseListing ? baseListing->TypeOf(name) : FsGetPathType(entry.fullPath);
+        if (entries[entry.parent].state == EntryState::Created) return PathType::None;
+        const DirectorySnapshot* listing = listings[entry.parent].get();
+        return listing ? listing->TypeOf(name) : FsGetPathType(entry.fullPath);
+    };
+
+    // Keeps the listings current for the steps that follow (a file named like a directory made
+    // in an earlier step).
+    auto recordCreated = [&](const std::vector<uint32_t>& step) {
+        for (uint32_t index : step) {
+            const MaterializeEntry& entry = entries[index];
+            if (entry.state != EntryState::Created) continue;
+            DirectorySnapshot* listing = entry.parent == kNoEntry ? baseListing.get() : listings[entry.parent].get();
+            const TreeNode& node = tree.Node(entry.node);
+            if (listing) listing->Add(node.name, node.isDirectory ? PathType::Directory : PathType::File);
+        }
+    };
+
+    auto createStep = [&](const std::vector<uint32_t>& step) {
+        if (!batched) {
+            listParents(step);
+            pool.ForEach(step.size(), [&](size_t i) {
+                MaterializeEntry& entry = entries[step[i]];
+                entry.state = IsParentUnusable(entries, entry) ? EntryState::Skipped
+                    : stopRequested() ? EntryState::Cancelled
+                    : CreateEntry(entry, tree.Node(entry.node), skipExisting, writeOptions, existingType(entry));
+            });
+            recordCreated(step);
+            return;
+        }
+
+        batch.clear();
+        batchEntries.clear();
+        sizedEntries.clear();
+        for (uint32_t index : step) {
+            MaterializeEntry& entry = entries[index];
+            if (IsParentUnusable(entries, entry)) {
+                entry.state = EntryState::Skipped;
+                continue;
+            }
+            if (stopRequested()) {
+                entry.state = EntryState::Cancelled;
+                continue;
+            }
+            const TreeNode& node = tree.Node(entry.node);
+            // Large contents need the sized write path (preallocation, page-cache hints)
+            if (!node.isDirectory && ResolveWriteStrategy(writeOptions, MinUtf8Bytes(node.content)) != WriteStrategy::Simple) {
+                sizedEntries.push_back(index);
+                continue;
+            }
+            batch.push_back({ entry.fullPath, node.content, node.isDirectory, FsCreateStatus::Pending });
+            batchEntries.push_back(index);
+        }
+        bool submitted = FsCreateBatch(batch, writeOptions.syncData);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            MaterializeEntry& entry = entries[batchEntries[i]];
+            entry.state = submitted
+                ? BatchResultState(batch[i], entry, skipExisting)
+                : CreateEntry(entry, tree.Node(entry.node), skipExisting, writeOptions, FsGetPathType(entry.fullPath));
+        }
+        for (uint32_t index : sizedEntries) {
+            MaterializeEntry& entry = entries[index];
+            entry.state = stopRequested()
+                ? EntryState::Cancelled
+                : CreateEntry(entry, tree.Node(entry.node), skipExisting, writeOptions, FsGetPathType(entry.fullPath));
+        }
+    };
+
+    // Staging, first pass: settle every entry that is already on disk, top-down, without creating
+    // anything. A missing entry whose directory exists becomes a stage root, built in the stage
+    // together with everything below it and published with one rename. A directory listed again
+    // joins the first one's stage root, so both publish as one.
+    bool staging = settings.stageStructures;
+    bool createdBase = false;
+    std::vector<uint32_t> stageRoots;
+    std::unordered_map<std::wstring, uint32_t> stageRootByPath;
+    std::vector<std::wstring> publishPaths;     // Real path of each stage root
+    std::wstring stagePath;
+    auto resolveExisting = [&](const std::vector<uint32_t>& step) {
+        listParents(step);
+        for (uint32_t index : step) {
+            MaterializeEntry& entry = entries[index];
+            if (entry.parent != kNoEntry && entries[entry.parent].stageRoot != kNoEntry) {
+                entry.stageRoot = entries[entry.parent].stageRoot;
+                continue;
+            }
+            if (IsParentUnusable(entries, entry)) {
+                entry.state = EntryState::Skipped;
+                continue;
+            }
+            if (entry.parent != kNoEntry && entries[entry.parent].state == EntryState::FileInTheWay) {
+                entry.state = EntryState::Failed;   // Nothing can be created inside a file
+                continue;
+            }
+            const bool isDirectory = tree.Node(entry.node).isDirectory;
+            PathType existing = existingType(entry);
+            if (existing == PathType::None) {
+                auto earlier = stageRootByPath.emplace(entry.fullPath, index);
+                if (earlier.second) {
+                    entry.stageRoot = index;
+                    stageRoots.push_back(index);
+                    continue;
+                }
+                // Listed twice: the earlier entry is as good as on disk
+                const MaterializeEntry& first = entries[earlier.first->second];
+                if (isDirectory && tree.Node(first.node).isDirectory) {
+                    entry.stageRoot = first.stageRoot;
+                    continue;
+                }
+                existing = tree.Node(first.node).isDirectory ? PathType::Directory : PathType::File;
+            }
+            entry.state = isDirectory ? ExistingDirectoryState(existing, skipExisting) : EntryState::Existed;
+        }
+    };
+    auto stagedOnly = [&](const std::vector<uint32_t>& step) {
+        std::vector<uint32_t> staged;
+        for (uint32_t index : step) {
+            if (entries[index].stageRoot != kNoEntry) staged.push_back(index);
+        }
+        return staged;
+    };
+    // Where an entry is, or was meant to be, in the target, relative to basePath
+    auto targetRelativePath = [&](const MaterializeEntry& entry) {
+        std::wstring path = entry.fullPath;
+        if (entry.stageRoot != kNoEntry) {
+            const MaterializeEntry& stageRoot = entries[entry.stageRoot];
+            const size_t k = std::find(stageRoots.begin(), stageRoots.end(), entry.stageRoot) - stageRoots.begin();
+            path = publishPaths[k] + path.substr(stageRoot.fullPath.length());
+        }
+        return path.substr(path.length() - entry.relativeLength);
+    };
+
+    bool settled = false;   // Staging found nothing to create, or a conflict that fails the paste
+    if (staging) {
+        if (createEmptyDirs && rootHasFiles && !FsPathExists(basePath)) createdBase = FsCreateDirectories(basePath);
+        for (const auto& level : directoryLevels) resolveExisting(level);
+        resolveExisting(files);
+        std::sort(stageRoots.begin(), stageRoots.end());
+
+        settled = stageRoots.empty() || std::any_of(entries.begin(), entries.end(), [](const MaterializeEntry& entry) { return IsFailure(entry.state); });
+        if (!settled) stagePath = CreateStage(basePath);
+        if (stagePath.empty()) {
+            // Nothing staged after all; without a stage the entries are created in place below
+            for (auto& entry : entries) entry.stageRoot = kNoEntry;
+            stageRoots.clear();
+            staging = false;
+        }
+    }
+
+    if (staging) {
+        // Stage paths: root k is stage/k, everything below it keeps its names
+        for (size_t k = 0; k < stageRoots.size(); ++k) {
+            MaterializeEntry& entry = entries[stageRoots[k]];
+            publishPaths.push_back(entry.fullPath);
+            entry.fullPath = stagePath;
+            AppendPathComponent(entry.fullPath, std::to_wstring(k));
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            MaterializeEntry& entry = entries[i];
+            if (entry.stageRoot == kNoEntry || entry.stageRoot == i) continue;
+            if (entry.parent == kNoEntry || entries[entry.parent].stageRoot == kNoEntry) {
+                entry.fullPath = entries[entry.stageRoot].fullPath;     // Joined an earlier stage root
+                continue;
+            }
+            entry.fullPath = entries[entry.parent].fullPath;     // Parents come first in document order
+            AppendPathComponent(entry.fullPath, tree.Node(entry.node).name);
+        }
+
+        for (const auto& level : directoryLevels) createStep(stagedOnly(level));
+        createStep(stagedOnly(files));
+    }
+    else if (!settled) {
+        // Directories, parents before children
+        for (const auto& level : directoryLevels) createStep(level);
+
+        // Ensure parent directory exists. Every other parent is a directory entry created above.
+        if (createEmptyDirs && rootHasFiles && !FsPathExists(basePath)) createdBase = FsCreateDirectories(basePath);
+
+        // Files
+        createStep(files);
+    }
+
+    // Flush what was created: file data, then each directory that gained a name. Staged, that is
+    // everything in the stage, flushed before it is published, and then the directories the
+    // stage roots were renamed into.
+    DeferredSync contentSync(settings.durability);
+    DeferredSync publishSync(settings.durability);
+    DeferredSync& targetSync = staging ? publishSync : contentSync;
+    std::vector<bool> gainedName(entries.size(), false);
+    bool baseGainedName = false;
+    for (const auto& entry : entries) {
+        if (entry.state != EntryState::Created) continue;
+        if (entry.parent == kNoEntry) baseGainedName = true;
+        else gainedName[entry.parent] = true;
+        const TreeNode& node = tree.Node(entry.node);
+        if (!node.isDirectory && !node.content.empty()) contentSync.AddFile(entry.fullPath);
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (gainedName[i]) (entries[i].stageRoot != kNoEntry ? contentSync : targetSync).AddDirectory(entries[i].fullPath);
+    }
+    if (baseGainedName) targetSync.AddDirectory(basePath);
+    if (createdBase) {
+        const std::wstring baseParent = GetDirectoryPart(basePath);
+        if (!baseParent.empty()) targetSync.AddDirectory(baseParent);
+    }
+
+    bool synced = true;
+    if (stopped) {
+        // A flush can take seconds; the caller asked for a prompt stop
+        if (staging) RemoveTree(stagePath);
+        report.errorTitle = L"Cancelled";
+        report.errorMessage = staging
+            ? L"The structure was not created"
+            : L"Stopped before the structure was complete; what was created is kept";
+        return false;
+    }
+    if (staging) {
+        // All or nothing: publish only a complete stage, and take back what went out if a name
+        // was taken since it was checked
+        if (!std::any_of(entries.begin(), entries.end(), [](const MaterializeEntry& entry) { return IsFailure(entry.state); })) {
+            synced = contentSync.Flush();
+            size_t published = 0;
+            while (published < stageRoots.size() && FsRenameNoReplace(entries[stageRoots[published]].fullPath, publishPaths[published])) {
+                published++;
+            }
+            if (published < stageRoots.size()) {
+                entries[stageRoots[published]].state = EntryState::Failed;
+                while (published > 0) {
+                    published--;
+                    FsRenameNoReplace(publishPaths[published], entries[stageRoots[published]].fullPath);
+                }
+            }
+            else {
+                synced = publishSync.Flush() && synced;
+            }
+        }
+        RemoveTree(stagePath);
+    }
+    else {
+        synced = contentSync.Flush();
+    }
+
+    // Report the first failure in document order
+    size_t failures = 0;
+    const MaterializeEntry* first = nullptr;
+    for (const auto& entry : entries) {
+        if (!IsFailure(entry.state)) continue;
+        if (!first) first = &entry;
+        failures++;
+    }
+    if (!first && !synced) {
+        report.errorTitle = L"Error";
+        report.errorMessage = L"The structure was created but could not be flushed to disk";
+        return false;
+    }
+    if (!first) return true;
+
+    report.errorTitle = L"Error";
+    report.errorMessage = first->state == EntryState::Conflict
+        ? L"File exists with directory name: " + std::wstring(tree.Node(first->node).name)
+        : L"Could not create: " + targetRelativePath(*first);
+    if (failures > 1) {
+        report.errorMessage += L" (and " + std::to_wstring(failures - 1) + L" more)";
+    }
+    return false;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                  STREAMED STRUCTURES                                           //
+//------------------------------------------------------------------------------------------------//
+namespace {
+
+// Creates entries as StreamingTreeParser reports them, with the rules CreateDirectoryStructure
+// applies to a whole tree. Each entry is settled on arrival: something already at its path is
+// kept, and a missing entry whose directory exists is created, in the stage when staging is on
+// (a stage root, as in CreateDirectoryStructure). Content is written while it streams in.
+class StreamMaterializer : public TreeOperationSink {
+public:
+    StreamMaterializer(const std::wstring& basePath, const AppSettings& settings)
+        : m_settings(settings), m_staging(settings.stageStructures) {
+        StreamEntry base;
+        base.path = basePath;
+        base.state = EntryState::Existed;
+        if (settings.createEmptyDirectories && !FsPathExists(basePath) && FsCreateDirectories(basePath)) {
+            base.state = EntryState::Created;
+            m_createdBase = true;
+        }
+        m_entries.push_back(base);
+    }
+
+    bool AddEntry(uint32_t parent, std::wstring_view name, bool isDirectory) override {
+        const uint32_t index = static_cast<uint32_t>(m_entries.size());
+        StreamEntry entry;
+        entry.parent = parent;
+        entry.isDirectory = isDirectory;
+        entry.path = m_entries[parent].path;
+        AppendPathComponent(entry.path, name);
+        const size_t parentRelative = m_entries[parent].relativeLength;
+        entry.relativeLength = parentRelative + (parentRelative > 0 ? 1 : 0) + name.size();
+
+        // Security check (on the part that came from the clipboard)
+        if (!IsPathSafe(entry.path.substr(entry.path.length() - entry.relativeLength))) {
+            m_unsafeName.assign(name);
+            return false;
+        }
+
+        const StreamEntry& owner = m_entries[parent];
+        if (IsUnusable(owner.state)) {
+            entry.state = EntryState::Skipped;
+        }
+        else if (owner.state == EntryState::FileInTheWay) {
+            entry.state = EntryState::Failed;   // Nothing can be created inside a file
+        }
+        else if (owner.stageRoot != kNoEntry) {
+            entry.stageRoot = owner.stageRoot;
+        }
+        else {
+            PathType existing = owner.state == EntryState::Created ? PathType::None : FsGetPathType(entry.path);
+            auto earlier = existing == PathType::None ? m_stageRootByPath.find(entry.path) : m_stageRootByPath.end();
+            if (earlier != m_stageRootByPath.end()) {
+                // Listed twice: a directory joins the earlier stage root, anything else finds it taken
+                const StreamEntry& first = m_entries[earlier->second];
+                if (isDirectory && first.isDirectory) entry.stageRoot = earlier->second;
+                else existing = first.isDirectory ? PathType::Directory : PathType::File;
+            }
+            if (existing == PathType::None) {
+                if (entry.stageRoot == kNoEntry && !Abandoned() && EnsureStage()) {
+                    entry.stageRoot = index;
+                    entry.stageSlot = static_cast<uint32_t>(m_stageRoots.size());
+                    m_stageRoots.push_back(index);
+                    m_stageRootByPath.emplace(entry.path, index);
+                }
+            }
+            else {
+                entry.state = isDirectory ? ExistingDirectoryState(existing, m_settings.skipExistingDirectories) : EntryState::Existed;
+            }
+        }
+        m_entries.push_back(std::move(entry));
+
+        StreamEntry& added = m_entries.back();
+        if (added.state == EntryState::Pending && !Abandoned()) {
+            const std::wstring path = PhysicalPath(index);
+            if (isDirectory) added.state = FsCreateDirectory(path) ? EntryState::Created : ExistingDirectoryState(FsGetPathType(path), m_settings.skipExistingDirectories);
+            else if (FsCreateNewFile(path)) added.state = EntryState::Created;
+            else added.state = FsPathExists(path) ? EntryState::Existed : EntryState::Failed;   // Listed twice
+        }
+        if (added.state == EntryState::Created) m_entries[parent].gainedName = true;
+        NoteState(index);
+        return true;
+    }
+
+    bool BeginContent(const std::vector<uint32_t>& files) override {
+        m_sections.clear();
+        if (Abandoned()) return true;
+        for (uint32_t index : files) {
+            // Like CreateDirectoryStructure, content only goes to files this call created
+            if (m_entries[index].state != EntryState::Created) continue;
+            SectionFile section;
+            section.entry = index;
+            section.path = PhysicalPath(index);
+            // A second section for the file goes to a temp sibling until it is complete
+            if (m_entries[index].hasContent) section.tempPath = JoinPath(GetDirectoryPart(section.path), L"." + GetFileNamePart(section.path) + L".section.tmp");
+            section.file.reset(new FsTextFileWriter());
+            if (!section.file->Open(section.tempPath.empty() ? section.path : section.tempPath)) {
+                m_entries[index].state = EntryState::Failed;
+                NoteState(index);
+                continue;
+            }
+            m_sections.push_back(std::move(section));
+        }
+        return true;
+    }
+
+    bool AppendContent(std::wstring_view text) override {
+        for (auto& section : m_sections) {
+            if (!section.file || section.file->Append(text)) continue;
+            DiscardSection(section);
+            m_entries[section.entry].state = EntryState::Failed;
+            NoteState(section.entry);
+        }
+        return true;
+    }
+
+    bool EndContent(bool complete) override {
+        for (auto& section : m_sections) {
+            if (!section.file) continue;
+            if (!complete) {
+                DiscardSection(section);
+                continue;
+            }
+            bool written = section.file->Close(m_settings.durability == Durability::PerFile);
+            section.file.reset();
+            if (written && !section.tempPath.empty()) written = FsReplaceFile(section.tempPath, section.path);
+            if (written) {
+                m_entries[section.entry].hasContent = true;
+                continue;
+            }
+            if (!section.tempPath.empty()) FsDeleteFile(section.tempPath);
+            m_entries[section.entry].state = EntryState::Failed;
+            NoteState(section.entry);
+        }
+        m_sections.clear();
+        return true;
+    }
+
+    // Publishes and flushes what was created, or with staging on and anything wrong, removes it
+    // all. parsed is false when the parse stopped early.
+    bool Finish(bool parsed, MaterializeReport& report) {
+        for (auto& section : m_sections) DiscardSection(section);
+        m_sections.clear();
+
+        const bool complete = parsed && m_unsafeName.empty() && m_failures == 0;
+        DeferredSync contentSync(m_settings.durability);
+        DeferredSync publishSync(m_settings.durability);
+        DeferredSync& targetSync = m_staging ? publishSync : contentSync;
+        bool synced = true;
+        if (complete || !m_staging) {
+            for (uint32_t i = 0; i < m_entries.size(); ++i) {
+                const StreamEntry& entry = m_entries[i];
+                if (entry.gainedName) (entry.stageRoot != kNoEntry ? contentSync : targetSync).AddDirectory(PhysicalPath(i));
+                if (entry.hasContent && entry.state == EntryState::Created) contentSync.AddFile(PhysicalPath(i));
+            }
+            if (m_createdBase) {
+                const std::wstring baseParent = GetDirectoryPart(m_entries[0].path);
+                if (!baseParent.empty()) targetSync.AddDirectory(baseParent);
+            }
+            synced = contentSync.Flush();
+        }
+
+        if (m_staging && !m_stagePath.empty()) {
+            if (complete) {
+                // Same all-or-nothing publish as CreateDirectoryStructure
+                size_t published = 0;
+                while (published < m_stageRoots.size() && FsRenameNoReplace(PhysicalPath(m_stageRoots[published]), m_entries[m_stageRoots[published]].path)) {
+                    published++;
+                }
+                if (published < m_stageRoots.size()) {
+                    m_entries[m_stageRoots[published]].state = EntryState::Failed;
+                    NoteState(m_stageRoots[published]);
+                    while (published > 0) {
+                        published--;
+                        FsRenameNoReplace(m_entries[m_stageRoots[published]].path, PhysicalPath(m_stageRoots[published]));
+                    }
+                }
+                else {
+                    synced = publishSync.Flush() && synced;
+                }
+            }
+            RemoveTree(m_stagePath);
+        }
+
+        if (!m_unsafeName.empty()) {
+            report.errorTitle = L"Security Error";
+            report.errorMessage = L"Invalid path detected: " + m_unsafeName;
+            return false;
+        }
+        if (m_failures == 0) {
+            if (!parsed) return false;
+            if (synced) return true;
+            report.errorTitle = L"Error";
+            report.errorMessage = L"The structure was created but could not be flushed to disk";
+            return false;
+        }
+
+        const StreamEntry& first = m_entries[m_firstFailure];
+        report.errorTitle = L"Error";
+        report.errorMessage = first.state == EntryState::Conflict
+            ? L"File exists with directory name: " + GetFileNamePart(first.path)
+            : L"Could not create: " + first.path.substr(first.path.length() - first.relativeLength);
+        if (m_failures > 1) {
+            report.errorMessage += L" (and " + std::to_wstring(m_failures - 1) + L" more)";
+        }
+        return false;
+    }
+
+private:
+    struct StreamEntry {
+        std::wstring path;              // Where it goes in the target
+        size_t relativeLength = 0;      // Trailing part of path that came from the clipboard
+        uint32_t parent = kNoEntry;
+        uint32_t stageRoot = kNoEntry;  // As in MaterializeEntry
+        uint32_t stageSlot = 0;         // Stage roots: built at stage/<slot>
+        EntryState state = EntryState::Pending;
+        bool isDirectory = true;
+        bool gainedName = false;
+        bool hasContent = false;        // A complete section was written to it
+    };
+
+    struct SectionFile {
+        uint32_t entry;
+        std::wstring path;
+        std::wstring tempPath;          // Set when the file already has content from an earlier section
+        std::unique_ptr<FsTextFileWriter> file;
+    };
+
+    // Where an entry is on disk right now: in the stage until it is published.
+    std::wstring PhysicalPath(uint32_t index) const {
+        const StreamEntry& entry = m_entries[index];
+        if (entry.stageRoot == kNoEntry) return entry.path;
+        const StreamEntry& root = m_entries[entry.stageRoot];
+        std::wstring path = m_stagePath;
+        AppendPathComponent(path, std::to_wstring(root.stageSlot));
+        path.append(entry.path, root.path.length(), std::wstring::npos);
+        return path;
+    }
+
+    // The stage, made when the first stage root needs it. Without one, entries go straight in.
+    bool EnsureStage() {
+        if (m_staging && m_stagePath.empty()) {
+            m_stagePath = CreateStage(m_entries[0].path);
+            m_staging = !m_stagePath.empty();
+        }
+        return m_staging;
+    }
+
+    // Counts a failure. A staged structure cannot be published after one: the rest is still
+    // parsed and checked for the report, but nothing more is written.
+    void NoteState(uint32_t index) {
+        if (!IsFailure(m_entries[index].state)) return;
+        if (m_failures++ == 0) m_firstFailure = index;
+        if (!Abandoned()) return;
+        for (auto& section : m_sections) DiscardSection(section);
+    }
+
+    bool Abandoned() const { return m_staging && m_failures > 0; }
+
+    void DiscardSection(SectionFile& section) {
+        if (!section.file) return;
+        section.file->Close();
+        section.file.reset();
+        // The file keeps what it had: nothing before its first section, the last one after that
+        if (!section.tempPath.empty()) FsDeleteFile(section.tempPath);
+        else FsWriteTextFile(section.path, std::wstring_view());
+    }
+
+    const AppSettings& m_settings;
+    bool m_staging;
+    bool m_createdBase = false;
+    std::wstring m_stagePath;
+    std::vector<StreamEntry> m_entries;     // By entry number; 0 is basePath
+    std::vector<uint32_t> m_stageRoots;     // In slot order
+    std::unordered_map<std::wstring, uint32_t> m_stageRootByPath;
+    std::vector<SectionFile> m_sections;    // Files the open section writes to
+    std::wstring m_unsafeName;
+    size_t m_failures = 0;
+    uint32_t m_firstFailure = 0;
+};
+
+} // namespace
+
+// Same outcome as parsing the whole payload and calling CreateDirectoryStructure, except that:
+//   - the target directory is created up front (with createEmptyDirectories);
+//   - an unsafe path stops the paste where it appears, and without staging what came before it
+//     stays;
+//   - a name listed as both a file and a directory becomes whichever comes first;
+//   - the report names the first failure in payload order, not tree order.
+bool StreamDirectoryStructure(TreeFormat format, const TextChunkReader& read, const std::wstring& basePath, const AppSettings& settings, MaterializeReport& report) {
+    if (format != TreeFormat::PathList && format != TreeFormat::Enhanced) return false;
+
+    StreamMaterializer sink(basePath, settings);
+    StreamingTreeParser parser(format, sink);
+    std::wstring chunk;
+    bool parsed = true;
+    while (parsed && read(chunk)) parsed = parser.Feed(chunk);
+    parsed = parser.Finish() && parsed;
+
+    report.dirCount = parser.DirectoryCount();
+    report.fileCount = parser.FileCount();
+    if (report.dirCount + report.fileCount == 0) return false;
+    return sink.Finish(parsed, report);
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      FILE CREATION                                             //
+//------------------------------------------------------------------------------------------------//
+// Separates a batch into names that are free and names that already exist in the directory.
+void SplitExistingFiles(const std::wstring& directory, const std::vector<std::wstring>& filenames,
+    std::vector<std::wstring>& newFiles, std::vector<std::wstring>& existingFiles) {
+    std::unique_ptr<DirectorySnapshot> snapshot;
+    if (filenames.size() >= kSnapshotMinNames) snapshot.reset(new DirectorySnapshot(directory));
+    for (const auto& fname : filenames) {
+        if (snapshot ? snapshot->Contains(fname) : FsPathExists(JoinPath(directory, fname))) {
+            existingFiles.push_back(fname);
+        }
+        else {
+            newFiles.push_back(fname);
+        }
+    }
+}
+
+// Creates a batch of empty files; existing files are handled with one action for all of them.
+BatchResult CreateFileBatch(const std::wstring& directory, const std::vector<std::wstring>& newFiles,
+    const std::vector<std::wstring>& existingFiles, FileConflictAction conflictAction, Durability durability) {
+    BatchResult result;
+
+    // Create new files first
+    for (const auto& fname : newFiles) {
+        if (FsCreateNewFile(JoinPath(directory, fname))) {
+            result.successCount++;
+        }
+        else {
+            result.failedFiles.push_back(fname);
+        }
+    }
+
+    // Handle existing files based on user choice. Renames share one listing of the directory,
+    // taken now rather than before the conflict dialog, which reserves each name they take.
+    std::unique_ptr<DirectorySnapshot> snapshot;
+    for (const auto& fname : existingFiles) {
+        if (conflictAction == FileConflictAction::Skip) {
+            result.skipCount++;
+            continue;
+        }
+
+        bool created;
+        if (conflictAction == FileConflictAction::Rename) {
+            if (!snapshot) snapshot.reset(new DirectorySnapshot(directory));
+            std::wstring uniqueName;
+            created = CreateUniqueFile(*snapshot, fname, uniqueName);
+        }
+        else {
+            created = CreateEmptyFileAtomic(JoinPath(directory, fname));
+        }
+
+        if (created) {
+            result.successCount++;
+        }
+        else {
+            result.failedFiles.push_back(fname);
+        }
+    }
+
+    // The files are empty, so flushing the directory is all either mode needs
+    if (result.successCount > 0) {
+        DeferredSync deferredSync(durability);
+        deferredSync.AddDirectory(directory);
+        result.syncFailed = !deferredSync.Flush();
+    }
+    return result;
+}
+
+// Creates one file (empty or with content). conflictAction only applies if the file exists.
+SingleFileResult CreateSingleFile(const std::wstring& directory, const std::wstring& filename,
+    const std::wstring& content, FileConflictAction conflictAction, const FsWriteOptions& options, Durability durability) {
+    SingleFileResult result;
+    result.finalName = filename;
+
+    // One file is its own batch. Replacing also needs the data on disk before the rename, or a
+    // crash could leave neither the old content nor the new.
+    FsWriteOptions writeOptions = options;
+    writeOptions.syncData = durability != Durability::None;
+    DeferredSync deferredSync(durability);
+    deferredSync.AddDirectory(directory);
+
+    std::wstring fullPath = JoinPath(directory, filename);
+
+    bool exists = FsPathExists(fullPath);
+    if (exists) {
+        switch (conflictAction) {
+        case FileConflictAction::Skip:
+            result.skipped = true;
+            return result;
+        case FileConflictAction::Rename: {
+            // Claim the name with an exclusive create, then write into the file we own
+            DirectorySnapshot snapshot(directory);
+            result.success = CreateUniqueFile(snapshot, filename, result.finalName);
+            if (result.success && !content.empty()) {
+                result.success = FsWriteTextFile(JoinPath(directory, result.finalName), content, writeOptions);
+            }
+            result.syncFailed = result.success && !deferredSync.Flush();
+            return result;
+        }
+        case FileConflictAction::Replace:
+            // Will use atomic replacement
+            break;
+        }
+    }
+
+    if (content.empty()) {
+        result.success = exists ? CreateEmptyFileAtomic(fullPath) : FsCreateNewFile(fullPath);
+    }
+    else {
+        result.success = exists ? CreateFileWithContentAtomic(fullPath, content, writeOptions) : FsWriteTextFile(fullPath, content, writeOptions);
+    }
+    result.syncFailed = result.success && !deferredSync.Flush();
+    return result;
+}
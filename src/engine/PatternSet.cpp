@@ -0,0 +1,1002 @@
+//================================================================================================//
+//                               Clipboard To File - Pattern set                                  //
+//================================================================================================//
+#include <algorithm>
+#include <climits>
+#include <cwchar>
+#include <cwctype>
+#include <map>
+#include <queue>
+#include "PatternSet.h"
+
+
+namespace {
+
+const uint32_t kMaxCodeUnit = static_cast<uint32_t>(WCHAR_MAX);
+const size_t kMaxProgramSize = 8192;    // Per pattern; larger patterns use std::wregex
+const size_t kMaxDfaStates = 1024;      // Beyond this the Pike VM is used for every match
+const size_t kNoCapture = static_cast<size_t>(-1);
+
+using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+void NormalizeRanges(Ranges& ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    Ranges merged;
+    for (const auto& r : ranges) {
+        if (!merged.empty() && r.first <= merged.back().second + 1) {
+            merged.back().second = std::max(merged.back().second, r.second);
+        }
+        else {
+            merged.push_back(r);
+        }
+    }
+    ranges.swap(merged);
+}
+
+Ranges NegateRanges(const Ranges& ranges) {
+    Ranges negated;
+    uint32_t next = 0;
+    for (const auto& r : ranges) {
+        if (r.first > next) negated.push_back({ next, r.first - 1 });
+        if (r.second >= kMaxCodeUnit) return negated;
+        next = r.second + 1;
+    }
+    negated.push_back({ next, kMaxCodeUnit });
+    return negated;
+}
+
+// Adds the other-case form of every code point, mirroring regex icase translation.
+void FoldCase(Ranges& ranges) {
+    Ranges extra;
+    for (const auto& r : ranges) {
+        if (r.second - r.first > 0xFFFF) continue; // Huge ranges already cover both cases
+        for (uint32_t c = r.first; c <= r.second && c <= 0xFFFF; ++c) {
+            uint32_t lower = static_cast<uint32_t>(std::towlower(static_cast<wint_t>(c)));
+            uint32_t upper = static_cast<uint32_t>(std::towupper(static_cast<wint_t>(c)));
+            if (lower != c) extra.push_back({ lower, lower });
+            if (upper != c) extra.push_back({ upper, upper });
+        }
+    }
+    ranges.insert(ranges.end(), extra.begin(), extra.end());
+    NormalizeRanges(ranges);
+}
+
+void AddDigit(Ranges& r) { r.push_back({ L'0', L'9' }); }
+void AddWord(Ranges& r) {
+    r.push_back({ L'0', L'9' });
+    r.push_back({ L'A', L'Z' });
+    r.push_back({ L'_', L'_' });
+    r.push_back({ L'a', L'z' });
+}
+void AddSpace(Ranges& r) {
+    // ECMAScript WhiteSpace and LineTerminator
+    const uint32_t singles[] = { 0x20, 0xA0, 0x1680, 0x2028, 0x2029, 0x202F, 0x205F, 0x3000, 0xFEFF };
+    r.push_back({ 0x09, 0x0D });
+    r.push_back({ 0x2000, 0x200A });
+    for (uint32_t c : singles) r.push_back({ c, c });
+}
+
+//------------------------------------------------------------------------------------------------//
+//                                         PARSER                                                 //
+//------------------------------------------------------------------------------------------------//
+struct AstNode {
+    enum class Kind { Empty, Class, Concat, Alternate, Repeat, Group, Begin, End };
+    Kind kind = Kind::Empty;
+    std::vector<int> kids;
+    int cls = -1;
+    int min = 0;
+    int max = 0;        // -1 = unbounded
+    bool greedy = true;
+    int capture = 0;    // Group: capture index, 0 for non-capturing
+};
+
+// Recursive-descent parser for the ECMAScript subset the automaton supports. Any construct
+// outside the subset makes Parse() fail, and the caller falls back to std::wregex.
+class Parser {
+public:
+    Parser(const std::wstring& pattern, std::vector<AstNode>& nodes, std::vector<PatternSet::CharClass>& classes)
+        : m_p(pattern), m_nodes(nodes), m_classes(classes) {}
+
+    bool Parse(int& root) {
+        root = ParseAlternation();
+        return m_ok && m_pos == m_p.size();
+    }
+
+    int GroupCount() const { return m_groups; }
+
+private:
+    bool AtEnd() const { return m_pos >= m_p.size(); }
+    wchar_t Peek() const { return m_p[m_pos]; }
+    int Fail() { m_ok = false; return NewNode(AstNode::Kind::Empty); }
+
+    int NewNode(AstNode::Kind kind) {
+        m_nodes.emplace_back();
+        m_nodes.back().kind = kind;
+        return static_cast<int>(m_nodes.size() - 1);
+    }
+
+    int NewClass(Ranges ranges, bool negate) {
+        FoldCase(ranges);
+        if (negate) ranges = NegateRanges(ranges);
+        PatternSet::CharClass cls;
+        cls.ranges = std::move(ranges);
+        m_classes.push_back(std::move(cls));
+        int node = NewNode(AstNode::Kind::Class);
+        m_nodes[node].cls = static_cast<int>(m_classes.size() - 1);
+        return node;
+    }
+
+    int ParseAlternation() {
+        int first = ParseConcat();
+        if (AtEnd() || Peek() != L'|') return first;
+        int alt = NewNode(AstNode::Kind::Alternate);
+        m_nodes[alt].kids.push_back(first);
+        while (m_ok && !AtEnd() && Peek() == L'|') {
+            ++m_pos;
+            int next = ParseConcat();
+            m_nodes[alt].kids.push_back(next);
+        }
+        return alt;
+    }
+
+    int ParseConcat() {
+        int concat = NewNode(AstNode::Kind::Concat);
+        while (m_ok && !AtEnd() && Peek() != L'|' && Peek() != L')') {
+            int atom = ParseAtom();
+            if (!m_ok) break;
+            atom = ParseQuantifier(atom);
+            m_nodes[concat].kids.push_back(atom);
+        }
+        return concat;
+    }
+
+    int ParseAtom() {
+        wchar_t c = m_p[m_pos++];
+        switch (c) {
+        case L'^': return NewNode(AstNode::Kind::Begin);
+        case L'$': return NewNode(AstNode::Kind::End);
+        case L'.': {
+            Ranges r = { { L'\n', L'\n' }, { L'\r', L'\r' }, { 0x2028, 0x2029 } };
+            NormalizeRanges(r);
+            return NewClass(r, true);
+        }
+        case L'(': {
+            int capture = 0;
+            if (m_pos + 1 < m_p.size() && m_p[m_pos] == L'?') {
+                if (m_p[m_pos + 1] != L':') return Fail(); // Lookahead is not supported
+                m_pos += 2;
+            }
+            else {
+                capture = ++m_groups;
+            }
+            int body = ParseAlternation();
+            if (AtEnd() || Peek() != L')') return Fail();
+            ++m_pos;
+            int group = NewNode(AstNode::Kind::Group);
+            m_nodes[group].kids.push_back(body);
+            m_nodes[group].capture = capture;
+            return group;
+        }
+        case L'[': return ParseClass();
+        case L'\\': return ParseEscape();
+        case L'*': case L'+': case L'?': case L'{': case L')':
+            return Fail();
+        default:
+            return NewClass({ { static_cast<uint32_t>(c), static_cast<uint32_t>(c) } }, false);
+        }
+    }
+
+    // Parses an escape outside a class. Backreferences and \b/\B are unsupported.
+    int ParseEscape() {
+        if (AtEnd()) return Fail();
+        wchar_t c = m_p[m_pos];
+        Ranges r;
+        bool negate = false;
+        if (ParseClassEscape(r, negate)) return NewClass(r, negate);
+        if (c == L'b' || c == L'B' || (c >= L'1' && c <= L'9') || c == L'c' || c == L'k') return Fail();
+        uint32_t value;
+        if (!ParseCharEscape(value)) return Fail();
+        return NewClass({ { value, value } }, false);
+    }
+
+    // \d \D \w \W \s \S
+    bool ParseClassEscape(Ranges& r, bool& negate) {
+        wchar_t c = m_p[m_pos];
+        switch (c) {
+        case L'd': AddDigit(r); break;
+        case L'D': AddDigit(r); negate = true; break;
+        case L'w': AddWord(r); break;
+        case L'W': AddWord(r); negate = true; break;
+        case L's': AddSpace(r); break;
+        case L'S': AddSpace(r); negate = true; break;
+        default: return false;
+        }
+        ++m_pos;
+        NormalizeRanges(r);
+        return true;
+    }
+
+    bool ParseHex(size_t digits, uint32_t& value) {
+        if (m_pos + digits > m_p.size()) return false;
+        value = 0;
+        for (size_t i = 0; i < digits; ++i) {
+            wchar_t h = m_p[m_pos + i];
+            value <<= 4;
+            if (h >= L'0' && h <= L'9') value |= h - L'0';
+            else if (h >= L'a' && h <= L'f') value |= h - L'a' + 10;
+            else if (h >= L'A' && h <= L'F') value |= h - L'A' + 10;
+            else return false;
+        }
+        m_pos += digits;
+        return true;
+    }
+
+    // Single-character escapes shared by atoms and classes.
+    bool ParseCharEscape(uint32_t& value) {
+        wchar_t c = m_p[m_pos++];
+        switch (c) {
+        case L't': value = L'\t'; return true;
+        case L'n': value = L'\n'; return true;
+        case L'r': value = L'\r'; return true;
+        case L'f': value = L'\f'; return true;
+        case L'v': value = L'\v'; return true;
+        case L'0':
+            if (!AtEnd() && Peek() >= L'0' && Peek() <= L'9') return false;
+            value = 0;
+            return true;
+        case L'x': return ParseHex(2, value);
+        case L'u': return ParseHex(4, value);
+        default:
+            if (std::iswalnum(static_cast<wint_t>(c))) return false; // Unknown letter escape
+            value = static_cast<uint32_t>(c);
+            return true;
+        }
+    }
+
+    int ParseClass() {
+        bool negate = false;
+        if (!AtEnd() && Peek() == L'^') { negate = true; ++m_pos; }
+        Ranges r;
+        while (true) {
+            if (AtEnd()) return Fail();
+            if (Peek() == L']') { ++m_pos; break; }
+
+            uint32_t low;
+            if (!ParseClassAtom(r, low)) {
+                if (!m_ok) return Fail();
+                continue; // Was a class escape such as \d
+            }
+            if (m_pos + 1 < m_p.size() && Peek() == L'-' && m_p[m_pos + 1] != L']') {
+                ++m_pos;
+                uint32_t high;
+                if (!ParseClassAtom(r, high) || high < low) return Fail();
+                r.push_back({ low, high });
+            }
+            else {
+                r.push_back({ low, low });
+            }
+        }
+        NormalizeRanges(r);
+        return NewClass(r, negate);
+    }
+
+    // Returns true with a single code point, or false after appending a class escape to r.
+    bool ParseClassAtom(Ranges& r, uint32_t& value) {
+        wchar_t c = m_p[m_pos];
+        if (c != L'\\') {
+            ++m_pos;
+            value = static_cast<uint32_t>(c);
+            return true;
+        }
+        ++m_pos;
+        if (AtEnd()) { m_ok = false; return false; }
+        bool negate = false;
+        Ranges escaped;
+        if (ParseClassEscape(escaped, negate)) {
+            if (negate) escaped = NegateRanges(escaped);
+            r.insert(r.end(), escaped.begin(), escaped.end());
+            return false;
+        }
+        if (Peek() == L'b') { ++m_pos; value = 0x08; return true; } // [\b] is backspace
+        if (!ParseCharEscape(value)) { m_ok = false; return false; }
+        return true;
+    }
+
+    bool ParseNumber(int& value) {
+        size_t start = m_pos;
+        value = 0;
+        while (!AtEnd() && Peek() >= L'0' && Peek() <= L'9') {
+            value = value * 10 + (Peek() - L'0');
+            if (value > 1000) return false;
+            ++m_pos;
+        }
+        return m_pos > start;
+    }
+
+    int ParseQuantifier(int atom) {
+        if (AtEnd()) return atom;
+        int min, max;
+        switch (Peek()) {
+        case L'*': min = 0; max = -1; ++m_pos; break;
+        case L'+': min = 1; max = -1; ++m_pos; break;
+        case L'?': min = 0; max = 1; ++m_pos; break;
+        case L'{': {
+            ++m_pos;
+            if (!ParseNumber(min)) return Fail();
+            max = min;
+            if (!AtEnd() && Peek() == L',') {
+                ++m_pos;
+                max = -1;
+                if (!AtEnd() && Peek() != L'}' && !ParseNumber(max)) return Fail();
+            }
+            if (AtEnd() || Peek() != L'}' || (max != -1 && max < min)) return Fail();
+            ++m_pos;
+            break;
+        }
+        default:
+            return atom;
+        }
+        AstNode::Kind kind = m_nodes[atom].kind;
+        if (kind == AstNode::Kind::Begin || kind == AstNode::Kind::End) return Fail();
+
+        int repeat = NewNode(AstNode::Kind::Repeat);
+        m_nodes[repeat].kids.push_back(atom);
+        m_nodes[repeat].min = min;
+        m_nodes[repeat].max = max;
+        if (!AtEnd() && Peek() == L'?') {
+            m_nodes[repeat].greedy = false;
+            ++m_pos;
+        }
+        return repeat;
+    }
+
+    const std::wstring& m_p;
+    size_t m_pos = 0;
+    bool m_ok = true;
+    int m_groups = 0;
+    std::vector<AstNode>& m_nodes;
+    std::vector<PatternSet::CharClass>& m_classes;
+};
+
+//------------------------------------------------------------------------------------------------//
+//                                   NFA CONSTRUCTION                                             //
+//------------------------------------------------------------------------------------------------//
+size_t MinWidth(const std::vector<AstNode>& nodes, int index);
+
+// Thompson construction. Holes are (instruction, use out1) pairs waiting to be patched.
+class Emitter {
+public:
+    Emitter(std::vector<PatternSet::Inst>& program, const std::vector<AstNode>& nodes, size_t budget)
+        : m_program(program), m_nodes(nodes), m_limit(program.size() + budget) {}
+
+    struct Frag {
+        uint32_t start;
+        std::vector<std::pair<uint32_t, bool>> holes;
+    };
+
+    bool Ok() const { return m_ok; }
+
+    uint32_t Add(PatternSet::Op op, uint32_t arg = 0) {
+        if (m_program.size() >= m_limit) m_ok = false;
+        m_program.push_back({ op, 0, 0, arg });
+        return static_cast<uint32_t>(m_program.size() - 1);
+    }
+
+    void Patch(const Frag& frag, uint32_t target) {
+        for (const auto& hole : frag.holes) {
+            if (hole.second) m_program[hole.first].out1 = target;
+            else m_program[hole.first].out = target;
+        }
+    }
+
+    Frag Single(PatternSet::Op op, uint32_t arg = 0) {
+        uint32_t inst = Add(op, arg);
+        return { inst, { { inst, false } } };
+    }
+
+    Frag Emit(int index) {
+        if (!m_ok) return Single(PatternSet::Op::Epsilon);
+        const AstNode& node = m_nodes[index];
+        switch (node.kind) {
+        case AstNode::Kind::Empty: return Single(PatternSet::Op::Epsilon);
+        case AstNode::Kind::Class: return Single(PatternSet::Op::Char, static_cast<uint32_t>(node.cls));
+        case AstNode::Kind::Begin: return Single(PatternSet::Op::AssertBegin);
+        case AstNode::Kind::End: return Single(PatternSet::Op::AssertEnd);
+        case AstNode::Kind::Concat: return EmitConcat(node.kids);
+        case AstNode::Kind::Alternate: {
+            Frag result = Emit(node.kids.back());
+            for (size_t i = node.kids.size() - 1; i-- > 0;) {
+                Frag left = Emit(node.kids[i]);
+                uint32_t split = Add(PatternSet::Op::Split);
+                m_program[split].out = left.start;
+                m_program[split].out1 = result.start;
+                left.holes.insert(left.holes.end(), result.holes.begin(), result.holes.end());
+                result = { split, std::move(left.holes) };
+            }
+            return result;
+        }
+        case AstNode::Kind::Group: {
+            if (node.capture != 1) return Emit(node.kids[0]);
+            Frag open = Single(PatternSet::Op::Save, 0);
+            Frag body = Emit(node.kids[0]);
+            Frag close = Single(PatternSet::Op::Save, 1);
+            Patch(open, body.start);
+            Patch(body, close.start);
+            return { open.start, close.holes };
+        }
+        case AstNode::Kind::Repeat: return EmitRepeat(node);
+        }
+        return Single(PatternSet::Op::Epsilon);
+    }
+
+private:
+    Frag EmitConcat(const std::vector<int>& kids) {
+        if (kids.empty()) return Single(PatternSet::Op::Epsilon);
+        Frag result = Emit(kids[0]);
+        for (size_t i = 1; i < kids.size(); ++i) {
+            Frag next = Emit(kids[i]);
+            Patch(result, next.start);
+            result.holes = std::move(next.holes);
+        }
+        return result;
+    }
+
+    // Split whose preferred branch depends on greediness; returns the split instruction.
+    uint32_t AddChoice(bool greedy, uint32_t body, std::vector<std::pair<uint32_t, bool>>& holes) {
+        uint32_t split = Add(PatternSet::Op::Split);
+        if (greedy) { m_program[split].out = body; holes.push_back({ split, true }); }
+        else { m_program[split].out1 = body; holes.push_back({ split, false }); }
+        return split;
+    }
+
+    // An optional iteration of body. When body can match empty it is bracketed by IterBegin and
+    // IterEnd, so the Pike VM can drop iterations that consume nothing as ECMAScript does.
+    Frag EmitIteration(int body) {
+        if (MinWidth(m_nodes, body) > 0) return Emit(body);
+        Frag begin = Single(PatternSet::Op::IterBegin);
+        Frag copy = Emit(body);
+        Frag end = Single(PatternSet::Op::IterEnd);
+        Patch(begin, copy.start);
+        Patch(copy, end.start);
+        return { begin.start, end.holes };
+    }
+
+    Frag EmitRepeat(const AstNode& node) {
+        int body = node.kids[0];
+        Frag result = Single(PatternSet::Op::Epsilon);
+        std::vector<std::pair<uint32_t, bool>>& tail = result.holes;
+
+        // Mandatory copies
+        for (int i = 0; i < node.min && m_ok; ++i) {
+            Frag copy = Emit(body);
+            Patch({ 0, tail }, copy.start);
+            tail = std::move(copy.holes);
+        }
+
+        if (node.max == -1) {
+            // Loop: split -> body -> split
+            Frag copy = EmitIteration(body);
+            std::vector<std::pair<uint32_t, bool>> exits;
+            uint32_t split = AddChoice(node.greedy, copy.start, exits);
+            Patch(copy, split);
+            Patch({ 0, tail }, split);
+            tail = std::move(exits);
+        }
+        else {
+            // Optional copies: each may be skipped
+            std::vector<std::pair<uint32_t, bool>> exits;
+            for (int i = node.min; i < node.max && m_ok; ++i) {
+                Frag copy = EmitIteration(body);
+                uint32_t split = AddChoice(node.greedy, copy.start, exits);
+                Patch({ 0, tail }, split);
+                tail = std::move(copy.holes);
+            }
+            tail.insert(tail.end(), exits.begin(), exits.end());
+        }
+        return result;
+    }
+
+    std::vector<PatternSet::Inst>& m_program;
+    const std::vector<AstNode>& m_nodes;
+    size_t m_limit;
+    bool m_ok = true;
+};
+
+//------------------------------------------------------------------------------------------------//
+//                                   LITERAL PREFILTER                                            //
+//------------------------------------------------------------------------------------------------//
+// Shortest line the node can match, saturating so huge counted repeats cannot overflow.
+size_t MinWidth(const std::vector<AstNode>& nodes, int index) {
+    const AstNode& node = nodes[index];
+    const size_t cap = static_cast<size_t>(1) << 20;
+    switch (node.kind) {
+    case AstNode::Kind::Class: return 1;
+    case AstNode::Kind::Group: return MinWidth(nodes, node.kids[0]);
+    case AstNode::Kind::Repeat: return std::min(cap, MinWidth(nodes, node.kids[0]) * node.min);
+    case AstNode::Kind::Concat: {
+        size_t total = 0;
+        for (int kid : node.kids) total = std::min(cap, total + MinWidth(nodes, kid));
+        return total;
+    }
+    case AstNode::Kind::Alternate: {
+        size_t best = cap;
+        for (int kid : node.kids) best = std::min(best, MinWidth(nodes, kid));
+        return best;
+    }
+    default: return 0;
+    }
+}
+
+// One position of the mandatory skeleton, or a gap of unknown content and length.
+struct SkeletonItem {
+    bool gap;
+    PatternSet::Position position;
+};
+
+// Literal when the class holds one character, or one character in both cases.
+PatternSet::Position MakePosition(const std::vector<PatternSet::CharClass>& classes, int cls) {
+    const auto& r = classes[cls].ranges;
+    bool literal = !r.empty() && r.size() <= 2 && r[0].first == r[0].second &&
+                   (r.size() == 1 || r[1].first == r[1].second);
+    if (!literal) return { 0, 0, cls };
+    return { static_cast<wchar_t>(r[0].first), static_cast<wchar_t>(r.back().first), -1 };
+}
+
+void PushGap(std::vector<SkeletonItem>& items) {
+    if (items.empty() || !items.back().gap) items.push_back({ true, { 0, 0, -1 } });
+}
+
+// Flattens the positions every match must contain, in order; anything variable becomes a gap.
+// A variable repeat of a single character matches the same strings as x{0,max-min} x{min}, so
+// with towardEnd set its mandatory copies go after the gap, which exposes them as a suffix.
+void BuildSkeleton(const std::vector<AstNode>& nodes, const std::vector<PatternSet::CharClass>& classes,
+                   int index, bool towardEnd, std::vector<SkeletonItem>& items) {
+    const AstNode& node = nodes[index];
+    switch (node.kind) {
+    case AstNode::Kind::Class:
+        items.push_back({ false, MakePosition(classes, node.cls) });
+        break;
+    case AstNode::Kind::Group:
+        BuildSkeleton(nodes, classes, node.kids[0], towardEnd, items);
+        break;
+    case AstNode::Kind::Concat:
+        for (int kid : node.kids) BuildSkeleton(nodes, classes, kid, towardEnd, items);
+        break;
+    case AstNode::Kind::Repeat: {
+        const int copies = std::min(node.min, 64);
+        const bool variable = node.max != node.min || node.min > copies;
+        const bool gapFirst = towardEnd && nodes[node.kids[0]].kind == AstNode::Kind::Class;
+        if (variable && gapFirst) PushGap(items);
+        for (int i = 0; i < copies; ++i) BuildSkeleton(nodes, classes, node.kids[0], towardEnd, items);
+        if (variable && !gapFirst) PushGap(items);
+        break;
+    }
+    case AstNode::Kind::Alternate:
+        PushGap(items);
+        break;
+    default:
+        break; // Zero-width
+    }
+}
+
+PatternSet::Prefilter BuildPrefilter(const std::vector<AstNode>& nodes,
+                                     const std::vector<PatternSet::CharClass>& classes, int root) {
+    PatternSet::Prefilter filter;
+    filter.minLength = MinWidth(nodes, root);
+
+    std::vector<SkeletonItem> items;
+    BuildSkeleton(nodes, classes, root, false, items);
+    size_t head = 0;
+    while (head < items.size() && !items[head].gap) filter.prefix.push_back(items[head++].position);
+    if (head == items.size()) return filter; // Fixed-width: the prefix says it all
+
+    // Prefer a caseless character so a single wmemchr can look for it.
+    for (size_t i = head; i < items.size(); ++i) {
+        const PatternSet::Position& p = items[i].position;
+        if (!items[i].gap && p.cls < 0 && p.upper == p.lower) {
+            filter.hasRequired = true;
+            filter.required = p.upper;
+            break;
+        }
+    }
+
+    items.clear();
+    BuildSkeleton(nodes, classes, root, true, items);
+    size_t tail = items.size();
+    while (tail > 0 && !items[tail - 1].gap) --tail;
+    for (size_t i = tail; i < items.size(); ++i) filter.suffix.push_back(items[i].position);
+    return filter;
+}
+
+} // namespace
+
+
+bool PatternSet::CharClass::Contains(uint32_t c) const {
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), std::make_pair(c, UINT32_MAX));
+    return it != ranges.begin() && (it - 1)->second >= c;
+}
+
+bool PatternSet::Admits(const Prefilter& filter, std::wstring_view line) const {
+    auto matches = [this](const Position& p, wchar_t c) {
+        if (p.cls < 0) return c == p.upper || c == p.lower;
+        return m_classes[p.cls].Contains(static_cast<uint32_t>(c));
+    };
+    if (line.size() < filter.minLength) return false;
+    for (size_t i = 0; i < filter.prefix.size(); ++i) {
+        if (!matches(filter.prefix[i], line[i])) return false;
+    }
+    const size_t suffixStart = line.size() - filter.suffix.size();
+    for (size_t i = 0; i < filter.suffix.size(); ++i) {
+        if (!matches(filter.suffix[i], line[suffixStart + i])) return false;
+    }
+    if (filter.hasRequired) {
+        const size_t begin = filter.prefix.size();
+        if (!std::wmemchr(line.data() + begin, filter.required, line.size() - begin)) return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      COMPILATION                                               //
+//------------------------------------------------------------------------------------------------//
+PatternSet PatternSet::Compile(const std::vector<std::wstring>& patterns) {
+    PatternSet set;
+
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        std::vector<AstNode> nodes;
+        size_t programMark = set.m_program.size();
+        size_t classMark = set.m_classes.size();
+
+        Parser parser(patterns[i], nodes, set.m_classes);
+        int root = 0;
+        bool parsed = parser.Parse(root);
+        if (parsed && parser.GroupCount() == 0) {
+            // Matches can never yield a filename (no capture group), exactly like before.
+            set.m_classes.resize(classMark);
+            continue;
+        }
+
+        if (parsed) {
+            Emitter emitter(set.m_program, nodes, kMaxProgramSize);
+            Emitter::Frag frag = emitter.Emit(root);
+            uint32_t match = emitter.Add(Op::Match, static_cast<uint32_t>(i));
+            emitter.Patch(frag, match);
+            if (emitter.Ok()) {
+                set.m_patternStarts.push_back(frag.start);
+                set.m_patternIndex.push_back(static_cast<int>(i));
+                set.m_prefilters.push_back(BuildPrefilter(nodes, set.m_classes, root));
+                continue;
+            }
+            set.m_program.resize(programMark);
+        }
+        set.m_classes.resize(classMark);
+
+        // Outside the supported subset (or too large): keep std::wregex for this one pattern.
+        try {
+            std::wregex regex(patterns[i], std::regex::ECMAScript | std::regex::icase);
+            if (regex.mark_count() > 0) {
+                set.m_fallbacks.push_back({ static_cast<int>(i), std::move(regex) });
+            }
+        }
+        catch (const std::regex_error&) {
+            // Skip invalid regex patterns
+        }
+    }
+    set.m_automatonCount = set.m_patternStarts.size();
+    if (set.m_automatonCount == 0) return set;
+
+    // Priority-ordered entry over all patterns, used when the DFA is unavailable.
+    uint32_t entry = set.m_patternStarts.back();
+    for (size_t k = set.m_automatonCount - 1; k-- > 0;) {
+        set.m_program.push_back({ Op::Split, set.m_patternStarts[k], entry, 0 });
+        entry = static_cast<uint32_t>(set.m_program.size() - 1);
+    }
+    set.m_combinedStart = entry;
+
+    // Alphabet compression over every class boundary.
+    std::vector<uint32_t> starts = { 0 };
+    for (const auto& cls : set.m_classes) {
+        for (const auto& r : cls.ranges) {
+            starts.push_back(r.first);
+            if (r.second < kMaxCodeUnit) starts.push_back(r.second + 1);
+        }
+    }
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+    set.m_alphabetStarts = std::move(starts);
+    set.m_alphabetSize = static_cast<uint32_t>(set.m_alphabetStarts.size());
+    for (uint32_t c = 0; c < 128; ++c) {
+        auto it = std::upper_bound(set.m_alphabetStarts.begin(), set.m_alphabetStarts.end(), c);
+        set.m_asciiAlphabet[c] = static_cast<uint32_t>(it - set.m_alphabetStarts.begin() - 1);
+    }
+
+    set.BuildDfa();
+    return set;
+}
+
+uint32_t PatternSet::ClassOf(uint32_t c) const {
+    if (c < 128) return m_asciiAlphabet[c];
+    auto it = std::upper_bound(m_alphabetStarts.begin(), m_alphabetStarts.end(), c);
+    return static_cast<uint32_t>(it - m_alphabetStarts.begin() - 1);
+}
+
+// Subset construction over the combined NFA. Each DFA state is the set of Char, AssertEnd and
+// Match instructions reachable through epsilon moves.
+void PatternSet::BuildDfa() {
+    using StateSet = std::vector<uint32_t>;
+    std::vector<uint32_t> stack;
+    std::vector<uint32_t> seen(m_program.size(), 0);
+    uint32_t stamp = 0;
+
+    auto closure = [&](const std::vector<uint32_t>& seeds, bool atStart, bool atEnd) {
+        StateSet set;
+        ++stamp;
+        stack.assign(seeds.rbegin(), seeds.rend());
+        while (!stack.empty()) {
+            uint32_t pc = stack.back();
+            stack.pop_back();
+            if (seen[pc] == stamp) continue;
+            seen[pc] = stamp;
+            const Inst& inst = m_program[pc];
+            switch (inst.op) {
+            case Op::Split: stack.push_back(inst.out1); stack.push_back(inst.out); break;
+            case Op::Epsilon: case Op::Save: case Op::IterBegin: case Op::IterEnd:
+                stack.push_back(inst.out);
+                break;
+            case Op::AssertBegin: if (atStart) stack.push_back(inst.out); break;
+            case Op::AssertEnd:
+                if (atEnd) stack.push_back(inst.out);
+                else set.push_back(pc);
+                break;
+            case Op::Char: case Op::Match: set.push_back(pc); break;
+            }
+        }
+        std::sort(set.begin(), set.end());
+        return set;
+    };
+
+    auto acceptAtEnd = [&](const StateSet& set) {
+        std::vector<uint32_t> seeds;
+        for (uint32_t pc : set) {
+            if (m_program[pc].op == Op::Match) seeds.push_back(pc);
+            else if (m_program[pc].op == Op::AssertEnd) seeds.push_back(m_program[pc].out);
+        }
+        int best = -1;
+        for (uint32_t pc : closure(seeds, false, true)) {
+            if (m_program[pc].op == Op::Match) {
+                int pattern = static_cast<int>(m_program[pc].arg);
+                if (best == -1 || pattern < best) best = pattern;
+            }
+        }
+        return best;
+    };
+
+    std::map<StateSet, uint32_t> ids;
+    std::vector<StateSet> states;
+    std::queue<uint32_t> pending;
+
+    auto intern = [&](StateSet&& set) -> uint32_t {
+        auto found = ids.find(set);
+        if (found != ids.end()) return found->second;
+        uint32_t id = static_cast<uint32_t>(states.size());
+        ids.emplace(set, id);
+        m_dfaAccept.push_back(acceptAtEnd(set));
+        states.push_back(std::move(set));
+        m_dfaNext.resize(states.size() * m_alphabetSize, 0);
+        pending.push(id);
+        return id;
+    };
+
+    intern(StateSet());                          // 0: dead state
+    m_dfaStart = intern(closure(m_patternStarts, true, false));
+    // The start set also sees ^ satisfied; for an empty line, accept must honour that too.
+    {
+        std::vector<uint32_t> seeds(m_patternStarts);
+        int best = -1;
+        for (uint32_t pc : closure(seeds, true, true)) {
+            if (m_program[pc].op == Op::Match) {
+                int pattern = static_cast<int>(m_program[pc].arg);
+                if (best == -1 || pattern < best) best = pattern;
+            }
+        }
+        m_dfaAccept[m_dfaStart] = best;
+    }
+
+    std::vector<uint32_t> seeds;
+    while (!pending.empty()) {
+        uint32_t id = pending.front();
+        pending.pop();
+        if (id == 0) continue;
+        for (uint32_t symbol = 0; symbol < m_alphabetSize; ++symbol) {
+            uint32_t representative = m_alphabetStarts[symbol];
+            seeds.clear();
+            for (uint32_t pc : states[id]) {
+                const Inst& inst = m_program[pc];
+                if (inst.op == Op::Char && m_classes[inst.arg].Contains(representative)) {
+                    seeds.push_back(inst.out);
+                }
+            }
+            uint32_t next = seeds.empty() ? 0 : intern(closure(seeds, false, false));
+            if (states.size() > kMaxDfaStates) {
+                m_hasDfa = false;
+                m_dfaNext.clear();
+                m_dfaAccept.clear();
+                return;
+            }
+            m_dfaNext[id * m_alphabetSize + symbol] = next;
+        }
+    }
+    m_hasDfa = true;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                        MATCHING                                                //
+//------------------------------------------------------------------------------------------------//
+bool PatternSet::RunDfa(std::wstring_view line, int& pattern) const {
+    uint32_t state = m_dfaStart;
+    const uint32_t* next = m_dfaNext.data();
+    for (wchar_t c : line) {
+        state = next[state * m_alphabetSize + ClassOf(static_cast<uint32_t>(c))];
+        if (state == 0) return false;
+    }
+    // On an empty line the start state is still current and its accept already accounts for ^.
+    pattern = m_dfaAccept[state];
+    return pattern >= 0;
+}
+
+// Pike VM: simulates all threads in lock step, highest priority first, so the first thread to
+// reach Match at the end of the line carries the same captures a backtracking matcher would.
+// A thread inside an iteration it entered at this position is a different state from one that
+// entered it earlier (only the latter may pass IterEnd), so epsilon instructions are marked per
+// (pc, fresh); Char and Match are marked by pc alone since consuming makes every thread stale.
+bool PatternSet::RunPikeVm(std::wstring_view line, uint32_t start, PatternMatch& match) const {
+    struct Thread {
+        uint32_t pc;
+        bool fresh;     // Entered an iteration without consuming since
+        size_t cap[2];
+    };
+    const size_t length = line.size();
+    std::vector<Thread> current, next, stack;
+    std::vector<size_t> mark(m_program.size() * 2, static_cast<size_t>(-1));
+    size_t generation = 0;
+
+    auto addThread = [&](std::vector<Thread>& list, Thread seed, size_t pos) {
+        stack.clear();
+        stack.push_back(seed);
+        while (!stack.empty()) {
+            Thread t = stack.back();
+            stack.pop_back();
+            const Inst& inst = m_program[t.pc];
+            bool leaf = inst.op == Op::Char || inst.op == Op::Match;
+            size_t key = size_t(t.pc) * 2 + (leaf ? 0 : t.fresh);
+            if (mark[key] == generation) continue;
+            mark[key] = generation;
+            Thread follow = t;
+            follow.pc = inst.out;
+            switch (inst.op) {
+            case Op::Split:
+                stack.push_back({ inst.out1, t.fresh, { t.cap[0], t.cap[1] } });
+                stack.push_back(follow);
+                break;
+            case Op::Epsilon:
+                stack.push_back(follow);
+                break;
+            case Op::Save:
+                follow.cap[inst.arg] = pos;
+                stack.push_back(follow);
+                break;
+            case Op::IterBegin:
+                follow.fresh = true;
+                stack.push_back(follow);
+                break;
+            case Op::IterEnd:
+                if (!t.fresh) stack.push_back(follow);
+                break;
+            case Op::AssertBegin:
+                if (pos == 0) stack.push_back(follow);
+                break;
+            case Op::AssertEnd:
+                if (pos == length) stack.push_back(follow);
+                break;
+            case Op::Char: case Op::Match:
+                list.push_back(t);
+                break;
+            }
+        }
+    };
+
+    addThread(current, { start, false, { kNoCapture, kNoCapture } }, 0);
+    for (size_t pos = 0; ; ++pos) {
+        if (current.empty()) return false;
+        ++generation;
+        next.clear();
+        for (const Thread& t : current) {
+            const Inst& inst = m_program[t.pc];
+            if (inst.op == Op::Match) {
+                if (pos != length) continue;
+                match.pattern = static_cast<int>(inst.arg);
+                bool captured = t.cap[0] != kNoCapture && t.cap[1] != kNoCapture;
+                match.captureBegin = captured ? t.cap[0] : 0;
+                match.captureEnd = captured ? t.cap[1] : 0;
+                return true;
+            }
+            if (pos < length && m_classes[inst.arg].Contains(static_cast<uint32_t>(line[pos]))) {
+                addThread(next, { inst.out, false, { t.cap[0], t.cap[1] } }, pos + 1);
+            }
+        }
+        if (pos == length) return false;
+        current.swap(next);
+    }
+}
+
+bool PatternSet::Match(std::wstring_view line, PatternMatch& match) const {
+    int winner = -1;
+    bool haveMatch = false;
+
+    bool admitted = false;
+    for (const auto& filter : m_prefilters) {
+        if (Admits(filter, line)) { admitted = true; break; }
+    }
+    if (!admitted && m_fallbacks.empty()) return false;
+
+    if (admitted) {
+        if (m_hasDfa) {
+            RunDfa(line, winner);
+        }
+        else if (RunPikeVm(line, m_combinedStart, match)) {
+            winner = match.pattern;
+            haveMatch = true;
+        }
+    }
+
+    // Fallback patterns configured before the automaton's winner still take priority.
+    for (const auto& fallback : m_fallbacks) {
+        if (winner != -1 && fallback.pattern > winner) break;
+        try {
+            std::match_results<std::wstring_view::const_iterator> result;
+            if (std::regex_match(line.begin(), line.end(), result, fallback.regex) && result.size() > 1) {
+                match.pattern = fallback.pattern;
+                match.captureBegin = result[1].matched ? static_cast<size_t>(result[1].first - line.begin()) : 0;
+                match.captureEnd = result[1].matched ? static_cast<size_t>(result[1].second - line.begin()) : 0;
+                return true;
+            }
+        }
+        catch (const std::regex_error&) {
+            continue; // Silently ignore runtime regex errors.
+        }
+    }
+
+    if (winner == -1) return false;
+    if (haveMatch) return true;
+
+    for (size_t k = 0; k < m_automatonCount; ++k) {
+        if (m_patternIndex[k] == winner) return RunPikeVm(line, m_patternStarts[k], match);
+    }
+    return false;
+}
+
+bool PatternSet::Matches(std::wstring_view line) const {
+    bool admitted = false;
+    for (const auto& filter : m_prefilters) {
+        if (Admits(filter, line)) { admitted = true; break; }
+    }
+
+    if (admitted) {
+        int winner = -1;
+        PatternMatch match;
+        if (m_hasDfa ? RunDfa(line, winner) : RunPikeVm(line, m_combinedStart, match)) return true;
+    }
+
+    for (const auto& fallback : m_fallbacks) {
+        try {
+            std::match_results<std::wstring_view::const_iterator> result;
+            if (std::regex_match(line.begin(), line.end(), result, fallback.regex) && result.size() > 1) return true;
+        }
+        catch (const std::regex_error&) {
+            continue; // Silently ignore runtime regex errors.
+        }
+    }
+    return false;
+}
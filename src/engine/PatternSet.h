@@ -0,0 +1,118 @@
+//================================================================================================//
+//                               Clipboard To File - Pattern set                                  //
+//                                                                                                //
+//  All contentCreationRegexes compiled into one automaton. A DFA built at settings-load time     //
+//  decides in a single pass over the first line which pattern (if any) fully matches; a Pike VM  //
+//  then recovers the span of capture group 1 for that pattern only. Both run in time linear in   //
+//  the line length, so user-authored patterns can no longer backtrack exponentially.             //
+//                                                                                                //
+//  Matching follows std::regex_match(ECMAScript | icase) semantics: earlier patterns win, and    //
+//  patterns without a capture group are ignored. Syntax outside the supported subset            //
+//  (backreferences, lookahead, \b) falls back to std::wregex for that pattern only.              //
+//                                                                                                //
+//  Where libstdc++'s std::wregex departs from the ECMAScript specification, results follow the   //
+//  specification (and browsers) instead:                                                         //
+//   - A quantified group that can match empty: an iteration that consumes nothing fails, so      //
+//     ^(\w*)*\.txt$ on "ab.txt" captures "ab" (libstdc++: ""), and (?:a*?)?(a*) on "aa"          //
+//     captures [1, 2) (libstdc++: [0, 2)).                                                       //
+//   - \s is ECMAScript white space, which includes U+00A0, U+FEFF, U+2028 and U+2029.            //
+//  Captures inside a repeated group are not reset between iterations, as in libstdc++.           //
+//  tests/PatternSetTest.cpp checks everything else against std::wregex.                          //
+//                                                                                                //
+//  Each pattern also gets a literal prefilter (required prefix, suffix, minimum length and one   //
+//  caseless character the line must contain). Almost every copied line is not a filename, so    //
+//  the common case is rejected by a few compares and a wmemchr before the automaton runs.        //
+//================================================================================================//
+#pragma once
+
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+struct PatternMatch {
+    int pattern = -1;           // Index into the configured pattern list
+    size_t captureBegin = 0;    // Span of capture group 1 within the matched line
+    size_t captureEnd = 0;
+};
+
+class PatternSet {
+public:
+    // Compiles the patterns in priority order. Invalid patterns are skipped.
+    static PatternSet Compile(const std::vector<std::wstring>& patterns);
+
+    // Full-line match against every pattern; returns the first (lowest index) match.
+    bool Match(std::wstring_view line, PatternMatch& match) const;
+
+    // Whether any pattern matches, without locating the capture (no Pike VM pass when the DFA
+    // is available).
+    bool Matches(std::wstring_view line) const;
+
+    // Number of patterns that can produce a filename (valid and with a capture group).
+    size_t ActiveCount() const { return m_automatonCount + m_fallbacks.size(); }
+    size_t FallbackCount() const { return m_fallbacks.size(); }
+    size_t DfaStateCount() const { return m_hasDfa ? m_dfaAccept.size() : 0; }
+
+    // NFA instructions and character classes; public so the compiler helpers can build them.
+    // IterBegin and IterEnd bracket an optional iteration that could match empty; IterEnd fails
+    // when nothing was consumed since the matching IterBegin.
+    enum class Op : uint8_t { Char, Split, Epsilon, Save, AssertBegin, AssertEnd, IterBegin, IterEnd, Match };
+    struct Inst {
+        Op op;
+        uint32_t out;
+        uint32_t out1;      // Split: lower-priority branch
+        uint32_t arg;       // Char: class index, Save: slot, Match: pattern index
+    };
+    struct CharClass {
+        std::vector<std::pair<uint32_t, uint32_t>> ranges; // Sorted, merged, inclusive
+        bool Contains(uint32_t c) const;
+    };
+
+    // Literal requirements derived from a pattern; a line failing any of them cannot match.
+    struct Position {
+        wchar_t upper;      // Both case forms of a literal; equal when it has no case
+        wchar_t lower;
+        int cls;            // Character class to test instead, or -1 for a literal
+    };
+    struct Prefilter {
+        size_t minLength = 0;
+        std::vector<Position> prefix;
+        std::vector<Position> suffix;
+        bool hasRequired = false;
+        wchar_t required = 0;   // Caseless character that must occur after the prefix
+    };
+
+private:
+    struct Fallback {
+        int pattern;
+        std::wregex regex;
+    };
+
+    bool Admits(const Prefilter& filter, std::wstring_view line) const;
+    bool RunDfa(std::wstring_view line, int& pattern) const;
+    bool RunPikeVm(std::wstring_view line, uint32_t start, PatternMatch& match) const;
+    uint32_t ClassOf(uint32_t c) const;
+    void BuildDfa();
+
+    std::vector<Inst> m_program;
+    std::vector<CharClass> m_classes;
+    uint32_t m_combinedStart = 0;               // Priority-ordered split over all pattern entries
+    std::vector<uint32_t> m_patternStarts;      // Program entry per automaton pattern
+    std::vector<int> m_patternIndex;            // Configured index per automaton pattern
+    std::vector<Prefilter> m_prefilters;        // Per automaton pattern
+    size_t m_automatonCount = 0;
+    std::vector<Fallback> m_fallbacks;
+
+    // Alphabet compression: code points with identical behaviour in every class share an id.
+    std::vector<uint32_t> m_alphabetStarts;
+    uint32_t m_asciiAlphabet[128] = {};
+    uint32_t m_alphabetSize = 0;
+
+    // DFA over the compressed alphabet; state 0 is the dead state.
+    bool m_hasDfa = false;
+    uint32_t m_dfaStart = 0;
+    std::vector<uint32_t> m_dfaNext;            // [state * m_alphabetSize + symbol]
+    std::vector<int> m_dfaAccept;               // Lowest configured pattern accepting at end, or -1
+};
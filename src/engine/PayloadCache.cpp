@@ -0,0 +1,94 @@
+//================================================================================================//
+//                             Clipboard To File - Payload cache                                  //
+//================================================================================================//
+#include <algorithm>
+#include <cstring>
+#include "PayloadCache.h"
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      FINGERPRINT                                               //
+//------------------------------------------------------------------------------------------------//
+namespace {
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+
+inline uint64_t Rotate(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+inline uint64_t Load64(const unsigned char* bytes) {
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+inline uint64_t Round(uint64_t lane, uint64_t input) {
+    return Rotate(lane + input * kPrime2, 31) * kPrime1;
+}
+
+} // namespace
+
+// Four independent lanes over 32-byte stripes keep the multiplier busy on large payloads, then
+// the lanes, the tail and the length are folded together and avalanched.
+uint64_t FingerprintPayload(std::wstring_view text) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size() * sizeof(wchar_t);
+    size_t pos = 0;
+
+    uint64_t lanes[4] = { kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1 };
+    for (; pos + 32 <= size; pos += 32) {
+        for (int i = 0; i < 4; ++i) lanes[i] = Round(lanes[i], Load64(bytes + pos + i * 8));
+    }
+
+    uint64_t hash = Rotate(lanes[0], 1) + Rotate(lanes[1], 7) + Rotate(lanes[2], 12) + Rotate(lanes[3], 18);
+    hash ^= static_cast<uint64_t>(size) * kPrime3;
+    for (; pos + 8 <= size; pos += 8) hash = Rotate(hash ^ Round(0, Load64(bytes + pos)), 27) * kPrime1 + kPrime3;
+    for (; pos < size; ++pos) hash = Rotate(hash ^ (bytes[pos] * kPrime3), 11) * kPrime1;
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      RECENT PAYLOADS                                           //
+//------------------------------------------------------------------------------------------------//
+PayloadCache::PayloadCache(size_t capacity, uint64_t repeatWindowMs)
+    : m_capacity(std::max<size_t>(capacity, 1)), m_repeatWindowMs(repeatWindowMs) {
+    m_entries.reserve(m_capacity);
+}
+
+bool PayloadCache::IsDuplicate(uint64_t fingerprint, const std::shared_ptr<const EngineSettings>& settings, uint64_t nowMs) {
+    if (settings != m_settings) {
+        m_entries.clear();
+        m_settings = settings;
+        return false;
+    }
+
+    auto it = std::find_if(m_entries.begin(), m_entries.end(),
+        [fingerprint](const Entry& entry) { return entry.fingerprint == fingerprint; });
+    if (it == m_entries.end()) return false;
+
+    Entry entry = *it;
+    bool duplicate = entry.verdict == PayloadVerdict::NotAFile || nowMs - entry.seenMs <= m_repeatWindowMs;
+    if (!duplicate) return false;   // A deliberate copy of the same text; Remember refreshes it
+
+    // Move to the front; a payload that keeps being re-asserted stays suppressed.
+    entry.seenMs = nowMs;
+    m_entries.erase(it);
+    m_entries.insert(m_entries.begin(), entry);
+    return true;
+}
+
+void PayloadCache::Remember(uint64_t fingerprint, PayloadVerdict verdict, uint64_t nowMs) {
+    auto it = std::find_if(m_entries.begin(), m_entries.end(),
+        [fingerprint](const Entry& entry) { return entry.fingerprint == fingerprint; });
+    if (it != m_entries.end()) m_entries.erase(it);
+    else if (m_entries.size() == m_capacity) m_entries.pop_back();
+    m_entries.insert(m_entries.begin(), Entry{ fingerprint, verdict, nowMs });
+}
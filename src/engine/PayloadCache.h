@@ -0,0 +1,53 @@
+//================================================================================================//
+//                             Clipboard To File - Payload cache                                  //
+//                                                                                                //
+//  Remembers the fingerprints of recently classified payloads so clipboard updates that repeat  //
+//  the same text (clipboard managers re-asserting it, apps writing several formats in a row)   //
+//  are dropped without running the pipeline again.                                               //
+//================================================================================================//
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct EngineSettings;
+
+
+// 64-bit content hash of a payload; not cryptographic, only for spotting repeats.
+uint64_t FingerprintPayload(std::wstring_view text);
+
+// What the pipeline made of a payload.
+enum class PayloadVerdict : uint8_t {
+    NotAFile,   // No detector accepted it (or the filename was invalid); final for these settings
+    Handled     // A structure or file was created from it
+};
+
+// Small most-recently-used list of fingerprints and their verdicts. Negative verdicts hold until
+// the settings change. Handled payloads are only dropped when they repeat within the window, so
+// copying the same name again later still creates the file again.
+class PayloadCache {
+public:
+    explicit PayloadCache(size_t capacity = 32, uint64_t repeatWindowMs = 1000);
+
+    // True when the payload should be dropped. A new settings snapshot forgets every verdict.
+    bool IsDuplicate(uint64_t fingerprint, const std::shared_ptr<const EngineSettings>& settings, uint64_t nowMs);
+
+    // Records the verdict of a payload that was just processed.
+    void Remember(uint64_t fingerprint, PayloadVerdict verdict, uint64_t nowMs);
+
+    size_t Size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        uint64_t fingerprint;
+        PayloadVerdict verdict;
+        uint64_t seenMs;
+    };
+
+    std::vector<Entry> m_entries;                       // Most recent first
+    size_t m_capacity;
+    uint64_t m_repeatWindowMs;
+    std::shared_ptr<const EngineSettings> m_settings;   // Snapshot the verdicts were reached with
+};
@@ -0,0 +1,180 @@
+//================================================================================================//
+//                                Clipboard To File - Platform                                    //
+//                                                                                                //
+//  Thin filesystem layer used by the engine. PlatformWin32.cpp and PlatformPosix.cpp provide     //
+//  the implementations; everything above this header is platform-neutral.                        //
+//================================================================================================//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+const wchar_t kPathSeparator = L'\\';
+#else
+const wchar_t kPathSeparator = L'/';
+#endif
+
+enum class PathType {
+    None,
+    File,
+    Directory
+};
+
+// Returns what (if anything) exists at the given path.
+PathType FsGetPathType(const std::wstring& path);
+
+inline bool FsPathExists(const std::wstring& path) { return FsGetPathType(path) != PathType::None; }
+
+// Calls visit(name, type) for every entry of a directory except "." and "..", with type File or
+// Directory as FsGetPathType would report it. Reads the directory in large batches (getdents64,
+// FindFirstFileEx with a large fetch). Returns false if the directory cannot be listed.
+bool FsListDirectory(const std::wstring& path, const std::function<void(std::wstring_view name, PathType type)>& visit);
+
+// Creates a single directory. Succeeds if the directory already exists.
+bool FsCreateDirectory(const std::wstring& path);
+
+// Creates a single directory that file managers do not show: FILE_ATTRIBUTE_HIDDEN on Windows;
+// elsewhere the name should start with a dot. Fails if anything is already at the path.
+bool FsCreateHiddenDirectory(const std::wstring& path);
+
+// Creates a directory and any missing parents.
+bool FsCreateDirectories(const std::wstring& path);
+
+// Creates an empty file, failing if anything already exists at the path.
+bool FsCreateNewFile(const std::wstring& path);
+
+// Content is encoded and written in pieces of at most this many characters, so large content
+// never needs a second full-size copy; anything smaller goes out in a single write.
+const size_t kWriteChunkChars = 1u << 20;
+
+// How FsWriteTextFile lays out large content on disk.
+enum class WriteStrategy : uint8_t {
+    Auto,           // Picked from the encoded size and the thresholds below
+    Simple,         // Encode and write; the file grows as the data arrives
+    Preallocate,    // Reserve space first, then write whole chunks
+    Streaming       // Preallocate, and drop each chunk from the page cache once it is on disk
+};
+
+struct FsWriteOptions {
+    WriteStrategy strategy = WriteStrategy::Auto;
+    uint64_t preallocateMinBytes = 1ull << 20;  // Auto: preallocate from this size (see MinUtf8Bytes)
+    uint64_t streamingMinBytes = 256ull << 20;  // Auto: stream from this size
+    size_t chunkBytes = 4u << 20;               // Write size for Preallocate and Streaming, a multiple of 4 KB
+    bool syncData = false;                      // Flush the data to disk before the file is closed
+};
+
+// Lower bound of the encoded size (every character takes at least one byte; exact for ASCII).
+// Strategies are picked and space reserved from this, so nothing has to scan the content first.
+inline uint64_t MinUtf8Bytes(std::wstring_view content) { return content.size(); }
+
+// The strategy options.strategy stands for at the given encoded size; never Auto.
+inline WriteStrategy ResolveWriteStrategy(const FsWriteOptions& options, uint64_t bytes) {
+    if (options.strategy != WriteStrategy::Auto) return options.strategy;
+    if (bytes >= options.streamingMinBytes) return WriteStrategy::Streaming;
+    if (bytes >= options.preallocateMinBytes) return WriteStrategy::Preallocate;
+    return WriteStrategy::Simple;
+}
+
+// options.chunkBytes rounded down to whole 4 KB pages, and at least one page.
+inline size_t AlignedWriteChunk(const FsWriteOptions& options) {
+    const size_t page = 4096;
+    return options.chunkBytes < page ? page : options.chunkBytes / page * page;
+}
+
+// Creates (or truncates) a file and writes the content as UTF-8 (no byte order mark). Preallocation
+// and the page-cache hints for Streaming are best effort: Streaming only drops pages on Linux.
+bool FsWriteTextFile(const std::wstring& path, std::wstring_view content, const FsWriteOptions& options = FsWriteOptions());
+
+// A file written a piece at a time, for content that arrives while it is still being parsed.
+// Each Append is encoded to UTF-8 and written straight away, so nothing accumulates here.
+class FsTextFileWriter {
+public:
+    FsTextFileWriter() = default;
+    ~FsTextFileWriter() { Close(); }
+    FsTextFileWriter(const FsTextFileWriter&) = delete;
+    FsTextFileWriter& operator=(const FsTextFileWriter&) = delete;
+
+    // Creates or truncates path.
+    bool Open(const std::wstring& path);
+    bool Append(std::wstring_view text);
+
+    // With syncData the data is flushed to disk first. Closing a closed writer succeeds.
+    bool Close(bool syncData = false);
+
+private:
+    intptr_t m_handle = -1;     // File descriptor, or HANDLE on Windows
+};
+
+// How FsReplaceTextFile puts new content in place of an existing file.
+enum class ReplaceMethod : uint8_t {
+    Auto,           // AnonymousTemp where the filesystem supports it, otherwise TempRename
+    TempRename,     // Write a hidden ".name.<pid>.<n>.tmp" sibling, then rename it over the target
+    AnonymousTemp,  // Linux: write an unnamed O_TMPFILE inode, then link it in and rename it over the target
+    InPlace         // Truncate and rewrite the target; not atomic, only a baseline for benchmarks
+};
+
+// Replaces target (or creates it) with content so that readers see either the old file or all of
+// the new one. With syncData the data is on disk before the new file becomes visible. Temp names
+// are unique per call, never probed; AnonymousTemp falls back to TempRename where unsupported.
+bool FsReplaceTextFile(const std::wstring& target, std::wstring_view content, const FsWriteOptions& options = FsWriteOptions(),
+    ReplaceMethod method = ReplaceMethod::Auto);
+
+// Moves source over target, replacing target if it exists.
+bool FsReplaceFile(const std::wstring& source, const std::wstring& target);
+
+// Moves a file or directory to target, failing if anything is already there (renameat2 with
+// RENAME_NOREPLACE, renamex_np with RENAME_EXCL, MoveFileEx). Where the filesystem has no such
+// rename, target is checked first, which leaves a small window for a race.
+bool FsRenameNoReplace(const std::wstring& source, const std::wstring& target);
+
+// Removes an empty directory.
+bool FsRemoveDirectory(const std::wstring& path);
+
+bool FsDeleteFile(const std::wstring& path);
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      DURABILITY                                                //
+//------------------------------------------------------------------------------------------------//
+// Flushes a file's data to disk (fdatasync, FlushFileBuffers).
+bool FsSyncFile(const std::wstring& path);
+
+// Flushes a directory's entries, so names created in it survive a crash. NTFS journals directory
+// changes and has no such call, so this always succeeds on Windows.
+bool FsSyncDirectory(const std::wstring& path);
+
+// Flushes everything pending on the filesystem that holds path in one call (syncfs, Linux). That
+// includes other programs' writes. Returns false where unavailable; callers then sync one by one.
+bool FsSyncFilesystem(const std::wstring& path);
+
+
+//------------------------------------------------------------------------------------------------//
+//                                    BATCHED CREATION                                            //
+//------------------------------------------------------------------------------------------------//
+enum class FsCreateStatus : uint8_t {
+    Pending,
+    Created,
+    Exists,     // Something was already at the path; it was left alone
+    Failed
+};
+
+struct FsCreateRequest {
+    std::wstring_view path;
+    std::wstring_view content;  // Files only, written as UTF-8; empty creates an empty file
+    bool isDirectory;
+    FsCreateStatus status;
+};
+
+// True when FsCreateBatch can submit work in batches (io_uring on Linux). Elsewhere callers
+// create entries one at a time with the functions above.
+bool FsBatchCreateAvailable();
+
+// Creates every request whose path is free, never touching existing entries. Requests in one
+// call must not depend on each other, so a directory and its children go in separate calls.
+// sync flushes each file's data to disk before it is closed (empty files have none). Returns
+// false, having done nothing, when no batched backend is available.
+bool FsCreateBatch(std::vector<FsCreateRequest>& requests, bool sync);
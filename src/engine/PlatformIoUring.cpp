@@ -0,0 +1,321 @@
+//================================================================================================//
+//                         Clipboard To File - io_uring batch backend                             //
+//                                                                                                //
+//  Creates directories and files in batches through io_uring, talking to the kernel with raw    //
+//  system calls. Each file is one linked chain: open into a fixed file slot, write, optionally   //
+//  fdatasync, close. Needs Linux 5.15 (mkdirat and direct descriptors); when the ring or any of  //
+//  those operations is missing, the batch backend reports itself unavailable.                    //
+//================================================================================================//
+#ifdef __linux__
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include "Platform.h"
+#include "TextEncoding.h"
+
+
+namespace {
+
+const unsigned kRingEntries = 256;
+const unsigned kFileSlots = 64;             // Files in flight per submission
+const size_t kMaxWriteChunk = 1u << 30;     // A single write may not exceed 2 GB
+
+enum OpKind : uint8_t { kMkdir, kOpen, kWrite, kSync, kClose };
+
+inline uint64_t PackUserData(size_t windowIndex, OpKind kind) { return (uint64_t(windowIndex) << 8) | kind; }
+
+class Ring {
+public:
+    Ring() = default;
+    ~Ring();
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    bool Init();
+
+    // Free submission entries, counting ones prepared but not yet submitted.
+    unsigned SqSpace() const { return m_sqEntries - (m_localTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE)); }
+
+    // A zeroed submission entry; the caller must have checked SqSpace.
+    io_uring_sqe* NextSqe();
+
+    // Submits everything prepared and waits for all of it, calling onComplete(userData, res) for
+    // each completion. False when the kernel refused the submission.
+    template <class Fn>
+    bool SubmitAndDrain(Fn&& onComplete);
+
+private:
+    int m_fd = -1;
+    void* m_ring = MAP_FAILED;
+    size_t m_ringSize = 0;
+    io_uring_sqe* m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t m_sqesSize = 0;
+
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned m_localTail = 0;
+
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned m_cqMask = 0;
+};
+
+Ring::~Ring() {
+    if (m_sqes != MAP_FAILED) munmap(m_sqes, m_sqesSize);
+    if (m_ring != MAP_FAILED) munmap(m_ring, m_ringSize);
+    if (m_fd >= 0) close(m_fd);   // Also closes anything still in the fixed file table
+}
+
+bool Ring::Init() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    m_fd = static_cast<int>(syscall(__NR_io_uring_setup, kRingEntries, &params));
+    if (m_fd < 0) return false;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) return false;
+
+    // One mapping holds both rings; the submission entries are a second one.
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_ringSize = std::max(sqSize, cqSize);
+    m_ring = mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_ring == MAP_FAILED) return false;
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* base = static_cast<char*>(m_ring);
+    m_sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    m_sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    m_sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    m_sqEntries = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_entries);
+    m_localTail = *m_sqTail;
+    m_cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    m_cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+
+    // Every operation the backend issues must be supported, or it is not used at all.
+    std::vector<unsigned char> probeBuffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeBuffer.data());
+    if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, 256) < 0) return false;
+    for (unsigned op : { IORING_OP_MKDIRAT, IORING_OP_OPENAT, IORING_OP_WRITE, IORING_OP_FSYNC, IORING_OP_CLOSE }) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+
+    // An empty fixed file table: files are opened straight into a slot and closed from it, so
+    // the chain never needs the descriptor number in user space.
+    int slots[kFileSlots];
+    std::fill(std::begin(slots), std::end(slots), -1);
+    return syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_FILES, slots, kFileSlots) >= 0;
+}
+
+io_uring_sqe* Ring::NextSqe() {
+    unsigned index = m_localTail & m_sqMask;
+    io_uring_sqe* sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[index] = index;
+    m_localTail++;
+    return sqe;
+}
+
+template <class Fn>
+bool Ring::SubmitAndDrain(Fn&& onComplete) {
+    unsigned toSubmit = m_localTail - *m_sqTail;
+    unsigned pending = toSubmit;
+    __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+
+    while (pending > 0) {
+        long submitted = syscall(__NR_io_uring_enter, m_fd, toSubmit, pending, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EBUSY) return false;
+            submitted = 0;
+        }
+        toSubmit -= static_cast<unsigned>(submitted);
+
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            onComplete(cqe.user_data, cqe.res);
+            pending--;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+// One ring per thread, created on first use. A kernel without support is only probed once.
+std::atomic<bool> g_ringUnsupported{ false };
+thread_local std::unique_ptr<Ring> t_ring;
+
+Ring* ThreadRing() {
+    if (t_ring) return t_ring.get();
+    if (g_ringUnsupported.load(std::memory_order_relaxed)) return nullptr;
+    auto ring = std::make_unique<Ring>();
+    if (!ring->Init()) {
+        g_ringUnsupported.store(true, std::memory_order_relaxed);
+        return nullptr;
+    }
+    t_ring = std::move(ring);
+    return t_ring.get();
+}
+
+// What happened to one request of the current submission.
+struct WindowEntry {
+    size_t request;
+    std::string path;           // UTF-8, must stay put until the submission completes
+    std::string content;
+    int result = 0;             // mkdirat or openat result
+    size_t written = 0;
+    bool failedAfterOpen = false;
+};
+
+unsigned SqesFor(const FsCreateRequest& request, size_t contentBytes, bool sync) {
+    if (request.isDirectory) return 1;
+    size_t chunks = (contentBytes + kMaxWriteChunk - 1) / kMaxWriteChunk;
+    return static_cast<unsigned>(2 + chunks + (sync ? 1 : 0));
+}
+
+void PrepareFile(Ring& ring, WindowEntry& entry, size_t windowIndex, unsigned slot, bool sync) {
+    io_uring_sqe* sqe = ring.NextSqe();
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<uint64_t>(entry.path.c_str());
+    sqe->len = 0666;
+    sqe->open_flags = O_WRONLY | O_CREAT | O_EXCL;   // No O_CLOEXEC: a slot has no descriptor to inherit
+    sqe->file_index = slot + 1;
+    sqe->flags = IOSQE_IO_LINK;     // A failed open cancels the rest of the chain
+    sqe->user_data = PackUserData(windowIndex, kOpen);
+
+    // Once open, the close must run whatever happens to the writes, hence hard links.
+    for (size_t offset = 0; offset < entry.content.size(); offset += kMaxWriteChunk) {
+        sqe = ring.NextSqe();
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = static_cast<int>(slot);
+        sqe->addr = reinterpret_cast<uint64_t>(entry.content.data() + offset);
+        sqe->len = static_cast<uint32_t>(std::min(kMaxWriteChunk, entry.content.size() - offset));
+        sqe->off = offset;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+        sqe->user_data = PackUserData(windowIndex, kWrite);
+    }
+    if (sync) {
+        sqe = ring.NextSqe();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = static_cast<int>(slot);
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+        sqe->user_data = PackUserData(windowIndex, kSync);
+    }
+    sqe = ring.NextSqe();
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+    sqe->user_data = PackUserData(windowIndex, kClose);
+}
+
+void PrepareDirectory(Ring& ring, WindowEntry& entry, size_t windowIndex) {
+    io_uring_sqe* sqe = ring.NextSqe();
+    sqe->opcode = IORING_OP_MKDIRAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<uint64_t>(entry.path.c_str());
+    sqe->len = 0777;
+    sqe->user_data = PackUserData(windowIndex, kMkdir);
+}
+
+FsCreateStatus FinalStatus(const FsCreateRequest& request, const WindowEntry& entry) {
+    if (entry.result == -EEXIST) return FsCreateStatus::Exists;
+    if (entry.result < 0) return FsCreateStatus::Failed;
+    if (request.isDirectory) return FsCreateStatus::Created;
+    if (entry.failedAfterOpen || entry.written != entry.content.size()) return FsCreateStatus::Failed;
+    return FsCreateStatus::Created;
+}
+
+} // namespace
+
+
+bool FsBatchCreateAvailable() {
+    return ThreadRing() != nullptr;
+}
+
+bool FsCreateBatch(std::vector<FsCreateRequest>& requests, bool sync) {
+    Ring* ring = ThreadRing();
+    if (!ring) return false;
+
+    // Entries are reserved up front: the kernel holds pointers into their strings.
+    std::vector<WindowEntry> window;
+    window.reserve(kRingEntries);
+
+    size_t next = 0;
+    while (next < requests.size()) {
+        // Fill one submission: as many requests as fit in the ring and the file table.
+        window.clear();
+        unsigned slotsUsed = 0;
+        while (next < requests.size() && window.size() < kRingEntries) {
+            FsCreateRequest& request = requests[next];
+            if (!request.isDirectory && slotsUsed == kFileSlots) break;
+
+            WindowEntry entry;
+            entry.request = next;
+            entry.path = WideToUtf8(request.path);
+            if (!request.isDirectory) entry.content = WideToUtf8(request.content);
+            // An empty file has no data to flush; its directory entry is the caller's to sync
+            const bool syncFile = sync && !entry.content.empty();
+            if (SqesFor(request, entry.content.size(), syncFile) > ring->SqSpace()) {
+                if (window.empty()) return false;   // Cannot happen with the chunk limit above
+                break;
+            }
+
+            window.push_back(std::move(entry));
+            if (request.isDirectory) PrepareDirectory(*ring, window.back(), window.size() - 1);
+            else PrepareFile(*ring, window.back(), window.size() - 1, slotsUsed++, syncFile);
+            next++;
+        }
+
+        bool drained = ring->SubmitAndDrain([&](uint64_t userData, int res) {
+            WindowEntry& entry = window[userData >> 8];
+            switch (static_cast<OpKind>(userData & 0xFF)) {
+            case kMkdir:
+            case kOpen:
+                entry.result = res;
+                break;
+            case kWrite:
+                if (res >= 0) entry.written += static_cast<size_t>(res);
+                else if (res != -ECANCELED) entry.failedAfterOpen = true;
+                break;
+            case kSync:
+            case kClose:
+                if (res < 0 && res != -ECANCELED) entry.failedAfterOpen = true;
+                break;
+            }
+        });
+
+        if (!drained) {
+            // The ring is in an unknown state; drop it (closing its slots) and fail what is left.
+            t_ring.reset();
+            for (size_t i = window.empty() ? next : window.front().request; i < requests.size(); ++i) {
+                requests[i].status = FsCreateStatus::Failed;
+            }
+            return true;
+        }
+        for (const auto& entry : window) {
+            requests[entry.request].status = FinalStatus(requests[entry.request], entry);
+        }
+    }
+    return true;
+}
+
+#endif // __linux__
@@ -0,0 +1,397 @@
+//================================================================================================//
+//                          Clipboard To File - POSIX filesystem layer                            //
+//================================================================================================//
+#ifndef _WIN32
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "Platform.h"
+#include "TextEncoding.h"
+
+
+PathType FsGetPathType(const std::wstring& path) {
+    struct stat st;
+    if (stat(WideToUtf8(path).c_str(), &st) != 0) return PathType::None;
+    return S_ISDIR(st.st_mode) ? PathType::Directory : PathType::File;
+}
+
+// Type of a directory entry, asking the filesystem only when the listing does not say or the
+// entry is a symlink (followed, like stat in FsGetPathType).
+static PathType EntryType(int directoryFd, const char* name, unsigned char dtype) {
+    if (dtype == DT_DIR) return PathType::Directory;
+    if (dtype != DT_UNKNOWN && dtype != DT_LNK) return PathType::File;
+    struct stat st;
+    if (fstatat(directoryFd, name, &st, 0) != 0) return PathType::None;
+    return S_ISDIR(st.st_mode) ? PathType::Directory : PathType::File;
+}
+
+static bool IsDotOrDotDot(const char* name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+#ifdef __linux__
+// getdents64 record; glibc only wraps it from 2.30 on.
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool FsListDirectory(const std::wstring& path, const std::function<void(std::wstring_view name, PathType type)>& visit) {
+    int fd = open(WideToUtf8(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    // One call returns as many entries as fit, so a large buffer means few calls
+    const size_t kBufferBytes = 256 * 1024;
+    std::unique_ptr<char[]> buffer(new char[kBufferBytes]);
+    bool ok = true;
+    while (true) {
+        long bytes = syscall(SYS_getdents64, fd, buffer.get(), kBufferBytes);
+        if (bytes == 0) break;
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        for (long offset = 0; offset < bytes;) {
+            const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer.get() + offset);
+            offset += entry->d_reclen;
+            if (IsDotOrDotDot(entry->d_name)) continue;
+            PathType type = EntryType(fd, entry->d_name, entry->d_type);
+            if (type != PathType::None) visit(Utf8ToWide(entry->d_name), type);
+        }
+    }
+    close(fd);
+    return ok;
+}
+#else
+bool FsListDirectory(const std::wstring& path, const std::function<void(std::wstring_view name, PathType type)>& visit) {
+    DIR* dir = opendir(WideToUtf8(path).c_str());
+    if (!dir) return false;
+    errno = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (IsDotOrDotDot(entry->d_name)) continue;
+        PathType type = EntryType(dirfd(dir), entry->d_name, entry->d_type);
+        if (type != PathType::None) visit(Utf8ToWide(entry->d_name), type);
+    }
+    bool ok = errno == 0;
+    closedir(dir);
+    return ok;
+}
+#endif
+
+bool FsCreateDirectory(const std::wstring& path) {
+    if (mkdir(WideToUtf8(path).c_str(), 0777) == 0) return true;
+    return errno == EEXIST;
+}
+
+bool FsCreateHiddenDirectory(const std::wstring& path) {
+    return mkdir(WideToUtf8(path).c_str(), 0777) == 0;
+}
+
+bool FsCreateDirectories(const std::wstring& path) {
+    if (path.empty()) return false;
+    if (FsGetPathType(path) == PathType::Directory) return true;
+
+    size_t sep = path.find_last_of(L'/');
+    if (sep != std::wstring::npos && sep > 0) {
+        if (!FsCreateDirectories(path.substr(0, sep))) return false;
+    }
+    return FsCreateDirectory(path);
+}
+
+bool FsCreateNewFile(const std::wstring& path) {
+    int fd = open(WideToUtf8(path).c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+    close(fd);
+    return true;
+}
+
+// Writes all of data, resuming after partial writes and signals.
+static bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+#ifdef __linux__
+// Reserves space in one go instead of growing the file extent by extent, leaving its size alone
+// so an estimate that is too small costs nothing. Best effort: filesystems without fallocate
+// simply grow the file as it is written.
+static void Preallocate(int fd, uint64_t bytes) {
+    if (bytes > 0) fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+}
+
+// Starts writeback of a range that was just written.
+static void StartWriteback(int fd, off_t offset, size_t size) {
+    sync_file_range(fd, offset, static_cast<off_t>(size), SYNC_FILE_RANGE_WRITE);
+}
+
+// Waits for a range to reach the disk and drops it from the page cache.
+static void DropFromCache(int fd, off_t offset, size_t size) {
+    sync_file_range(fd, offset, static_cast<off_t>(size),
+        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(fd, offset, static_cast<off_t>(size), POSIX_FADV_DONTNEED);
+}
+#endif
+
+// Preallocate and Streaming: whole chunks at chunk-aligned offsets. Streaming keeps one chunk in
+// flight and drops the one before it, so a large write holds at most two chunks of page cache.
+static bool WriteSized(int fd, std::wstring_view content, uint64_t minBytes, size_t chunkBytes, bool streaming) {
+#ifdef __linux__
+    Preallocate(fd, minBytes);
+    off_t offset = 0;
+    size_t previous = 0;
+    bool written = WriteUtf8Blocks(content, chunkBytes, [&](const char* data, size_t size) {
+        if (!WriteAll(fd, data, size)) return false;
+        if (streaming) {
+            StartWriteback(fd, offset, size);
+            if (previous > 0) DropFromCache(fd, offset - static_cast<off_t>(previous), previous);
+            previous = size;
+        }
+        offset += static_cast<off_t>(size);
+        return true;
+    });
+    if (written && previous > 0) DropFromCache(fd, offset - static_cast<off_t>(previous), previous);
+    return written;
+#else
+    // No fallocate or sync_file_range here; aligned chunks are all that is left
+    (void)minBytes;
+    (void)streaming;
+    return WriteUtf8Blocks(content, chunkBytes, [fd](const char* data, size_t size) { return WriteAll(fd, data, size); });
+#endif
+}
+
+// fdatasync where there is one; macOS only declares fsync.
+static bool SyncData(int fd) {
+#ifdef __APPLE__
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+// Writes content with the strategy options pick, flushing the data first if options ask for it.
+static bool WriteContent(int fd, std::wstring_view content, const FsWriteOptions& options) {
+    const uint64_t minBytes = MinUtf8Bytes(content);
+    const WriteStrategy strategy = ResolveWriteStrategy(options, minBytes);
+    bool written = strategy == WriteStrategy::Simple
+        ? WriteUtf8Chunked(content, kWriteChunkChars, [fd](const char* data, size_t size) { return WriteAll(fd, data, size); })
+        : WriteSized(fd, content, minBytes, AlignedWriteChunk(options), strategy == WriteStrategy::Streaming);
+    if (written && options.syncData) written = SyncData(fd);
+    return written;
+}
+
+bool FsWriteTextFile(const std::wstring& path, std::wstring_view content, const FsWriteOptions& options) {
+    int fd = open(WideToUtf8(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+    bool written = WriteContent(fd, content, options);
+    bool closed = close(fd) == 0;
+    return written && closed;
+}
+
+bool FsTextFileWriter::Open(const std::wstring& path) {
+    Close();
+    int fd = open(WideToUtf8(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    m_handle = fd;
+    return fd >= 0;
+}
+
+bool FsTextFileWriter::Append(std::wstring_view text) {
+    if (m_handle < 0) return false;
+    const int fd = static_cast<int>(m_handle);
+    return WriteUtf8Chunked(text, kWriteChunkChars, [fd](const char* data, size_t size) { return WriteAll(fd, data, size); });
+}
+
+bool FsTextFileWriter::Close(bool syncData) {
+    if (m_handle < 0) return true;
+    const int fd = static_cast<int>(m_handle);
+    m_handle = -1;
+    bool synced = !syncData || SyncData(fd);
+    bool closed = close(fd) == 0;
+    return synced && closed;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                     REPLACEMENT                                                //
+//------------------------------------------------------------------------------------------------//
+// Hidden sibling name for a replacement in flight: ".name.<pid>.<n>.tmp". Unique per process and
+// call, so nothing is probed; a taken name can only be a leftover and the next n is used.
+static std::string TempSiblingName(const std::string& target) {
+    static std::atomic<uint32_t> counter{ 0 };
+    size_t sep = target.find_last_of('/');
+    size_t nameStart = sep == std::string::npos ? 0 : sep + 1;
+    return target.substr(0, nameStart) + "." + target.substr(nameStart) + "." + std::to_string(getpid()) +
+        "." + std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+}
+
+const int kTempNameAttempts = 16;
+
+static bool ReplaceViaTempSibling(const std::string& target, std::wstring_view content, const FsWriteOptions& options) {
+    std::string tempPath;
+    int fd = -1;
+    for (int attempt = 0; attempt < kTempNameAttempts && fd < 0; ++attempt) {
+        tempPath = TempSiblingName(target);
+        fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd < 0 && errno != EEXIST) return false;
+    }
+    if (fd < 0) return false;
+
+    bool written = WriteContent(fd, content, options);
+    bool closed = close(fd) == 0;
+    if (written && closed && rename(tempPath.c_str(), target.c_str()) == 0) return true;
+    unlink(tempPath.c_str());
+    return false;
+}
+
+#ifdef __linux__
+// Gives an O_TMPFILE inode a name. AT_EMPTY_PATH needs CAP_DAC_READ_SEARCH on older kernels; the
+// /proc link works for anyone but costs a path walk.
+static bool LinkAnonymous(int fd, const std::string& path) {
+    if (linkat(fd, "", AT_FDCWD, path.c_str(), AT_EMPTY_PATH) == 0) return true;
+    if (errno != ENOENT && errno != EPERM) return false;
+    char procPath[64];
+    std::snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", fd);
+    return linkat(AT_FDCWD, procPath, AT_FDCWD, path.c_str(), AT_SYMLINK_FOLLOW) == 0;
+}
+
+// Writes into an O_TMPFILE inode, which has no name until it is complete, then links it in under
+// a temp name and renames that over the target. No name is visible while data is being written,
+// and the temp name only for the rename. Returns false with errno EOPNOTSUPP (or EISDIR before
+// Linux 3.11) when the filesystem has no O_TMPFILE.
+static bool ReplaceViaAnonymousTemp(const std::string& target, std::wstring_view content, const FsWriteOptions& options) {
+    size_t sep = target.find_last_of('/');
+    std::string directory = sep == std::string::npos ? "." : sep == 0 ? "/" : target.substr(0, sep);
+    int fd = open(directory.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+
+    bool ok = WriteContent(fd, content, options);
+    std::string tempPath;
+    bool linked = false;
+    for (int attempt = 0; ok && attempt < kTempNameAttempts && !linked; ++attempt) {
+        tempPath = TempSiblingName(target);
+        linked = LinkAnonymous(fd, tempPath);
+        if (!linked && errno != EEXIST) break;
+    }
+    ok = linked && rename(tempPath.c_str(), target.c_str()) == 0;
+    if (linked && !ok) unlink(tempPath.c_str());
+    bool closed = close(fd) == 0;
+    if (!ok) errno = 0;   // Not an "unsupported" result the caller could fall back on
+    return ok && closed;
+}
+
+static bool IsTmpFileUnsupported(int error) {
+    return error == EOPNOTSUPP || error == EISDIR || error == EINVAL;
+}
+#endif
+
+bool FsReplaceTextFile(const std::wstring& target, std::wstring_view content, const FsWriteOptions& options, ReplaceMethod method) {
+    if (method == ReplaceMethod::InPlace) return FsWriteTextFile(target, content, options);
+    const std::string path = WideToUtf8(target);
+#ifdef __linux__
+    if (method != ReplaceMethod::TempRename) {
+        errno = 0;
+        if (ReplaceViaAnonymousTemp(path, content, options)) return true;
+        if (!IsTmpFileUnsupported(errno)) return false;
+    }
+#endif
+    return ReplaceViaTempSibling(path, content, options);
+}
+
+bool FsReplaceFile(const std::wstring& source, const std::wstring& target) {
+    return rename(WideToUtf8(source).c_str(), WideToUtf8(target).c_str()) == 0;
+}
+
+bool FsRenameNoReplace(const std::wstring& source, const std::wstring& target) {
+    const std::string from = WideToUtf8(source);
+    const std::string to = WideToUtf8(target);
+#if defined(__linux__) && defined(SYS_renameat2)
+    // Raw call: glibc only wraps renameat2 from 2.28 on
+    const unsigned kRenameNoReplace = 1;
+    if (syscall(SYS_renameat2, AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), kRenameNoReplace) == 0) return true;
+    if (errno != EINVAL && errno != ENOSYS) return false;
+#elif defined(__APPLE__)
+    if (renamex_np(from.c_str(), to.c_str(), RENAME_EXCL) == 0) return true;
+    if (errno != ENOTSUP) return false;
+#endif
+    struct stat st;
+    if (lstat(to.c_str(), &st) == 0) {
+        errno = EEXIST;
+        return false;
+    }
+    return rename(from.c_str(), to.c_str()) == 0;
+}
+
+bool FsRemoveDirectory(const std::wstring& path) {
+    return rmdir(WideToUtf8(path).c_str()) == 0;
+}
+
+bool FsDeleteFile(const std::wstring& path) {
+    return unlink(WideToUtf8(path).c_str()) == 0;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      DURABILITY                                                //
+//------------------------------------------------------------------------------------------------//
+bool FsSyncFile(const std::wstring& path) {
+    int fd = open(WideToUtf8(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool synced = SyncData(fd);
+    close(fd);
+    return synced;
+}
+
+bool FsSyncDirectory(const std::wstring& path) {
+    int fd = open(WideToUtf8(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+bool FsSyncFilesystem(const std::wstring& path) {
+#ifdef __linux__
+    int fd = open(WideToUtf8(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool synced = syncfs(fd) == 0;
+    close(fd);
+    return synced;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// Linux batches through io_uring (PlatformIoUring.cpp); other systems create entries one by one.
+#ifndef __linux__
+bool FsBatchCreateAvailable() {
+    return false;
+}
+
+bool FsCreateBatch(std::vector<FsCreateRequest>&, bool) {
+    return false;
+}
+#endif
+
+#endif // !_WIN32
@@ -0,0 +1,205 @@
+//================================================================================================//
+//                          Clipboard To File - Win32 filesystem layer                            //
+//================================================================================================//
+#ifdef _WIN32
+
+#include <windows.h>
+#include <atomic>
+#include "Platform.h"
+#include "TextEncoding.h"
+
+
+// "path\*", the pattern that lists everything in a directory.
+static std::wstring JoinSearchPattern(const std::wstring& path) {
+    std::wstring pattern = path;
+    if (!pattern.empty() && pattern.back() != L'\\' && pattern.back() != L'/') pattern += L'\\';
+    pattern += L'*';
+    return pattern;
+}
+
+PathType FsGetPathType(const std::wstring& path) {
+    DWORD attrs = GetFileAttributesW(path.c_str());
+    if (attrs == INVALID_FILE_ATTRIBUTES) return PathType::None;
+    return (attrs & FILE_ATTRIBUTE_DIRECTORY) ? PathType::Directory : PathType::File;
+}
+
+bool FsListDirectory(const std::wstring& path, const std::function<void(std::wstring_view name, PathType type)>& visit) {
+    WIN32_FIND_DATAW data;
+    // Basic info skips the 8.3 short names; a large fetch asks for many entries per call
+    HANDLE find = FindFirstFileExW(JoinSearchPattern(path).c_str(), FindExInfoBasic, &data,
+        FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) return false;
+    do {
+        const wchar_t* name = data.cFileName;
+        if (name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'))) continue;
+        visit(name, (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? PathType::Directory : PathType::File);
+    } while (FindNextFileW(find, &data));
+    bool ok = GetLastError() == ERROR_NO_MORE_FILES;
+    FindClose(find);
+    return ok;
+}
+
+bool FsCreateDirectory(const std::wstring& path) {
+    if (CreateDirectoryW(path.c_str(), NULL)) return true;
+    return GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+bool FsCreateHiddenDirectory(const std::wstring& path) {
+    if (!CreateDirectoryW(path.c_str(), NULL)) return false;
+    SetFileAttributesW(path.c_str(), FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED);
+    return true;
+}
+
+bool FsCreateDirectories(const std::wstring& path) {
+    if (path.empty()) return false;
+    if (FsGetPathType(path) == PathType::Directory) return true;
+
+    size_t sep = path.find_last_of(L"\\/");
+    if (sep != std::wstring::npos && sep > 0 && path[sep - 1] != L':') {
+        if (!FsCreateDirectories(path.substr(0, sep))) return false;
+    }
+    return FsCreateDirectory(path);
+}
+
+bool FsCreateNewFile(const std::wstring& path) {
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    CloseHandle(hFile);
+    return true;
+}
+
+// Writes content with the strategy options pick, flushing the data first if options ask for it.
+static bool WriteContent(HANDLE hFile, std::wstring_view content, const FsWriteOptions& options) {
+    auto write = [hFile](const char* data, size_t size) {
+        // A chunk is at most 4 bytes per character, well below WriteFile's DWORD limit
+        DWORD done = 0;
+        return WriteFile(hFile, data, static_cast<DWORD>(size), &done, NULL) && done == size;
+    };
+
+    const uint64_t minBytes = MinUtf8Bytes(content);
+    bool written;
+    if (ResolveWriteStrategy(options, minBytes) == WriteStrategy::Simple) {
+        written = WriteUtf8Chunked(content, kWriteChunkChars, write);
+    }
+    else {
+        // Reserving the allocation up front lets NTFS lay the file out in one go; unlike moving
+        // the end of file it leaves the size alone, so a low estimate is harmless (best effort).
+        // Windows has no per-range page-cache hint, so Streaming writes the same way.
+        FILE_ALLOCATION_INFO allocation;
+        allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(minBytes);
+        SetFileInformationByHandle(hFile, FileAllocationInfo, &allocation, sizeof(allocation));
+        written = WriteUtf8Blocks(content, AlignedWriteChunk(options), write);
+    }
+    if (written && options.syncData) written = FlushFileBuffers(hFile) != FALSE;
+    return written;
+}
+
+bool FsWriteTextFile(const std::wstring& path, std::wstring_view content, const FsWriteOptions& options) {
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    bool written = WriteContent(hFile, content, options);
+    bool closed = CloseHandle(hFile) != FALSE;
+    return written && closed;
+}
+
+bool FsTextFileWriter::Open(const std::wstring& path) {
+    Close();
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    m_handle = reinterpret_cast<intptr_t>(hFile);
+    return hFile != INVALID_HANDLE_VALUE;
+}
+
+bool FsTextFileWriter::Append(std::wstring_view text) {
+    HANDLE hFile = reinterpret_cast<HANDLE>(m_handle);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    return WriteUtf8Chunked(text, kWriteChunkChars, [hFile](const char* data, size_t size) {
+        DWORD done = 0;
+        return WriteFile(hFile, data, static_cast<DWORD>(size), &done, NULL) && done == size;
+    });
+}
+
+bool FsTextFileWriter::Close(bool syncData) {
+    HANDLE hFile = reinterpret_cast<HANDLE>(m_handle);
+    if (hFile == INVALID_HANDLE_VALUE) return true;
+    m_handle = reinterpret_cast<intptr_t>(INVALID_HANDLE_VALUE);
+    bool synced = !syncData || FlushFileBuffers(hFile) != FALSE;
+    bool closed = CloseHandle(hFile) != FALSE;
+    return synced && closed;
+}
+
+// Hidden sibling name for a replacement in flight: ".name.<pid>.<n>.tmp". Unique per process and
+// call, so nothing is probed; a taken name can only be a leftover and the next n is used.
+static std::wstring TempSiblingName(const std::wstring& target) {
+    static std::atomic<uint32_t> counter{ 0 };
+    size_t sep = target.find_last_of(L"\\/");
+    size_t nameStart = sep == std::wstring::npos ? 0 : sep + 1;
+    return target.substr(0, nameStart) + L"." + target.substr(nameStart) + L"." + std::to_wstring(GetCurrentProcessId()) +
+        L"." + std::to_wstring(counter.fetch_add(1, std::memory_order_relaxed)) + L".tmp";
+}
+
+// Windows has no unnamed files, so every method but InPlace writes a temp sibling and moves it over.
+bool FsReplaceTextFile(const std::wstring& target, std::wstring_view content, const FsWriteOptions& options, ReplaceMethod method) {
+    if (method == ReplaceMethod::InPlace) return FsWriteTextFile(target, content, options);
+
+    const int kTempNameAttempts = 16;
+    std::wstring tempPath;
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < kTempNameAttempts && hFile == INVALID_HANDLE_VALUE; ++attempt) {
+        tempPath = TempSiblingName(target);
+        hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS) return false;
+    }
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+
+    bool written = WriteContent(hFile, content, options);
+    bool closed = CloseHandle(hFile) != FALSE;
+    const DWORD moveFlags = MOVEFILE_REPLACE_EXISTING | (options.syncData ? MOVEFILE_WRITE_THROUGH : 0);
+    if (written && closed && MoveFileExW(tempPath.c_str(), target.c_str(), moveFlags)) return true;
+    DeleteFileW(tempPath.c_str());
+    return false;
+}
+
+bool FsReplaceFile(const std::wstring& source, const std::wstring& target) {
+    return MoveFileExW(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
+
+bool FsRenameNoReplace(const std::wstring& source, const std::wstring& target) {
+    // Without MOVEFILE_REPLACE_EXISTING the move fails if target exists, for directories too
+    return MoveFileExW(source.c_str(), target.c_str(), 0) != FALSE;
+}
+
+bool FsRemoveDirectory(const std::wstring& path) {
+    return RemoveDirectoryW(path.c_str()) != FALSE;
+}
+
+bool FsDeleteFile(const std::wstring& path) {
+    return DeleteFileW(path.c_str()) != FALSE;
+}
+
+bool FsSyncFile(const std::wstring& path) {
+    // FlushFileBuffers needs a handle opened for writing
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    bool synced = FlushFileBuffers(hFile) != FALSE;
+    CloseHandle(hFile);
+    return synced;
+}
+
+bool FsSyncDirectory(const std::wstring&) {
+    return true;
+}
+
+bool FsSyncFilesystem(const std::wstring&) {
+    // Flushing a whole volume needs administrator rights
+    return false;
+}
+
+bool FsBatchCreateAvailable() {
+    return false;
+}
+
+bool FsCreateBatch(std::vector<FsCreateRequest>&, bool) {
+    return false;
+}
+
+#endif // _WIN32
@@ -0,0 +1,79 @@
+//================================================================================================//
+//                                Clipboard To File - Settings file                               //
+//================================================================================================//
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include "nlohmann/json.hpp"
+#include "SettingsFile.h"
+#include "TextEncoding.h"
+
+
+SettingsFileStatus LoadSettingsFile(const std::wstring& path, AppSettings& settings) {
+    std::ifstream f{ std::filesystem::path(path) };
+    if (!f.is_open()) return SettingsFileStatus::Missing;
+
+    const AppSettings defaults = GetDefaultSettings();
+    AppSettings loaded = defaults;
+    try {
+        nlohmann::json j = nlohmann::json::parse(f);
+        loaded.isCreateEmptyFileEnabled = j.value("createEmptyFileEnabled", defaults.isCreateEmptyFileEnabled);
+        loaded.isCreateWithContentEnabled = j.value("createWithContentEnabled", defaults.isCreateWithContentEnabled);
+        loaded.isCreateDirectoryStructureEnabled = j.value("createDirectoryStructureEnabled", defaults.isCreateDirectoryStructureEnabled);
+        loaded.createEmptyDirectories = j.value("createEmptyDirectories", defaults.createEmptyDirectories);
+        loaded.skipExistingDirectories = j.value("skipExistingDirectories", defaults.skipExistingDirectories);
+        loaded.materializeThreads = j.value("materializeThreads", defaults.materializeThreads);
+        loaded.useIoUring = j.value("useIoUring", defaults.useIoUring);
+        const FsWriteOptions& writeDefaults = defaults.writeOptions;
+        loaded.writeOptions.strategy = ParseWriteStrategy(j.value("writeStrategy", std::string()), writeDefaults.strategy);
+        loaded.writeOptions.preallocateMinBytes = j.value("preallocateThresholdKB", writeDefaults.preallocateMinBytes >> 10) << 10;
+        loaded.writeOptions.streamingMinBytes = j.value("streamingThresholdMB", writeDefaults.streamingMinBytes >> 20) << 20;
+        loaded.writeOptions.chunkBytes = j.value("writeChunkKB", writeDefaults.chunkBytes >> 10) << 10;
+        loaded.durability = ParseDurability(j.value("durability", std::string()), defaults.durability);
+        loaded.stageStructures = j.value("stageStructures", defaults.stageStructures);
+
+        if (j.contains("allowedExtensions")) {
+            loaded.allowedExtensions.clear();
+            for (const auto& str : j["allowedExtensions"]) loaded.allowedExtensions.push_back(Utf8ToWide(str.get<std::string>()));
+        }
+        if (j.contains("contentCreationRegexes")) {
+            loaded.contentCreationRegexes.clear();
+            for (const auto& str : j["contentCreationRegexes"]) loaded.contentCreationRegexes.push_back(Utf8ToWide(str.get<std::string>()));
+        }
+        loaded.heuristicWordCountLimit = j.value("heuristicWordCountLimit", defaults.heuristicWordCountLimit);
+    }
+    catch (const nlohmann::json::exception&) {
+        return SettingsFileStatus::Invalid;
+    }
+    settings = std::move(loaded);
+    return SettingsFileStatus::Loaded;
+}
+
+bool SaveSettingsFile(const std::wstring& path, const AppSettings& settings) {
+    nlohmann::json j;
+    j["createEmptyFileEnabled"] = settings.isCreateEmptyFileEnabled;
+    j["createWithContentEnabled"] = settings.isCreateWithContentEnabled;
+    j["createDirectoryStructureEnabled"] = settings.isCreateDirectoryStructureEnabled;
+    j["createEmptyDirectories"] = settings.createEmptyDirectories;
+    j["skipExistingDirectories"] = settings.skipExistingDirectories;
+    j["materializeThreads"] = settings.materializeThreads;
+    j["useIoUring"] = settings.useIoUring;
+    j["writeStrategy"] = WriteStrategyName(settings.writeOptions.strategy);
+    j["preallocateThresholdKB"] = settings.writeOptions.preallocateMinBytes >> 10;
+    j["streamingThresholdMB"] = settings.writeOptions.streamingMinBytes >> 20;
+    j["writeChunkKB"] = settings.writeOptions.chunkBytes >> 10;
+    j["durability"] = DurabilityName(settings.durability);
+    j["stageStructures"] = settings.stageStructures;
+
+    std::vector<std::string> utf8_allowedExtensions;
+    for (const auto& wstr : settings.allowedExtensions) utf8_allowedExtensions.push_back(WideToUtf8(wstr));
+    j["allowedExtensions"] = utf8_allowedExtensions;
+
+    std::vector<std::string> utf8_regexes;
+    for (const auto& wstr : settings.contentCreationRegexes) utf8_regexes.push_back(WideToUtf8(wstr));
+    j["contentCreationRegexes"] = utf8_regexes;
+    j["heuristicWordCountLimit"] = settings.heuristicWordCountLimit;
+    std::ofstream o{ std::filesystem::path(path) };
+    o << std::setw(2) << j << std::endl;
+    return static_cast<bool>(o);
+}
@@ -0,0 +1,25 @@
+//================================================================================================//
+//                                Clipboard To File - Settings file                               //
+//                                                                                                //
+//  Reads and writes AppSettings as config.json, for every host that shares the user's settings   //
+//  (the tray app, clip2file). Uses nlohmann/json from libs/, so it is built into the hosts       //
+//  rather than into the dependency-free engine library.                                          //
+//================================================================================================//
+#pragma once
+
+#include <string>
+#include "ClipboardEngine.h"
+
+
+enum class SettingsFileStatus {
+    Loaded,
+    Missing,    // No file at path (or it cannot be opened)
+    Invalid     // Not JSON, or a key has the wrong type
+};
+
+// Reads path into settings. Keys the file does not have are set to GetDefaultSettings(); on
+// anything but Loaded, settings is left as it was.
+SettingsFileStatus LoadSettingsFile(const std::wstring& path, AppSettings& settings);
+
+// Writes every key, so the file documents what can be set.
+bool SaveSettingsFile(const std::wstring& path, const AppSettings& settings);
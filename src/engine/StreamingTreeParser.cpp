@@ -0,0 +1,246 @@
+//================================================================================================//
+//                          Clipboard To File - Streaming tree parser                             //
+//================================================================================================//
+#include <cwchar>
+#include "StreamingTreeParser.h"
+
+
+namespace {
+
+// Trims a line the way LineIndex does: leading spaces and tabs make up the indent (a tab counts
+// as 4), and trailing spaces, tabs and '\r' go.
+std::wstring_view TrimLine(std::wstring_view line, int& indent) {
+    indent = 0;
+    size_t begin = 0;
+    for (; begin < line.size(); ++begin) {
+        if (line[begin] == L' ') indent++;
+        else if (line[begin] == L'\t') indent += 4;
+        else break;
+    }
+    size_t end = line.size();
+    while (end > begin && (line[end - 1] == L' ' || line[end - 1] == L'\t' || line[end - 1] == L'\r')) --end;
+    return line.substr(begin, end - begin);
+}
+
+const std::vector<uint32_t> kNoFiles;
+
+} // namespace
+
+
+StreamingTreeParser::StreamingTreeParser(TreeFormat format, TreeOperationSink& sink)
+    : m_format(format), m_sink(sink) {
+    m_isDirectory.push_back(true);   // The target directory
+    m_stack.push_back({ 0, -1 });
+}
+
+bool StreamingTreeParser::Feed(std::wstring_view chunk) {
+    if (m_stopped) return false;
+    bool ok = true;
+    size_t pos = 0;
+    while (ok && pos < chunk.size()) {
+        const wchar_t* newline = std::wmemchr(chunk.data() + pos, L'\n', chunk.size() - pos);
+        if (!newline) {
+            // The line goes on in the next chunk
+            std::wstring_view rest = chunk.substr(pos);
+            if (!m_lineOverlong && m_partial.size() + rest.size() <= kMaxLineChars) m_partial.append(rest);
+            else ok = PassOverlongLine(rest);
+            break;
+        }
+        const size_t end = static_cast<size_t>(newline - chunk.data());
+        std::wstring_view segment = chunk.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (m_lineOverlong) {
+            ok = PassOverlongLine(segment);
+            m_lineOverlong = false;
+        }
+        else if (!m_partial.empty()) {
+            m_partial.append(segment);
+            ok = ParseLine(m_partial) && FlushContent();   // Pending content must not outlive m_partial
+            m_partial.clear();
+        }
+        else {
+            ok = ParseLine(segment);
+        }
+    }
+    ok = ok && FlushContent();   // Nor the chunk
+    if (!ok) m_stopped = true;
+    return ok;
+}
+
+bool StreamingTreeParser::Finish() {
+    if (m_stopped) return false;
+    bool ok = true;
+    if (m_lineOverlong) {
+        m_lineOverlong = false;
+    }
+    else if (!m_partial.empty()) {
+        ok = ParseLine(m_partial) && FlushContent();
+        m_partial.clear();
+    }
+    if (ok && m_inContent) {
+        m_inContent = false;
+        ok = m_sink.EndContent(false);
+    }
+    if (!ok) m_stopped = true;
+    return ok;
+}
+
+bool StreamingTreeParser::ParseLine(std::wstring_view line) {
+    return m_format == TreeFormat::Enhanced ? ParseEnhancedLine(line) : ParsePathLine(line);
+}
+
+bool StreamingTreeParser::AddEntry(uint32_t parent, std::wstring_view name, bool isDirectory, uint32_t& entry) {
+    entry = ++m_entryCount;
+    m_isDirectory.push_back(isDirectory);
+    if (isDirectory) m_dirCount++;
+    else m_fileCount++;
+    return m_sink.AddEntry(parent, name, isDirectory);
+}
+
+// Same rules as ParsePathListFormat.
+bool StreamingTreeParser::ParsePathLine(std::wstring_view line) {
+    int indent;
+    std::wstring_view path = TrimLine(line, indent);
+    if (path.empty()) return true;
+
+    m_components.clear();
+    size_t start = 0;
+    for (size_t pos = 0; pos <= path.size(); ++pos) {
+        if (pos < path.size() && path[pos] != L'/' && path[pos] != L'\\') continue;
+        if (pos > start) m_components.push_back(path.substr(start, pos - start));
+        start = pos + 1;
+    }
+    if (m_components.empty()) return true;
+    const bool endsWithSeparator = path.back() == L'/' || path.back() == L'\\';
+
+    uint32_t current = 0;
+    for (size_t c = 0; c < m_components.size(); ++c) {
+        std::wstring_view comp = m_components[c];
+        bool isLastComponent = (c == m_components.size() - 1);
+        bool isDir = isLastComponent ? endsWithSeparator : true;
+        if (isLastComponent && !isDir) {
+            size_t dotPos = comp.find_last_of(L'.');
+            isDir = (dotPos == std::wstring_view::npos || dotPos == 0);
+        }
+
+        // Key: the parent's number as two 16-bit units, then the name
+        m_key.assign(1, static_cast<wchar_t>(current >> 16));
+        m_key += static_cast<wchar_t>(current & 0xFFFF);
+        m_key.append(comp);
+        uint32_t child;
+        auto it = m_children.find(m_key);
+        if (it != m_children.end()) {
+            child = it->second;
+        }
+        else {
+            if (!AddEntry(current, comp, isDir, child)) return false;
+            m_children.emplace(m_key, child);
+        }
+
+        if (isDir) {
+            // Listed as a file first: the tree parser keeps what is below it, but it is never created
+            if (!m_isDirectory[child]) return true;
+            current = child;
+        }
+    }
+    return true;
+}
+
+// Same rules as ParseEnhancedFormat.
+bool StreamingTreeParser::ParseEnhancedLine(std::wstring_view line) {
+    size_t marker = line.find(L"---START:");
+    if (marker != std::wstring_view::npos) {
+        size_t start = marker + 9;
+        size_t end = line.find(L"---", start);
+        if (end == std::wstring_view::npos) return AddGapLine(line);
+        if (!FlushContent()) return false;
+        if (m_inContent && !m_sink.EndContent(false)) return false;   // Replaced before it ended
+
+        auto files = m_filesByName.find(std::wstring(TrimView(line.substr(start, end - start), L" \t")));
+        if (!m_sink.BeginContent(files != m_filesByName.end() ? files->second : kNoFiles)) return false;
+        m_inContent = true;
+        m_sectionHasContent = false;
+        m_gap.clear();
+        return true;
+    }
+    if (line.find(L"---END:") != std::wstring_view::npos) {
+        if (!m_inContent) return true;
+        m_inContent = false;
+        m_gap.clear();
+        return FlushContent() && m_sink.EndContent(true);
+    }
+    if (m_inContent) return AddContentLine(line);
+
+    // Structure line
+    int indent;
+    std::wstring_view name = TrimLine(line, indent);
+    if (name.empty()) return true;
+    bool isDir = name.back() == L'/';
+    if (isDir) name.remove_suffix(1);
+
+    while (m_stack.size() > 1 && m_stack.back().second >= indent) m_stack.pop_back();
+    uint32_t entry;
+    if (!AddEntry(m_stack.back().first, name, isDir, entry)) return false;
+    if (isDir) m_stack.push_back({ entry, indent });
+    else m_filesByName[std::wstring(name)].push_back(entry);
+    return true;
+}
+
+// Content is the section's text from the start of its first non-empty line to the end of its
+// last content line, as ParseEnhancedFormat slices it. Lines of one chunk are passed on as a
+// single run of the chunk's text; a run never outlives its chunk (see Feed), so a line that
+// arrives while one is open lies further on in the same chunk.
+bool StreamingTreeParser::AddContentLine(std::wstring_view line) {
+    if (!m_sectionHasContent && line.empty()) return true;
+    if (m_runBegin) {
+        m_runEnd = line.data() + line.size();
+        return true;
+    }
+    if (!StartContent()) return false;
+    m_runBegin = line.data();
+    m_runEnd = line.data() + line.size();
+    return true;
+}
+
+// Readies the sink for more content: what is pending goes out, then the line break (and any
+// gap lines) that separate it from what comes next.
+bool StreamingTreeParser::StartContent() {
+    if (!FlushContent()) return false;
+    if (m_sectionHasContent) {
+        m_gap += L'\n';
+        if (!m_sink.AppendContent(m_gap)) return false;
+    }
+    m_gap.clear();
+    m_sectionHasContent = true;
+    return true;
+}
+
+// An unclosed "---START:" line inside a section is not content of its own, but the slice
+// ParseEnhancedFormat takes includes it when a content line follows. It is held back until one
+// shows up; the open run ends here, since the chunk may end before that line arrives.
+bool StreamingTreeParser::AddGapLine(std::wstring_view line) {
+    if (!m_inContent || !m_sectionHasContent) return true;
+    if (!FlushContent()) return false;
+    m_gap += L'\n';
+    m_gap.append(line);
+    return true;
+}
+
+bool StreamingTreeParser::FlushContent() {
+    if (!m_runBegin) return true;
+    std::wstring_view run(m_runBegin, static_cast<size_t>(m_runEnd - m_runBegin));
+    m_runBegin = m_runEnd = nullptr;
+    return m_sink.AppendContent(run);
+}
+
+// Hands on a line that outgrew kMaxLineChars, a piece at a time: as content inside a section,
+// otherwise nowhere.
+bool StreamingTreeParser::PassOverlongLine(std::wstring_view piece) {
+    if (!m_lineOverlong) {
+        m_lineOverlong = true;
+        if (m_inContent && !(StartContent() && m_sink.AppendContent(m_partial))) return false;
+        m_partial.clear();
+    }
+    return !m_inContent || m_sink.AppendContent(piece);
+}
@@ -0,0 +1,96 @@
+//================================================================================================//
+//                          Clipboard To File - Streaming tree parser                             //
+//                                                                                                //
+//  Parses path lists and the enhanced format from text that arrives in chunks, and hands every   //
+//  directory, file and piece of file content to a sink as soon as it has been read. Nothing      //
+//  holds the whole payload: memory is one chunk, one partial line and the entries' names,        //
+//  however large the file contents are.                                                          //
+//                                                                                                //
+//  The result matches ParsePathListFormat and ParseEnhancedFormat, except that a content         //
+//  section only reaches files listed before it, which is how generated dumps are laid out.       //
+//================================================================================================//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ClipboardEngine.h"
+
+
+// Receives a structure while it is parsed. Entries are numbered from 1 in the order they are
+// added; 0 is the target directory, like DirectoryTree::Root(). Returning false from any call
+// stops the parse.
+class TreeOperationSink {
+public:
+    virtual ~TreeOperationSink() = default;
+
+    virtual bool AddEntry(uint32_t parent, std::wstring_view name, bool isDirectory) = 0;
+
+    // A content section for files (entry numbers) starts; it replaces what an earlier section
+    // wrote to them once EndContent(true) arrives. EndContent(false): the section never ended,
+    // and the files keep what they had.
+    virtual bool BeginContent(const std::vector<uint32_t>& files) = 0;
+    virtual bool AppendContent(std::wstring_view text) = 0;
+    virtual bool EndContent(bool complete) = 0;
+};
+
+// Longest line kept whole while it arrives. A longer content line goes to the sink in pieces,
+// unchecked for markers; a longer structure line could not name anything and is dropped.
+const size_t kMaxLineChars = 1u << 20;
+
+class StreamingTreeParser {
+public:
+    // format is TreeFormat::PathList or TreeFormat::Enhanced.
+    StreamingTreeParser(TreeFormat format, TreeOperationSink& sink);
+
+    // Parses the next piece of text; chunks may end anywhere, even inside a line. Returns false
+    // once the sink has stopped the parse.
+    bool Feed(std::wstring_view chunk);
+
+    // Parses the last line, which has no '\n', and closes a section that never ended.
+    bool Finish();
+
+    int DirectoryCount() const { return m_dirCount; }
+    int FileCount() const { return m_fileCount; }
+
+private:
+    bool ParseLine(std::wstring_view line);
+    bool ParsePathLine(std::wstring_view line);
+    bool ParseEnhancedLine(std::wstring_view line);
+    bool AddEntry(uint32_t parent, std::wstring_view name, bool isDirectory, uint32_t& entry);
+    bool AddContentLine(std::wstring_view line);
+    bool AddGapLine(std::wstring_view line);
+    bool StartContent();
+    bool FlushContent();
+    bool PassOverlongLine(std::wstring_view piece);
+
+    TreeFormat m_format;
+    TreeOperationSink& m_sink;
+    bool m_stopped = false;
+    uint32_t m_entryCount = 0;
+    int m_dirCount = 0;
+    int m_fileCount = 0;
+    std::vector<bool> m_isDirectory;    // By entry number
+
+    // A line cut by the end of a chunk, until it grows past kMaxLineChars (m_lineOverlong)
+    std::wstring m_partial;
+    bool m_lineOverlong = false;
+
+    // Path lists: each entry by "parent/name", so repeated prefixes are added once
+    std::unordered_map<std::wstring, uint32_t> m_children;
+    std::vector<std::wstring_view> m_components;
+    std::wstring m_key;
+
+    // Enhanced: open directories as (entry, indent), and every file by name for the sections
+    std::vector<std::pair<uint32_t, int>> m_stack;
+    std::unordered_map<std::wstring, std::vector<uint32_t>> m_filesByName;
+    bool m_inContent = false;
+    bool m_sectionHasContent = false;
+    std::wstring m_gap;                 // Held-back lines between two runs (see AddGapLine)
+
+    // Content lines not handed to the sink yet: one run of consecutive lines of the current chunk
+    const wchar_t* m_runBegin = nullptr;
+    const wchar_t* m_runEnd = nullptr;
+};
@@ -0,0 +1,234 @@
+//================================================================================================//
+//                              Clipboard To File - Text encoding                                 //
+//================================================================================================//
+#include <algorithm>
+#include <cstdint>
+#include "AsciiKernels.h"
+#include "TextEncoding.h"
+
+
+namespace {
+
+const char32_t kReplacementChar = 0xFFFD;
+
+// Shorter ASCII runs are cheaper to convert inline than through a kernel call.
+const size_t kKernelMinRun = 8;
+
+template <typename Unit>
+inline bool StartsAsciiRun(const Unit* p, const Unit* end) {
+    if (static_cast<uint32_t>(p[0]) >= 0x80 || static_cast<size_t>(end - p) < kKernelMinRun) return false;
+    uint32_t any = 0;
+    for (size_t i = 0; i < kKernelMinRun; ++i) any |= static_cast<uint32_t>(p[i]);
+    return any < 0x80;
+}
+
+// Decodes one code point from wide input, combining UTF-16 surrogate pairs where wchar_t is 16 bits.
+char32_t DecodeWide(const wchar_t* p, const wchar_t* end, size_t& consumed) {
+    char32_t c = static_cast<char32_t>(p[0]);
+    consumed = 1;
+    if (sizeof(wchar_t) == 2) {
+        c &= 0xFFFF;
+        if (c >= 0xD800 && c <= 0xDBFF) {
+            if (p + 1 < end) {
+                char32_t low = static_cast<char32_t>(p[1]) & 0xFFFF;
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    consumed = 2;
+                    return 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                }
+            }
+            return kReplacementChar;
+        }
+        if (c >= 0xDC00 && c <= 0xDFFF) return kReplacementChar;
+        return c;
+    }
+    if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) return kReplacementChar;
+    return c;
+}
+
+inline size_t Utf8Size(char32_t c) {
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+inline char* PutUtf8(char* out, char32_t c) {
+    if (c < 0x80) {
+        *out++ = static_cast<char>(c);
+    }
+    else if (c < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (c >> 6));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    else if (c < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (c >> 12));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    else {
+        *out++ = static_cast<char>(0xF0 | (c >> 18));
+        *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return out;
+}
+
+inline wchar_t* PutWide(wchar_t* out, char32_t c) {
+    if (sizeof(wchar_t) == 2 && c >= 0x10000) {
+        c -= 0x10000;
+        *out++ = static_cast<wchar_t>(0xD800 + (c >> 10));
+        *out++ = static_cast<wchar_t>(0xDC00 + (c & 0x3FF));
+    }
+    else {
+        *out++ = static_cast<wchar_t>(c);
+    }
+    return out;
+}
+
+// Decodes one UTF-8 sequence, rejecting overlong forms, surrogates and truncated sequences.
+char32_t DecodeUtf8Sequence(const unsigned char* p, const unsigned char* end, size_t& consumed) {
+    unsigned char lead = p[0];
+    consumed = 1;
+    if (lead < 0x80) return lead;
+
+    int length;
+    char32_t c;
+    char32_t minimum;
+    if ((lead & 0xE0) == 0xC0) { length = 2; c = lead & 0x1F; minimum = 0x80; }
+    else if ((lead & 0xF0) == 0xE0) { length = 3; c = lead & 0x0F; minimum = 0x800; }
+    else if ((lead & 0xF8) == 0xF0) { length = 4; c = lead & 0x07; minimum = 0x10000; }
+    else return kReplacementChar;
+
+    for (int i = 1; i < length; ++i) {
+        if (p + i >= end || (p[i] & 0xC0) != 0x80) {
+            consumed = i;
+            return kReplacementChar;
+        }
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    consumed = length;
+    if (c < minimum || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) return kReplacementChar;
+    return c;
+}
+
+} // namespace
+
+
+// Both directions hand ASCII runs to the kernels and decode everything else one character at a time.
+size_t Utf8Length(std::wstring_view text) {
+    const AsciiKernels& kernels = GetAsciiKernels();
+    const wchar_t* p = text.data();
+    const wchar_t* end = p + text.size();
+    size_t length = 0;
+    while (p < end) {
+        if (StartsAsciiRun(p, end)) {
+            size_t ascii = kernels.scanWide(p, static_cast<size_t>(end - p));
+            p += ascii;
+            length += ascii;
+            continue;
+        }
+        size_t consumed;
+        length += Utf8Size(DecodeWide(p, end, consumed));
+        p += consumed;
+    }
+    return length;
+}
+
+size_t EncodeUtf8(std::wstring_view text, char* out) {
+    const AsciiKernels& kernels = GetAsciiKernels();
+    const wchar_t* p = text.data();
+    const wchar_t* end = p + text.size();
+    char* start = out;
+    while (p < end) {
+        if (StartsAsciiRun(p, end)) {
+            size_t ascii = kernels.narrow(p, static_cast<size_t>(end - p), out);
+            p += ascii;
+            out += ascii;
+            continue;
+        }
+        size_t consumed;
+        out = PutUtf8(out, DecodeWide(p, end, consumed));
+        p += consumed;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+size_t DecodeUtf8(std::string_view text, wchar_t* out) {
+    const AsciiKernels& kernels = GetAsciiKernels();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = p + text.size();
+    wchar_t* start = out;
+    while (p < end) {
+        if (StartsAsciiRun(p, end)) {
+            size_t ascii = kernels.widen(p, static_cast<size_t>(end - p), out);
+            p += ascii;
+            out += ascii;
+            continue;
+        }
+        size_t consumed;
+        out = PutWide(out, DecodeUtf8Sequence(p, end, consumed));
+        p += consumed;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+size_t Utf8ChunkEnd(std::wstring_view text, size_t maxChars) {
+    if (maxChars >= text.size()) return text.size();
+    size_t end = std::max<size_t>(maxChars, 1);
+    // Never split a UTF-16 surrogate pair between chunks
+    if (sizeof(wchar_t) == 2 && end < text.size()) {
+        uint32_t last = static_cast<uint32_t>(text[end - 1]) & 0xFFFF;
+        if (last >= 0xD800 && last <= 0xDBFF && end > 1) --end;
+    }
+    return end;
+}
+
+size_t Utf8CompletePrefix(std::string_view bytes) {
+    for (size_t back = 1; back <= 3 && back <= bytes.size(); ++back) {
+        unsigned char lead = static_cast<unsigned char>(bytes[bytes.size() - back]);
+        if ((lead & 0xC0) == 0x80) continue;
+        size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+        return length > back ? bytes.size() - back : bytes.size();
+    }
+    return bytes.size();
+}
+
+std::string WideToUtf8(std::wstring_view wstr) {
+    std::string out(Utf8Length(wstr), '\0');
+    EncodeUtf8(wstr, out.data());
+    return out;
+}
+
+std::wstring Utf8ToWide(std::string_view str) {
+    // Every byte yields at most one wide character, so reserving str.size() is always enough.
+    // Decoding goes through a small buffer rather than zero-filling all of that up front.
+    const size_t kChunkBytes = 4096;
+    wchar_t buffer[kChunkBytes];
+    std::wstring out;
+    out.reserve(str.size());
+    while (!str.empty()) {
+        size_t take = str.size();
+        // Cut before the last lead byte if its sequence would run past the chunk
+        if (take > kChunkBytes) take = Utf8CompletePrefix(str.substr(0, kChunkBytes));
+        out.append(buffer, DecodeUtf8(str.substr(0, take), buffer));
+        str.remove_prefix(take);
+    }
+    return out;
+}
+
+void Utf8StreamDecoder::Decode(std::string_view bytes, std::wstring& out) {
+    std::string_view input = bytes;
+    if (!m_pending.empty()) {
+        m_pending.append(bytes);
+        input = m_pending;
+    }
+    // Every byte yields at most one wide character
+    const size_t complete = Utf8CompletePrefix(input);
+    out.resize(complete);
+    out.resize(DecodeUtf8(input.substr(0, complete), &out[0]));
+    m_pending = std::string(input.substr(complete));
+}
+
+void Utf8StreamDecoder::Finish(std::wstring& out) {
+    out.resize(m_pending.size());
+    out.resize(DecodeUtf8(m_pending, &out[0]));
+    m_pending.clear();
+}
@@ -0,0 +1,89 @@
+//================================================================================================//
+//                              Clipboard To File - Text encoding                                 //
+//                                                                                                //
+//  Portable UTF-8 <-> wide conversion. wchar_t is UTF-16 on Windows and UTF-32 elsewhere; both   //
+//  are handled. Malformed input is replaced with U+FFFD rather than rejected.                    //
+//================================================================================================//
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+std::string WideToUtf8(std::wstring_view wstr);
+std::wstring Utf8ToWide(std::string_view str);
+
+// Most UTF-8 bytes a single wchar_t can produce (3 per UTF-16 unit, 4 per UTF-32 code point).
+const size_t kMaxUtf8PerWide = sizeof(wchar_t) == 2 ? 3 : 4;
+
+// Exact number of bytes EncodeUtf8 produces for text.
+size_t Utf8Length(std::wstring_view text);
+
+// Encodes text into out, which must have room for Utf8Length(text) bytes (or, without sizing
+// first, text.size() * kMaxUtf8PerWide). Returns bytes written.
+size_t EncodeUtf8(std::wstring_view text, char* out);
+
+// Decodes UTF-8 into out, which must have room for text.size() characters. Returns characters
+// written.
+size_t DecodeUtf8(std::string_view text, wchar_t* out);
+
+// Where to end a chunk of at most maxChars characters so a surrogate pair is never split.
+size_t Utf8ChunkEnd(std::wstring_view text, size_t maxChars);
+
+// Length of bytes without a trailing sequence that is still missing continuation bytes, for
+// text that arrives in pieces. Malformed bytes count as complete.
+size_t Utf8CompletePrefix(std::string_view bytes);
+
+// Decodes UTF-8 that arrives in pieces of any size (file reads, pipes): a sequence cut at the end
+// of one piece is held back and finished with the next.
+class Utf8StreamDecoder {
+public:
+    // Replaces out with the text of bytes, including what was held back from the last piece.
+    void Decode(std::string_view bytes, std::wstring& out);
+
+    // Replaces out with whatever is still held back; a sequence that never completed is U+FFFD.
+    void Finish(std::wstring& out);
+
+private:
+    std::string m_pending;
+};
+
+// Encodes text piece by piece into one reused worst-case buffer (a single pass, no sizing) and
+// hands each piece to write(const char* data, size_t size). Stops early and returns false when
+// write does.
+template <class Write>
+bool WriteUtf8Chunked(std::wstring_view text, size_t chunkChars, Write&& write) {
+    if (text.empty()) return true;
+    const size_t bufferChars = text.size() < chunkChars ? text.size() : chunkChars;
+    std::unique_ptr<char[]> buffer(new char[bufferChars * kMaxUtf8PerWide]);
+    while (!text.empty()) {
+        std::wstring_view chunk = text.substr(0, Utf8ChunkEnd(text, chunkChars));
+        if (!write(buffer.get(), EncodeUtf8(chunk, buffer.get()))) return false;
+        text.remove_prefix(chunk.size());
+    }
+    return true;
+}
+
+// Like WriteUtf8Chunked, but every piece except the last is exactly blockBytes long, so writes
+// start and end on block boundaries whatever the encoded length of each character.
+template <class Write>
+bool WriteUtf8Blocks(std::wstring_view text, size_t blockBytes, Write&& write) {
+    if (text.empty()) return true;
+    // Below one block before each encode and one piece is at most one block: two always fit
+    const size_t pieceChars = blockBytes / kMaxUtf8PerWide;
+    std::unique_ptr<char[]> buffer(new char[2 * blockBytes]);
+    size_t filled = 0;
+    while (!text.empty()) {
+        std::wstring_view piece = text.substr(0, Utf8ChunkEnd(text, pieceChars));
+        filled += EncodeUtf8(piece, buffer.get() + filled);
+        text.remove_prefix(piece.size());
+        if (filled >= blockBytes) {
+            if (!write(buffer.get(), blockBytes)) return false;
+            filled -= blockBytes;
+            std::memmove(buffer.get(), buffer.get() + blockBytes, filled);
+        }
+    }
+    return filled == 0 || write(buffer.get(), filled);
+}
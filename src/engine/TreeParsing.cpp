@@ -0,0 +1,382 @@
+//================================================================================================//
+//                         Clipboard To File - Directory structure parsing                        //
+//                                                                                                //
+//  Detects and parses the four supported structure formats (tree command output, indentation,   //
+//  path lists and the enhanced format with embedded file contents) into a TreeNode hierarchy.   //
+//================================================================================================//
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include "ClipboardEngine.h"
+
+
+namespace {
+
+// Open-addressed (parent, name) -> node index table over a DirectoryTree. Slots store only node
+// indices plus their hash; names are compared through the tree, so nothing is allocated per entry.
+class ChildTable {
+public:
+    explicit ChildTable(size_t expected) {
+        size_t capacity = 64;
+        while (capacity < expected * 2) capacity *= 2;
+        m_slots.assign(capacity, { 0, kNoNode });
+    }
+
+    // Returns the child of parent called name, creating it as isDirectory if missing.
+    uint32_t FindOrAdd(DirectoryTree& tree, uint32_t parent, std::wstring_view name, bool isDirectory) {
+        const size_t hash = Hash(parent, name);
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            Slot& slot = m_slots[i];
+            if (slot.node == kNoNode) {
+                uint32_t node = tree.AddChild(parent, name, isDirectory);
+                slot = { hash, node };
+                if (++m_count * 2 > m_slots.size()) Grow();
+                return node;
+            }
+            if (slot.hash == hash) {
+                const TreeNode& candidate = tree.Node(slot.node);
+                if (candidate.parent == parent && candidate.name == name) return slot.node;
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        size_t hash;
+        uint32_t node;
+    };
+
+    static size_t Hash(uint32_t parent, std::wstring_view name) {
+        return std::hash<std::wstring_view>()(name) ^ (static_cast<size_t>(parent) * static_cast<size_t>(0x9E3779B97F4A7C15ull));
+    }
+
+    void Grow() {
+        std::vector<Slot> old(m_slots.size() * 2, { 0, kNoNode });
+        old.swap(m_slots);
+        size_t mask = m_slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.node == kNoNode) continue;
+            size_t i = slot.hash & mask;
+            while (m_slots[i].node != kNoNode) i = (i + 1) & mask;
+            m_slots[i] = slot;
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    size_t m_count = 0;
+};
+
+} // namespace
+
+
+//------------------------------------------------------------------------------------------------//
+//                                      FLAT TREE                                                 //
+//------------------------------------------------------------------------------------------------//
+DirectoryTree::DirectoryTree() {
+    TreeNode root;
+    root.name = L"root";
+    root.isDirectory = true;
+    m_nodes.push_back(root);
+}
+
+uint32_t DirectoryTree::AddChild(uint32_t parent, std::wstring_view name, bool isDirectory) {
+    const uint32_t index = static_cast<uint32_t>(m_nodes.size());
+    TreeNode node;
+    node.name = name;
+    node.isDirectory = isDirectory;
+    node.parent = parent;
+    m_nodes.push_back(node);
+
+    TreeNode& owner = m_nodes[parent];
+    if (owner.lastChild == kNoNode) owner.firstChild = index;
+    else m_nodes[owner.lastChild].nextSibling = index;
+    owner.lastChild = index;
+    return index;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                     FORMAT DETECTION                                           //
+//------------------------------------------------------------------------------------------------//
+TreeFormat DetectTreeFormat(const LineIndex& lines) {
+    const std::wstring_view text = lines.Text();
+
+    // Check for tree command characters (using Unicode code points)
+    // 0x251C = '├', 0x2514 = '└', 0x2502 = '│'
+    if (text.find(static_cast<wchar_t>(0x251C)) != std::wstring_view::npos ||
+        text.find(static_cast<wchar_t>(0x2514)) != std::wstring_view::npos ||
+        text.find(static_cast<wchar_t>(0x2502)) != std::wstring_view::npos) {
+        return TreeFormat::TreeCommand;
+    }
+
+    // Check for enhanced format markers
+    if (text.find(L"---START:") != std::wstring_view::npos || text.find(L"---END:") != std::wstring_view::npos) {
+        return TreeFormat::Enhanced;
+    }
+
+    // Path list format contains forward or back slashes; indentation needs a leading space/tab.
+    bool anyLines = false;
+    bool hasSlashes = false;
+    bool hasIndentation = false;
+    for (size_t i = 0; i < lines.Count(); ++i) {
+        std::wstring_view line = lines.Line(i);
+        if (line.empty()) continue;
+        anyLines = true;
+        if (!hasSlashes && (line.find(L'/') != std::wstring_view::npos || line.find(L'\\') != std::wstring_view::npos)) {
+            hasSlashes = true;
+        }
+        if (line[0] == L' ' || line[0] == L'\t') {
+            hasIndentation = true;
+            break;
+        }
+    }
+
+    if (!anyLines) return TreeFormat::Unknown;
+    if (hasSlashes && !hasIndentation) return TreeFormat::PathList;
+    if (hasIndentation) return TreeFormat::Indentation;
+
+    return TreeFormat::Unknown;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                         PARSERS                                                //
+//------------------------------------------------------------------------------------------------//
+bool ParseTreeStructure(const LineIndex& lines, TreeFormat format, DirectoryTree& tree) {
+    switch (format) {
+    case TreeFormat::TreeCommand:
+        tree = ParseTreeCommandFormat(lines);
+        return true;
+    case TreeFormat::Indentation:
+        tree = ParseIndentationFormat(lines);
+        return true;
+    case TreeFormat::PathList:
+        tree = ParsePathListFormat(lines);
+        return true;
+    case TreeFormat::Enhanced:
+        tree = ParseEnhancedFormat(lines);
+        return true;
+    default:
+        return false;
+    }
+}
+
+DirectoryTree ParseTreeCommandFormat(const LineIndex& lines) {
+    DirectoryTree tree;
+    std::vector<uint32_t> stack;
+    stack.push_back(DirectoryTree::Root());
+
+    // 0x2502 = '│', 0x251C = '├', 0x2514 = '└', 0x2500 = '─'
+    const wchar_t treeChars[] = { L' ', L'\t', 0x2502, 0x251C, 0x2514, 0x2500, 0 };
+
+    for (size_t i = 0; i < lines.Count(); ++i) {
+        std::wstring_view line = lines.Line(i);
+        if (line.empty()) continue;
+
+        // Count depth by tree characters
+        size_t depth = 0;
+        size_t pos = 0;
+        while (pos < line.length()) {
+            if (line[pos] == 0x2502 || line[pos] == L' ') {  // 0x2502 is '│'
+                depth++;
+                pos += 4; // Tree characters are usually followed by 3 spaces
+            }
+            else {
+                break;
+            }
+        }
+
+        // Find the actual content after tree characters
+        size_t contentStart = line.find_first_not_of(treeChars, pos);
+        if (contentStart == std::wstring_view::npos) continue;
+
+        std::wstring_view name = TrimView(line.substr(contentStart), L" \t\r");
+        if (name.empty()) continue;
+
+        // Check if it's a directory (ends with /)
+        bool isDir = name.back() == L'/';
+        if (isDir) name.remove_suffix(1);
+
+        // Adjust stack to current depth
+        while (stack.size() > depth + 1) stack.pop_back();
+
+        // Create node and add to parent
+        uint32_t node = tree.AddChild(stack.back(), name, isDir);
+        if (isDir) stack.push_back(node);
+    }
+
+    return tree;
+}
+
+// Adds one indented line to the tree; shared by the indentation and enhanced parsers.
+static void AddIndentedLine(DirectoryTree& tree, std::vector<std::pair<uint32_t, int>>& stack,
+                            std::wstring_view name, int indent) {
+    if (name.empty()) return;
+
+    // Check if directory
+    bool isDir = name.back() == L'/';
+    if (isDir) name.remove_suffix(1);
+
+    // Find parent based on indentation
+    while (stack.size() > 1 && stack.back().second >= indent) {
+        stack.pop_back();
+    }
+
+    // Create node
+    uint32_t node = tree.AddChild(stack.back().first, name, isDir);
+    if (isDir) stack.push_back({ node, indent });
+}
+
+DirectoryTree ParseIndentationFormat(const LineIndex& lines) {
+    DirectoryTree tree;
+    std::vector<std::pair<uint32_t, int>> stack; // node, indent level
+    stack.push_back({ DirectoryTree::Root(), -1 });
+
+    for (size_t i = 0; i < lines.Count(); ++i) {
+        AddIndentedLine(tree, stack, lines.Trimmed(i), lines.Span(i).indent);
+    }
+
+    return tree;
+}
+
+DirectoryTree ParsePathListFormat(const LineIndex& lines) {
+    DirectoryTree tree;
+    std::vector<std::wstring_view> components;
+
+    // Children by (parent, name), so each component is found in O(1) instead of by scanning
+    // every sibling; a flat directory of N files would otherwise take O(N^2) to build.
+    ChildTable children(lines.Count());
+
+    for (size_t i = 0; i < lines.Count(); ++i) {
+        std::wstring_view path = lines.Trimmed(i);
+        if (path.empty()) continue;
+
+        // Split path into components on either separator
+        components.clear();
+        size_t start = 0;
+        for (size_t pos = 0; pos <= path.size(); ++pos) {
+            if (pos < path.size() && path[pos] != L'/' && path[pos] != L'\\') continue;
+            if (pos > start) components.push_back(path.substr(start, pos - start));
+            start = pos + 1;
+        }
+
+        if (components.empty()) continue;
+        const bool endsWithSeparator = path.back() == L'/' || path.back() == L'\\';
+
+        // Navigate/create path in tree
+        uint32_t current = DirectoryTree::Root();
+        for (size_t c = 0; c < components.size(); ++c) {
+            std::wstring_view comp = components[c];
+            bool isLastComponent = (c == components.size() - 1);
+            bool isDir = isLastComponent ? endsWithSeparator : true;
+
+            // Check for file extension in last component
+            if (isLastComponent && !isDir) {
+                size_t dotPos = comp.find_last_of(L'.');
+                isDir = (dotPos == std::wstring_view::npos || dotPos == 0); // No extension, assume directory
+            }
+
+            // Find or create child
+            uint32_t child = children.FindOrAdd(tree, current, comp, isDir);
+
+            if (isDir) current = child;
+        }
+    }
+
+    return tree;
+}
+
+DirectoryTree ParseEnhancedFormat(const LineIndex& lines) {
+    DirectoryTree tree;
+    std::vector<std::pair<uint32_t, int>> stack; // node, indent level
+    stack.push_back({ DirectoryTree::Root(), -1 });
+
+    // One pass: lines outside content sections build the structure, and each section is recorded
+    // as a slice of the clipboard text (its lines minus leading empty ones). A later section for
+    // the same name replaces an earlier one.
+    const std::wstring_view text = lines.Text();
+    std::unordered_map<std::wstring_view, std::wstring_view> sections;
+    std::wstring_view currentFile;
+    size_t contentBegin = 0;
+    size_t contentEnd = 0;
+    bool hasContent = false;
+    bool inContent = false;
+
+    for (size_t i = 0; i < lines.Count(); ++i) {
+        std::wstring_view line = lines.Line(i);
+
+        // Check for content start marker
+        size_t marker = line.find(L"---START:");
+        if (marker != std::wstring_view::npos) {
+            size_t start = marker + 9;
+            size_t end = line.find(L"---", start);
+            if (end != std::wstring_view::npos) {
+                currentFile = TrimView(line.substr(start, end - start), L" \t");
+                inContent = true;
+                hasContent = false;
+            }
+        }
+        // Check for content end marker
+        else if (line.find(L"---END:") != std::wstring_view::npos) {
+            if (inContent) {
+                inContent = false;
+                sections[currentFile] = hasContent ? text.substr(contentBegin, contentEnd - contentBegin) : std::wstring_view();
+            }
+        }
+        // Collect content
+        else if (inContent) {
+            if (!hasContent && line.empty()) continue;
+            if (!hasContent) contentBegin = lines.Span(i).begin;
+            contentEnd = lines.Span(i).end;
+            hasContent = true;
+        }
+        // Structure line
+        else {
+            AddIndentedLine(tree, stack, lines.Trimmed(i), lines.Span(i).indent);
+        }
+    }
+
+    // Every file node with a section's name receives its content
+    if (!sections.empty()) {
+        for (uint32_t n = DirectoryTree::Root() + 1; n < tree.Size(); ++n) {
+            TreeNode& node = tree.Node(n);
+            if (node.isDirectory) continue;
+            auto section = sections.find(node.name);
+            if (section != sections.end()) node.content = section->second;
+        }
+    }
+
+    return tree;
+}
+
+
+//------------------------------------------------------------------------------------------------//
+//                                   SUMMARY & PLANNING                                           //
+//------------------------------------------------------------------------------------------------//
+void GetTreeSummary(const DirectoryTree& tree, int& dirCount, int& fileCount) {
+    // Every node but the root is reachable, so a flat scan replaces the recursive walk.
+    for (uint32_t n = DirectoryTree::Root() + 1; n < tree.Size(); ++n) {
+        if (tree.Node(n).isDirectory) dirCount++;
+        else fileCount++;
+    }
+}
+
+// Detects and parses a directory structure. Returns false when the payload is not a structure
+// (or the feature is disabled), leaving the caller free to try file generation instead.
+bool PlanDirectoryStructure(const LineIndex& lines, const EngineSettings& settings, DirectoryStructurePlan& plan) {
+    if (!settings.app.isCreateDirectoryStructureEnabled) return false;
+
+    // Detect format
+    plan.format = DetectTreeFormat(lines);
+    if (plan.format == TreeFormat::Unknown) return false;
+
+    // Parse the structure
+    if (!ParseTreeStructure(lines, plan.format, plan.tree)) return false;
+
+    // Count items for user confirmation
+    plan.dirCount = 0;
+    plan.fileCount = 0;
+    GetTreeSummary(plan.tree, plan.dirCount, plan.fileCount);
+    return true;
+}
@@ -0,0 +1,68 @@
+//================================================================================================//
+//                               Clipboard To File - Worker pool                                  //
+//================================================================================================//
+#include <algorithm>
+#include "WorkerPool.h"
+
+
+WorkerPool::WorkerPool(size_t threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 1; i < threadCount; ++i) {
+        m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) thread.join();
+}
+
+void WorkerPool::ForEach(size_t count, const std::function<void(size_t)>& body) {
+    if (m_threads.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_body = &body;
+        m_count = count;
+        m_next.store(0, std::memory_order_relaxed);
+        m_busy = m_threads.size();
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    Drain();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_body = nullptr;
+}
+
+void WorkerPool::Drain() {
+    for (size_t i = m_next.fetch_add(1, std::memory_order_relaxed); i < m_count;
+        i = m_next.fetch_add(1, std::memory_order_relaxed)) {
+        (*m_body)(i);
+    }
+}
+
+void WorkerPool::WorkerLoop() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+        if (m_stopping) return;
+        seen = m_generation;
+
+        lock.unlock();
+        Drain();
+        lock.lock();
+
+        if (--m_busy == 0) m_done.notify_one();
+    }
+}
@@ -0,0 +1,47 @@
+//================================================================================================//
+//                               Clipboard To File - Worker pool                                  //
+//                                                                                                //
+//  A fixed set of threads that run one indexed loop at a time. Indices are handed out from a    //
+//  shared counter, so slow items (a file on a network share) do not hold up a fixed slice.      //
+//================================================================================================//
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class WorkerPool {
+public:
+    // threadCount includes the calling thread; 0 means one per core. A pool of one runs inline.
+    explicit WorkerPool(size_t threadCount);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t ThreadCount() const { return m_threads.size() + 1; }
+
+    // Calls body(i) once for every i in [0, count) and returns when all calls have finished.
+    // The calling thread works too. body must not throw.
+    void ForEach(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    void WorkerLoop();
+    void Drain();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(size_t)>* m_body = nullptr;
+    size_t m_count = 0;
+    std::atomic<size_t> m_next{ 0 };
+    uint64_t m_generation = 0;   // Bumped for every loop so sleeping workers know to join in
+    size_t m_busy = 0;           // Workers still draining the current loop
+    bool m_stopping = false;
+};
@@ -0,0 +1,160 @@
+//================================================================================================//
+//                            Clipboard To File - Materialization test                            //
+//                                                                                                //
+//  Creates fixed payloads in a scratch directory through CreateDirectoryStructure and            //
+//  StreamDirectoryStructure, with staging and io_uring each on and off, and checks that every    //
+//  combination reports success and leaves exactly the expected entries and contents behind.      //
+//  The payloads list names more than once, which every combination must merge. A paste that is   //
+//  cancelled part-way must stop, and with staging on leave the target untouched.                 //
+//                                                                                                //
+//  Usage: materialization_test [--scratch DIR]                                                   //
+//================================================================================================//
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+#include "ClipboardEngine.h"
+#include "LineIndex.h"
+
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct ExpectedEntry {
+    const char* path;           // Relative, '/'-separated; directories end with '/'
+    const char* content;        // Files only
+};
+
+struct MaterializeCase {
+    const char* name;
+    const wchar_t* payload;     // Enhanced format
+    std::vector<ExpectedEntry> expected;
+};
+
+const MaterializeCase kCases[] = {
+    { "directory listed twice", L"src/\n  a.txt\nsrc/\n  b.txt\n",
+        { { "src/", "" }, { "src/a.txt", "" }, { "src/b.txt", "" } } },
+    { "nested directory listed twice", L"src/\n  lib/\n    x.txt\nsrc/\n  lib/\n    y.txt\n  z.txt\n",
+        { { "src/", "" }, { "src/lib/", "" }, { "src/lib/x.txt", "" }, { "src/lib/y.txt", "" }, { "src/z.txt", "" } } },
+    { "file listed twice", L"src/\n  a.txt\n  a.txt\n",
+        { { "src/", "" }, { "src/a.txt", "" } } },
+    { "file listed twice, with content", L"src/\n  a.txt\nsrc/\n  a.txt\n---START: a.txt ---\nhello\n---END: a.txt ---\n",
+        { { "src/", "" }, { "src/a.txt", "hello" } } },
+};
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Every entry under target as "path" or "path/", with file contents.
+std::set<std::pair<std::string, std::string>> ListTarget(const fs::path& target) {
+    std::set<std::pair<std::string, std::string>> found;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(target, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string path = it->path().lexically_relative(target).generic_string();
+        if (it->is_directory()) found.insert({ path + "/", "" });
+        else found.insert({ path, ReadFile(it->path()) });
+    }
+    return found;
+}
+
+bool CreateAsTree(const std::wstring& payload, const fs::path& target, const AppSettings& settings, MaterializeReport& report,
+    const CancelCheck& cancelled = nullptr) {
+    const LineIndex lines(payload);
+    const DirectoryTree tree = ParseEnhancedFormat(lines);
+    return CreateDirectoryStructure(tree, target.wstring(), settings, report, cancelled);
+}
+
+// Streams the payload a few characters at a time, so names are split across chunks.
+bool CreateAsStream(const std::wstring& payload, const fs::path& target, const AppSettings& settings, MaterializeReport& report) {
+    size_t pos = 0;
+    auto read = [&](std::wstring& chunk) {
+        if (pos >= payload.size()) return false;
+        chunk = payload.substr(pos, 3);
+        pos += chunk.size();
+        return true;
+    };
+    return StreamDirectoryStructure(TreeFormat::Enhanced, read, target.wstring(), settings, report);
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    std::error_code ec;
+    fs::path scratch = fs::temp_directory_path(ec) / "ctf_materialization_test";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scratch") == 0 && i + 1 < argc) scratch = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: materialization_test [--scratch DIR]\n");
+            return 2;
+        }
+    }
+    const fs::path target = scratch / "target";
+
+    size_t checked = 0, failed = 0;
+    for (const auto& test : kCases) {
+        std::set<std::pair<std::string, std::string>> expected;
+        for (const auto& entry : test.expected) expected.insert({ entry.path, entry.content });
+
+        for (int combination = 0; combination < 8; ++combination) {
+            const bool stream = combination & 1;
+            AppSettings settings = GetDefaultSettings();
+            settings.durability = Durability::None;
+            settings.stageStructures = (combination & 2) != 0;
+            settings.useIoUring = (combination & 4) != 0;
+
+            fs::remove_all(target, ec);
+            fs::create_directories(target, ec);
+            MaterializeReport report;
+            const bool ok = stream
+                ? CreateAsStream(test.payload, target, settings, report)
+                : CreateAsTree(test.payload, target, settings, report);
+            const auto found = ListTarget(target);
+            ++checked;
+            if (ok && found == expected) continue;
+
+            ++failed;
+            std::printf("FAILED: %s (%s, staging %s, io_uring %s)\n", test.name, stream ? "stream" : "tree",
+                settings.stageStructures ? "on" : "off", settings.useIoUring ? "on" : "off");
+            if (!ok) std::printf("  reported: %ls\n", report.errorMessage.c_str());
+            for (const auto& entry : found) std::printf("  found     %s \"%s\"\n", entry.first.c_str(), entry.second.c_str());
+        }
+    }
+
+    // Cancelled after the first few polls: a paste of many files stops early, and reports it
+    std::wstring manyFiles = L"many/\n";
+    for (int i = 0; i < 1000; ++i) manyFiles += L"  f" + std::to_wstring(i) + L".txt\n";
+    for (int combination = 0; combination < 4; ++combination) {
+        AppSettings settings = GetDefaultSettings();
+        settings.durability = Durability::None;
+        settings.materializeThreads = 1;
+        settings.stageStructures = (combination & 1) != 0;
+        settings.useIoUring = (combination & 2) != 0;
+
+        fs::remove_all(target, ec);
+        fs::create_directories(target, ec);
+        int polls = 0;
+        MaterializeReport report;
+        const bool ok = CreateAsTree(manyFiles, target, settings, report, [&] { return ++polls > 3; });
+        const auto found = ListTarget(target);
+        // At most the directory and the files polled for before the cancel
+        const bool stopped = settings.stageStructures ? found.empty() : found.size() <= 3;
+        ++checked;
+        if (!ok && report.errorTitle == L"Cancelled" && stopped) continue;
+
+        ++failed;
+        std::printf("FAILED: cancel (staging %s, io_uring %s): returned %s, %zu entries left\n",
+            settings.stageStructures ? "on" : "off", settings.useIoUring ? "on" : "off", ok ? "true" : "false", found.size());
+    }
+    fs::remove_all(scratch, ec);
+
+    std::printf("%zu structures created from %zu payloads: %zu failed\n", checked, sizeof(kCases) / sizeof(kCases[0]), failed);
+    return failed == 0 ? 0 : 1;
+}
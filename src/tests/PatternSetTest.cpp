@@ -0,0 +1,397 @@
+//================================================================================================//
+//                            Clipboard To File - Pattern set test                                //
+//                                                                                                //
+//  Differential test: PatternSet against std::wregex (ECMAScript | icase, regex_match) over      //
+//  generated pattern lists and lines. Each case compiles one to three random patterns and        //
+//  checks which pattern matches first and the span of its capture group 1, through both Match    //
+//  and Matches. Lines are drawn from the patterns themselves, then mutated, so most cases come   //
+//  close to matching. The generator stays clear of the divergences listed in PatternSet.h;       //
+//  those are pinned by fixed cases at the end instead.                                           //
+//                                                                                                //
+//  Usage: pattern_set_test [--cases N] [--seed N]                                                //
+//================================================================================================//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+#include "PatternSet.h"
+
+
+namespace {
+
+// A generated regex: the pattern text plus enough structure to draw lines it matches.
+struct RxNode {
+    enum class Kind { Atom, Group, Concat, Alternate, Repeat, Begin, End };
+    Kind kind = Kind::Atom;
+    std::wstring text;          // Atom: its pattern text
+    std::wstring samples;       // Atom: characters it matches
+    std::vector<int> kids;
+    int min = 0;
+    int max = 0;                // Repeat: -1 = unbounded
+    bool lazy = false;
+    bool capture = false;       // Group
+};
+
+struct AtomSpec {
+    const wchar_t* text;
+    const wchar_t* samples;
+};
+
+// Samples list characters each atom matches under icase; the lines are built from them.
+const AtomSpec kAtoms[] = {
+    { L"a", L"aA" },
+    { L"B", L"bB" },
+    { L"x", L"xX" },
+    { L"1", L"1" },
+    { L"\\.", L"." },
+    { L"-", L"-" },
+    { L"_", L"_" },
+    { L" ", L" " },
+    { L".", L"ab.1 _" },
+    { L"[a-c]", L"abcABC" },
+    { L"[^.]", L"aZ1_ -" },
+    { L"[._-]", L"._-" },
+    { L"[^a-z]", L"1._ -" },
+    { L"[\\w.]", L"aB_9." },
+    { L"\\d", L"0159" },
+    { L"\\D", L"a._ " },
+    { L"\\w", L"aZ_9" },
+    { L"\\W", L".- " },
+    { L"\\s", L" \t" },
+    { L"\\S", L"a.1" },
+    { L"\\x41", L"aA" },
+    { L"\\u0062", L"bB" },
+    { L"\\t", L"\t" },
+};
+
+// Characters mutations insert: the atoms' samples plus a few no atom matches on purpose.
+const wchar_t kNoise[] = L"aAbBcxX1059._- \tZ/";
+
+class PatternGenerator {
+public:
+    explicit PatternGenerator(std::mt19937& rng) : m_rng(rng) {}
+
+    // A random pattern with its root node in m_nodes.
+    int Generate() {
+        m_nodes.clear();
+        std::vector<int> kids;
+        if (Chance(4)) kids.push_back(NewNode(RxNode::Kind::Begin));
+        kids.push_back(Alternation(0));
+        if (Chance(4)) kids.push_back(NewNode(RxNode::Kind::End));
+        int root = NewNode(RxNode::Kind::Concat);
+        m_nodes[root].kids = std::move(kids);
+        return root;
+    }
+
+    std::wstring Text(int node) const {
+        const RxNode& n = m_nodes[node];
+        std::wstring text;
+        switch (n.kind) {
+        case RxNode::Kind::Atom: return n.text;
+        case RxNode::Kind::Begin: return L"^";
+        case RxNode::Kind::End: return L"$";
+        case RxNode::Kind::Group: return (n.capture ? L"(" : L"(?:") + Text(n.kids[0]) + L")";
+        case RxNode::Kind::Concat:
+            for (int kid : n.kids) text += Text(kid);
+            return text;
+        case RxNode::Kind::Alternate:
+            for (size_t i = 0; i < n.kids.size(); ++i) text += (i ? L"|" : L"") + Text(n.kids[i]);
+            return text;
+        case RxNode::Kind::Repeat:
+            text = Text(n.kids[0]);
+            if (n.min == 0 && n.max == -1) text += L"*";
+            else if (n.min == 1 && n.max == -1) text += L"+";
+            else if (n.min == 0 && n.max == 1) text += L"?";
+            else if (n.max == -1) text += L"{" + std::to_wstring(n.min) + L",}";
+            else if (n.max == n.min) text += L"{" + std::to_wstring(n.min) + L"}";
+            else text += L"{" + std::to_wstring(n.min) + L"," + std::to_wstring(n.max) + L"}";
+            if (n.lazy) text += L"?";
+            return text;
+        }
+        return text;
+    }
+
+    // A line the node matches (anchors inside alternatives aside).
+    void Sample(int node, std::wstring& line) {
+        const RxNode& n = m_nodes[node];
+        switch (n.kind) {
+        case RxNode::Kind::Atom:
+            line += n.samples[Pick(n.samples.size())];
+            break;
+        case RxNode::Kind::Begin:
+        case RxNode::Kind::End:
+            break;
+        case RxNode::Kind::Group:
+            Sample(n.kids[0], line);
+            break;
+        case RxNode::Kind::Concat:
+            for (int kid : n.kids) Sample(kid, line);
+            break;
+        case RxNode::Kind::Alternate:
+            Sample(n.kids[Pick(n.kids.size())], line);
+            break;
+        case RxNode::Kind::Repeat: {
+            const int most = n.max == -1 ? n.min + 3 : n.max;
+            const int count = n.min + static_cast<int>(Pick(most - n.min + 1));
+            for (int i = 0; i < count; ++i) Sample(n.kids[0], line);
+            break;
+        }
+        }
+    }
+
+    bool Chance(int oneIn) { return Pick(oneIn) == 0; }
+    size_t Pick(size_t count) { return std::uniform_int_distribution<size_t>(0, count - 1)(m_rng); }
+
+private:
+    int NewNode(RxNode::Kind kind) {
+        m_nodes.emplace_back();
+        m_nodes.back().kind = kind;
+        return static_cast<int>(m_nodes.size() - 1);
+    }
+
+    int Alternation(int depth) {
+        const size_t branches = depth < 2 && Chance(4) ? 2 + Pick(2) : 1;
+        if (branches == 1) return Concat(depth);
+        int alt = NewNode(RxNode::Kind::Alternate);
+        for (size_t i = 0; i < branches; ++i) {
+            int branch = Concat(depth);
+            m_nodes[alt].kids.push_back(branch);
+        }
+        return alt;
+    }
+
+    int Concat(int depth) {
+        int concat = NewNode(RxNode::Kind::Concat);
+        const size_t atoms = 1 + Pick(depth == 0 ? 5 : 3);
+        for (size_t i = 0; i < atoms; ++i) {
+            int atom = Quantified(depth);
+            m_nodes[concat].kids.push_back(atom);
+        }
+        return concat;
+    }
+
+    int Quantified(int depth) {
+        int atom;
+        if (depth < 3 && Chance(4)) {
+            int body = Alternation(depth + 1);
+            atom = NewNode(RxNode::Kind::Group);
+            m_nodes[atom].kids.push_back(body);
+            m_nodes[atom].capture = !Chance(3);
+        }
+        else {
+            const AtomSpec& spec = kAtoms[Pick(sizeof(kAtoms) / sizeof(kAtoms[0]))];
+            atom = NewNode(RxNode::Kind::Atom);
+            m_nodes[atom].text = spec.text;
+            m_nodes[atom].samples = spec.samples;
+        }
+        if (!Chance(3)) return atom;
+
+        // A quantified group that can match empty is a known divergence
+        if (Nullable(atom)) return atom;
+
+        // Repeats of repeats make std::wregex backtrack exponentially; only ? may wrap them
+        const bool nested = Repeats(atom);
+        int repeat = NewNode(RxNode::Kind::Repeat);
+        m_nodes[repeat].kids.push_back(atom);
+        switch (nested ? 2 : Pick(6)) {
+        case 0: m_nodes[repeat].min = 0; m_nodes[repeat].max = -1; break;
+        case 1: m_nodes[repeat].min = 1; m_nodes[repeat].max = -1; break;
+        case 2: m_nodes[repeat].min = 0; m_nodes[repeat].max = 1; break;
+        case 3: m_nodes[repeat].min = m_nodes[repeat].max = static_cast<int>(1 + Pick(3)); break;
+        case 4: m_nodes[repeat].min = static_cast<int>(Pick(3)); m_nodes[repeat].max = m_nodes[repeat].min + static_cast<int>(1 + Pick(2)); break;
+        default: m_nodes[repeat].min = static_cast<int>(Pick(3)); m_nodes[repeat].max = -1; break;
+        }
+        m_nodes[repeat].lazy = Chance(4);
+        return repeat;
+    }
+
+    bool Nullable(int node) const {
+        const RxNode& n = m_nodes[node];
+        switch (n.kind) {
+        case RxNode::Kind::Atom: return false;
+        case RxNode::Kind::Group: return Nullable(n.kids[0]);
+        case RxNode::Kind::Repeat: return n.min == 0 || Nullable(n.kids[0]);
+        case RxNode::Kind::Concat:
+            for (int kid : n.kids) if (!Nullable(kid)) return false;
+            return true;
+        case RxNode::Kind::Alternate:
+            for (int kid : n.kids) if (Nullable(kid)) return true;
+            return false;
+        default: return true;
+        }
+    }
+
+    bool Repeats(int node) const {
+        const RxNode& n = m_nodes[node];
+        if (n.kind == RxNode::Kind::Repeat && n.max != 1) return true;
+        for (int kid : n.kids) if (Repeats(kid)) return true;
+        return false;
+    }
+
+    std::mt19937& m_rng;
+    std::vector<RxNode> m_nodes;
+};
+
+// What std::wregex makes of a pattern list: the first pattern with a capture group that fully
+// matches, and its group 1 span ({0, 0} when the group did not take part).
+bool ReferenceMatch(const std::vector<std::wstring>& patterns, const std::wstring& line, PatternMatch& match) {
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        try {
+            std::wregex regex(patterns[i], std::regex::ECMAScript | std::regex::icase);
+            if (regex.mark_count() == 0) continue;
+            std::wsmatch result;
+            if (!std::regex_match(line, result, regex)) continue;
+            match.pattern = static_cast<int>(i);
+            match.captureBegin = result[1].matched ? static_cast<size_t>(result[1].first - line.begin()) : 0;
+            match.captureEnd = result[1].matched ? static_cast<size_t>(result[1].second - line.begin()) : 0;
+            return true;
+        }
+        catch (const std::regex_error&) {
+            continue;
+        }
+    }
+    return false;
+}
+
+std::string Printable(const std::wstring& text) {
+    std::string out;
+    for (wchar_t c : text) {
+        if (c >= 0x20 && c < 0x7F && c != L'"' && c != L'\\') {
+            out += static_cast<char>(c);
+        }
+        else {
+            char escape[12];
+            std::snprintf(escape, sizeof(escape), "\\u%04X", static_cast<unsigned>(c));
+            out += escape;
+        }
+    }
+    return out;
+}
+
+void PrintMatch(const char* who, bool found, const PatternMatch& match) {
+    if (found) std::printf("  %-9s pattern %d, capture [%zu, %zu)\n", who, match.pattern, match.captureBegin, match.captureEnd);
+    else std::printf("  %-9s no match\n", who);
+}
+
+// Compares PatternSet with the reference on one line; prints the first few disagreements.
+bool Agree(const PatternSet& set, const std::vector<std::wstring>& patterns, const std::wstring& line, int& reported) {
+    PatternMatch expected, actual;
+    const bool expectedFound = ReferenceMatch(patterns, line, expected);
+    const bool actualFound = set.Match(line, actual);
+    const bool anyFound = set.Matches(line);
+    const bool same = expectedFound == actualFound && expectedFound == anyFound &&
+        (!expectedFound || (expected.pattern == actual.pattern && expected.captureBegin == actual.captureBegin &&
+            expected.captureEnd == actual.captureEnd));
+    if (!same && reported++ < 10) {
+        std::printf("MISMATCH on line \"%s\"\n", Printable(line).c_str());
+        for (size_t i = 0; i < patterns.size(); ++i) std::printf("  pattern %zu: %s\n", i, Printable(patterns[i]).c_str());
+        PrintMatch("wregex", expectedFound, expected);
+        PrintMatch("Match", actualFound, actual);
+        std::printf("  Matches   %s\n", anyFound ? "true" : "false");
+    }
+    return same;
+}
+
+// Fixed cases: the documented divergences, where PatternSet follows the ECMAScript specification
+// and libstdc++ does not, then regressions the generator found.
+struct FixedCase {
+    const wchar_t* pattern;
+    const wchar_t* line;
+    bool matches;
+    size_t captureBegin;
+    size_t captureEnd;
+};
+
+const FixedCase kFixedCases[] = {
+    { L"^(\\w*)*\\.txt$", L"ab.txt", true, 0, 2 },     // An empty iteration does not overwrite the capture
+    { L"(a*)+b", L"aab", true, 0, 2 },
+    { L"(?:a*?)?(a*)", L"aa", true, 1, 2 },         // Nor does it count as the optional iteration
+    { L"(\\S+)\\s(\\S+)", L"a\u00A0b", true, 0, 1 },  // \s is ECMAScript WhiteSpace, not the C locale's
+    { L"(\\S+)\\s(\\S+)", L"a\uFEFFb", true, 0, 1 },
+    { L"(\\S+)\\s(\\S+)", L"a\u2028b", true, 0, 1 },
+    { L"(?:a?? ??| \\.)*?(\\W\\t{0,2})9", L"a .\t\t9", true, 2, 5 },   // Empty iteration of a lazy loop
+};
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    int cases = 5000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cases") == 0 && i + 1 < argc) cases = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else {
+            std::fprintf(stderr, "usage: pattern_set_test [--cases N] [--seed N]\n");
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    PatternGenerator generator(rng);
+    const size_t linesPerCase = 12;
+    size_t checked = 0, matched = 0, failed = 0;
+    int reported = 0;
+
+    for (int c = 0; c < cases; ++c) {
+        std::vector<std::wstring> patterns;
+        std::vector<std::wstring> lines;
+        const size_t count = 1 + generator.Pick(3);
+        for (size_t p = 0; p < count; ++p) {
+            int root = generator.Generate();
+            patterns.push_back(generator.Text(root));
+            for (size_t l = 0; l < linesPerCase / count; ++l) {
+                std::wstring line;
+                generator.Sample(root, line);
+                lines.push_back(line);
+            }
+        }
+        lines.push_back(L"");
+
+        // Mutated copies: one or two characters inserted, removed or replaced
+        const size_t sampled = lines.size();
+        for (size_t l = 0; l < sampled; ++l) {
+            std::wstring line = lines[l];
+            const size_t edits = 1 + generator.Pick(2);
+            for (size_t e = 0; e < edits; ++e) {
+                const wchar_t noise = kNoise[generator.Pick(sizeof(kNoise) / sizeof(wchar_t) - 1)];
+                const size_t at = generator.Pick(line.size() + 1);
+                switch (line.empty() ? 0 : generator.Pick(3)) {
+                case 0: line.insert(line.begin() + at, noise); break;
+                case 1: line.erase(std::min(at, line.size() - 1), 1); break;
+                default: line[std::min(at, line.size() - 1)] = noise; break;
+                }
+            }
+            lines.push_back(line);
+        }
+
+        const PatternSet set = PatternSet::Compile(patterns);
+        for (const auto& line : lines) {
+            PatternMatch match;
+            if (ReferenceMatch(patterns, line, match)) ++matched;
+            if (!Agree(set, patterns, line, reported)) ++failed;
+            ++checked;
+        }
+    }
+
+    size_t fixedFailed = 0;
+    for (const auto& fixed : kFixedCases) {
+        const PatternSet set = PatternSet::Compile({ fixed.pattern });
+        PatternMatch match;
+        const bool found = set.Match(fixed.line, match);
+        if (found != fixed.matches || (found && (match.captureBegin != fixed.captureBegin || match.captureEnd != fixed.captureEnd))) {
+            std::printf("FIXED CASE FAILED: %s on \"%s\"\n", Printable(fixed.pattern).c_str(), Printable(fixed.line).c_str());
+            PrintMatch("Match", found, match);
+            ++fixedFailed;
+        }
+    }
+
+    std::printf("%zu lines over %d pattern lists (seed %u), %zu matched: %zu disagreed with std::wregex; "
+        "%zu of %zu fixed cases failed\n", checked, cases, seed, matched, failed, fixedFailed,
+        sizeof(kFixedCases) / sizeof(kFixedCases[0]));
+    return failed == 0 && fixedFailed == 0 ? 0 : 1;
+}
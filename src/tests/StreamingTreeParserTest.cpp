@@ -0,0 +1,349 @@
+//================================================================================================//
+//                       Clipboard To File - Streaming tree parser test                           //
+//                                                                                                //
+//  Differential test: StreamingTreeParser against ParsePathListFormat and ParseEnhancedFormat.   //
+//  Each case generates a payload, parses it whole with the tree parser, then feeds it to the    //
+//  streaming parser several times at random chunk sizes. A recording sink rebuilds the entries   //
+//  and file contents from the sink calls, and both results must list the same paths, kinds and  //
+//  contents in the same order. Payloads mix lines split across chunks, '\r\n' endings, a last    //
+//  line without '\n', repeated and unclosed sections, unclosed "---START:" lines and, in some    //
+//  cases, content lines longer than kMaxLineChars. The generator keeps to the layout the         //
+//  streaming parser documents: every file a section names is listed before the first section.   //
+//                                                                                                //
+//  Usage: streaming_tree_parser_test [--cases N] [--seed N]                                      //
+//================================================================================================//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "ClipboardEngine.h"
+#include "LineIndex.h"
+#include "StreamingTreeParser.h"
+
+
+namespace {
+
+// One entry of a parsed structure, by its full path so the two numberings need not agree.
+struct ParsedEntry {
+    std::wstring path;
+    bool isDirectory;
+    std::wstring content;
+
+    bool operator==(const ParsedEntry& other) const {
+        return path == other.path && isDirectory == other.isDirectory && content == other.content;
+    }
+};
+
+// Rebuilds entries and contents from the sink calls, and notes calls made out of order.
+class RecordingSink : public TreeOperationSink {
+public:
+    RecordingSink() : m_paths(1) {}
+
+    bool AddEntry(uint32_t parent, std::wstring_view name, bool isDirectory) override {
+        if (parent >= m_paths.size() || (parent != 0 && !m_entries[parent - 1].isDirectory)) Fail("AddEntry under a file");
+        if (parent >= m_paths.size()) return false;
+        m_paths.push_back(m_paths[parent] + L"/" + std::wstring(name));
+        m_entries.push_back({ m_paths.back(), isDirectory, std::wstring() });
+        return true;
+    }
+
+    bool BeginContent(const std::vector<uint32_t>& files) override {
+        if (m_open) Fail("BeginContent inside a section");
+        for (uint32_t file : files) {
+            if (file == 0 || file > m_entries.size() || m_entries[file - 1].isDirectory) Fail("BeginContent for a non-file");
+        }
+        m_open = true;
+        m_files = files;
+        m_buffer.clear();
+        return true;
+    }
+
+    bool AppendContent(std::wstring_view text) override {
+        if (!m_open) Fail("AppendContent outside a section");
+        m_buffer.append(text);
+        return true;
+    }
+
+    bool EndContent(bool complete) override {
+        if (!m_open) Fail("EndContent outside a section");
+        m_open = false;
+        if (!complete) return true;
+        for (uint32_t file : m_files) {
+            if (file != 0 && file <= m_entries.size()) m_entries[file - 1].content = m_buffer;
+        }
+        return true;
+    }
+
+    const std::vector<ParsedEntry>& Entries() const { return m_entries; }
+    const char* Error() const { return m_open && !m_error ? "section left open" : m_error; }
+
+private:
+    void Fail(const char* error) {
+        if (!m_error) m_error = error;
+    }
+
+    std::vector<std::wstring> m_paths;      // By entry number; 0 is the target directory
+    std::vector<ParsedEntry> m_entries;
+    std::vector<uint32_t> m_files;
+    std::wstring m_buffer;
+    bool m_open = false;
+    const char* m_error = nullptr;
+};
+
+// The tree parser's result as the streaming parser would hand it on. Nodes below a file (a path
+// list naming it as a directory later) are never created, so they are left out.
+std::vector<ParsedEntry> TreeEntries(const DirectoryTree& tree) {
+    std::vector<ParsedEntry> entries;
+    std::vector<std::wstring> paths(tree.Size());
+    std::vector<bool> created(tree.Size(), true);
+    for (uint32_t n = DirectoryTree::Root() + 1; n < tree.Size(); ++n) {
+        const TreeNode& node = tree.Node(n);
+        const uint32_t parent = node.parent;
+        created[n] = parent == DirectoryTree::Root() || (created[parent] && tree.Node(parent).isDirectory);
+        if (!created[n]) continue;
+        paths[n] = paths[parent] + L"/" + std::wstring(node.name);
+        entries.push_back({ paths[n], node.isDirectory, std::wstring(node.content) });
+    }
+    return entries;
+}
+
+//------------------------------------------------------------------------------------------------//
+//                                   PAYLOAD GENERATION                                           //
+//------------------------------------------------------------------------------------------------//
+const wchar_t* const kPathNames[] = {
+    L"src", L"lib", L"a", L"b.txt", L"c.cpp", L".git", L"README", L"x.y.z", L"main.py", L"docs",
+};
+
+const wchar_t* const kFileNames[] = {
+    L"main.cpp", L"util.h", L"README.md", L"a.txt", L"b.txt", L"Makefile", L"data.json",
+};
+
+// Content characters: no capitals, so no line spells a marker by accident.
+const wchar_t kContentChars[] = L"abcdefxyz019 -:_./#{}()\t";
+
+struct PayloadStats {
+    size_t overlong = 0;
+    size_t unclosed = 0;
+    size_t repeated = 0;
+    size_t openStarts = 0;
+};
+
+class PayloadGenerator {
+public:
+    explicit PayloadGenerator(std::mt19937& rng) : m_rng(rng) {}
+
+    std::wstring PathList() {
+        std::wstring text;
+        const size_t lines = 1 + Pick(40);
+        for (size_t l = 0; l < lines; ++l) {
+            if (Chance(8)) { EndLine(text); continue; }
+            if (Chance(6)) text += Chance(2) ? L"  " : L"\t";
+            const size_t components = 1 + Pick(4);
+            for (size_t c = 0; c < components; ++c) {
+                if (c > 0) text += Chance(4) ? L'\\' : L'/';
+                text += kPathNames[Pick(sizeof(kPathNames) / sizeof(kPathNames[0]))];
+            }
+            if (Chance(5)) text += L'/';
+            if (Chance(8)) text += L" \t";
+            EndLine(text);
+        }
+        return text;
+    }
+
+    // The structure (files named from kFileNames), then sections with late structure lines
+    // between them that use names no section asks for.
+    std::wstring Enhanced(bool overlong, PayloadStats& stats) {
+        std::wstring text;
+        const size_t entries = Pick(30);
+        int depth = 0;
+        for (size_t e = 0; e < entries; ++e) {
+            depth = static_cast<int>(Pick(depth + 2));
+            StructureLine(text, depth, kFileNames[Pick(sizeof(kFileNames) / sizeof(kFileNames[0]))]);
+        }
+
+        std::vector<std::wstring> named;
+        const size_t sections = Pick(6) + (overlong ? 1 : 0);
+        size_t overlongAt = overlong ? Pick(sections) : sections;
+        for (size_t s = 0; s < sections; ++s) {
+            std::wstring name = Chance(6) ? L"unlisted.txt" : kFileNames[Pick(sizeof(kFileNames) / sizeof(kFileNames[0]))];
+            if (!named.empty() && Chance(4)) name = named[Pick(named.size())];
+            if (std::find(named.begin(), named.end(), name) != named.end()) stats.repeated++;
+            named.push_back(name);
+
+            text += Chance(4) ? L"  ---START: " : L"---START:";
+            text += name + L" ---";
+            EndLine(text);
+            const size_t lines = Pick(6);
+            for (size_t l = 0; l < lines; ++l) {
+                if (Chance(5)) { EndLine(text); continue; }
+                if (Chance(10)) {
+                    text += L"---START: no closing dashes";
+                    stats.openStarts++;
+                    EndLine(text);
+                    continue;
+                }
+                ContentLine(text, Pick(60));
+                EndLine(text);
+            }
+            if (s == overlongAt) {
+                ContentLine(text, kMaxLineChars - 2 + Pick(2000));
+                EndLine(text);
+                stats.overlong++;
+            }
+
+            if (Chance(5)) {
+                stats.unclosed++;
+                continue;
+            }
+            text += L"---END: " + name + L" ---";
+            EndLine(text);
+            for (size_t late = Pick(3); late-- > 0;) StructureLine(text, static_cast<int>(Pick(2)), L"late.log");
+        }
+        if (Chance(4)) {
+            text += L"---START: outside";
+            stats.openStarts++;
+            EndLine(text);
+        }
+        if (!text.empty() && text.back() == L'\n' && Chance(4)) {
+            text.pop_back();     // The last line has no '\n'
+            if (!text.empty() && text.back() == L'\r') text.pop_back();
+        }
+        return text;
+    }
+
+    // Cuts text into chunks of random length; small chunks split most lines.
+    std::vector<std::wstring_view> Chunks(std::wstring_view text) {
+        std::vector<std::wstring_view> chunks;
+        const size_t scale = Chance(3) ? 8 : Chance(2) ? 256 : 1 << 16;
+        for (size_t pos = 0; pos < text.size();) {
+            const size_t size = std::min(text.size() - pos, 1 + Pick(scale));
+            chunks.push_back(text.substr(pos, size));
+            pos += size;
+        }
+        if (Chance(8)) chunks.insert(chunks.begin() + Pick(chunks.size() + 1), std::wstring_view());
+        return chunks;
+    }
+
+    bool Chance(size_t oneIn) { return Pick(oneIn) == 0; }
+    size_t Pick(size_t count) { return std::uniform_int_distribution<size_t>(0, count - 1)(m_rng); }
+
+private:
+    void EndLine(std::wstring& text) { text += Chance(6) ? L"\r\n" : L"\n"; }
+
+    void StructureLine(std::wstring& text, int depth, const std::wstring& file) {
+        text.append(static_cast<size_t>(depth) * 2, L' ');
+        if (Chance(3)) text += L"dir" + std::to_wstring(Pick(4)) + L"/";
+        else text += file;
+        EndLine(text);
+    }
+
+    void ContentLine(std::wstring& text, size_t length) {
+        for (size_t i = 0; i < length; ++i) text += kContentChars[Pick(sizeof(kContentChars) / sizeof(kContentChars[0]) - 1)];
+    }
+
+    std::mt19937& m_rng;
+};
+
+//------------------------------------------------------------------------------------------------//
+//                                   COMPARISON                                                   //
+//------------------------------------------------------------------------------------------------//
+std::string Printable(std::wstring_view text, size_t limit = 60) {
+    std::string out;
+    for (size_t i = 0; i < text.size() && i < limit; ++i) {
+        const wchar_t c = text[i];
+        if (c >= 0x20 && c < 0x7F && c != L'\\') out += static_cast<char>(c);
+        else if (c == L'\n') out += "\\n";
+        else if (c == L'\r') out += "\\r";
+        else if (c == L'\t') out += "\\t";
+        else out += "\\?";
+    }
+    if (text.size() > limit) out += "... (" + std::to_string(text.size()) + " chars)";
+    return out;
+}
+
+void PrintEntry(const char* who, const ParsedEntry* entry) {
+    if (!entry) {
+        std::printf("  %-9s (none)\n", who);
+        return;
+    }
+    std::printf("  %-9s %s%s \"%s\"\n", who, Printable(entry->path).c_str(), entry->isDirectory ? "/" : "",
+        Printable(entry->content).c_str());
+}
+
+// Streams text through the parser in the given chunks; true when the sink saw what the tree
+// parser produced.
+bool Agree(TreeFormat format, std::wstring_view text, const std::vector<std::wstring_view>& chunks,
+    const std::vector<ParsedEntry>& expected, int& reported) {
+    RecordingSink sink;
+    StreamingTreeParser parser(format, sink);
+    bool ok = true;
+    for (auto chunk : chunks) ok = ok && parser.Feed(chunk);
+    ok = ok && parser.Finish();
+
+    const auto& actual = sink.Entries();
+    int dirs = 0, files = 0;
+    for (const auto& entry : actual) (entry.isDirectory ? dirs : files)++;
+    size_t differ = 0;
+    while (differ < expected.size() && differ < actual.size() && expected[differ] == actual[differ]) ++differ;
+
+    const char* error = !ok ? "parse stopped" : sink.Error();
+    const bool same = !error && differ == expected.size() && differ == actual.size() &&
+        parser.DirectoryCount() == dirs && parser.FileCount() == files;
+    if (!same && reported++ < 10) {
+        std::printf("MISMATCH (%s, %zu chars in %zu chunks): %s\n", format == TreeFormat::Enhanced ? "enhanced" : "path list",
+            text.size(), chunks.size(), error ? error : "entries differ");
+        std::printf("  payload   \"%s\"\n", Printable(text, 400).c_str());
+        std::printf("  entries   %zu expected, %zu streamed, first difference at %zu\n", expected.size(), actual.size(), differ);
+        PrintEntry("tree", differ < expected.size() ? &expected[differ] : nullptr);
+        PrintEntry("stream", differ < actual.size() ? &actual[differ] : nullptr);
+    }
+    return same;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    int cases = 3000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cases") == 0 && i + 1 < argc) cases = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else {
+            std::fprintf(stderr, "usage: streaming_tree_parser_test [--cases N] [--seed N]\n");
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    PayloadGenerator generator(rng);
+    PayloadStats stats;
+    const size_t chunkingsPerCase = 4;
+    size_t checked = 0, failed = 0;
+    int reported = 0;
+
+    for (int c = 0; c < cases; ++c) {
+        const bool enhanced = c % 2 == 1;
+        const bool overlong = enhanced && c % 200 == 1;
+        const TreeFormat format = enhanced ? TreeFormat::Enhanced : TreeFormat::PathList;
+        const std::wstring text = enhanced ? generator.Enhanced(overlong, stats) : generator.PathList();
+
+        const LineIndex lines(text);
+        const DirectoryTree tree = enhanced ? ParseEnhancedFormat(lines) : ParsePathListFormat(lines);
+        const std::vector<ParsedEntry> expected = TreeEntries(tree);
+
+        for (size_t k = 0; k < chunkingsPerCase; ++k) {
+            std::vector<std::wstring_view> chunks = k == 0 ? std::vector<std::wstring_view>{ text } : generator.Chunks(text);
+            if (!Agree(format, text, chunks, expected, reported)) ++failed;
+            ++checked;
+        }
+    }
+
+    std::printf("%zu parses of %d payloads (seed %u; %zu overlong lines, %zu repeated and %zu unclosed sections, "
+        "%zu unclosed START lines): %zu disagreed with the tree parsers\n", checked, cases, seed, stats.overlong,
+        stats.repeated, stats.unclosed, stats.openStarts, failed);
+    return failed == 0 ? 0 : 1;
+}